@@ -22,6 +22,8 @@
 #include "config.h"
 #endif
 
+#include <daq_common.h>
+
 #include "codecs/codec_module.h"
 #include "framework/codec.h"
 #include "log/log.h"
@@ -54,6 +56,8 @@ const PegInfo pegs[]
 {
     { "bad_tcp4_checksum", "nonzero tcp over ip checksums" },
     { "bad_tcp6_checksum", "nonzero tcp over ipv6 checksums" },
+    { "offloaded_checksums", "tcp checksums already validated by the nic" },
+    { "computed_checksums", "tcp checksums computed" },
     { nullptr, nullptr }
 };
 
@@ -61,6 +65,8 @@ struct Stats
 {
     PegCount bad_ip4_cksum;
     PegCount bad_ip6_cksum;
+    PegCount offloaded_cksum;
+    PegCount computed_cksum;
 };
 
 static THREAD_LOCAL Stats stats;
@@ -169,10 +175,21 @@ bool TcpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& snort)
 
     /* Checksum code moved in front of the other decoder alerts.
        If it's a bad checksum (maybe due to encrypted ESP traffic), the other
-       alerts could be false positives. */
-    if ( SnortConfig::tcp_checksums() )
+       alerts could be false positives. The DAQ flag only covers the outer
+       tcp header; tunneled ones are always computed. */
+    bool check_cksum = SnortConfig::tcp_checksums();
+
+    if ( check_cksum and (raw.pkth->flags & DAQ_PKT_FLAG_HW_TCP_CS_GOOD) and
+        codec.ip_layer_cnt == 1 )
+    {
+        stats.offloaded_cksum++;
+        check_cksum = false;
+    }
+
+    if ( check_cksum )
     {
         uint16_t csum;
+        stats.computed_cksum++;
         PegCount* bad_cksum_cnt;
 
         if (snort.ip_api.is_ip4())
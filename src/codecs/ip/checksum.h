@@ -21,6 +21,12 @@
 #define CODECS_CHECKSUM_H
 
 #include <cstddef>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define CHECKSUM_SIMD
+#endif
 
 #include <protocols/protocol_ids.h>
 
@@ -87,84 +93,100 @@ struct Psuedoheader6Union
     };
 };
 
-inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+// The sum is taken over 32 bit words, which is the same as the sum of the
+// 16 bit words modulo 0xffff.  Whole 32 byte blocks are summed with SSE2 or
+// AVX2 on x86-64; the rest a word at a time.
+#ifdef CHECKSUM_SIMD
+__attribute__((target("avx2")))
+inline uint64_t sum_avx2(const uint8_t* buf, std::size_t len)
 {
-    const uint16_t* sp = buf;
-    std::size_t n, sn;
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero, acc1 = zero;
 
-    if (len > 1 )
+    for ( std::size_t i = 0; i < len; i += 32 )
     {
-        sn = ((len / 2) & 0xF);  // == len/2 % 16
-        n = (((len / 2) + 15) / 16);   // ceiling of (len / 2) / 16
-
-        switch (sn)
-        {
-        case 0:
-            sn = 16;
-            cksum += sp[15];
-        case 15:
-            cksum += sp[14];
-        case 14:
-            cksum += sp[13];
-        case 13:
-            cksum += sp[12];
-        case 12:
-            cksum += sp[11];
-        case 11:
-            cksum += sp[10];
-        case 10:
-            cksum += sp[9];
-        case 9:
-            cksum += sp[8];
-        case 8:
-            cksum  += sp[7];
-        case 7:
-            cksum += sp[6];
-        case 6:
-            cksum += sp[5];
-        case 5:
-            cksum += sp[4];
-        case 4:
-            cksum += sp[3];
-        case 3:
-            cksum += sp[2];
-        case 2:
-            cksum += sp[1];
-        case 1:
-            cksum += sp[0];
-        }
-        sp += sn;
-
-        /* XXX - unroll loop using Duff's device. */
-        while (--n > 0)
-        {
-            cksum += sp[0];
-            cksum += sp[1];
-            cksum += sp[2];
-            cksum += sp[3];
-            cksum += sp[4];
-            cksum += sp[5];
-            cksum += sp[6];
-            cksum += sp[7];
-            cksum += sp[8];
-            cksum += sp[9];
-            cksum += sp[10];
-            cksum += sp[11];
-            cksum += sp[12];
-            cksum += sp[13];
-            cksum += sp[14];
-            cksum += sp[15];
-            sp += 16;
-        }
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(buf + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v, zero));
     }
+    acc0 = _mm256_add_epi64(acc0, acc1);
+
+    const __m128i acc = _mm_add_epi64(
+        _mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+
+    return (uint64_t)_mm_cvtsi128_si64(acc) + (uint64_t)_mm_extract_epi64(acc, 1);
+}
+
+inline uint64_t sum_sse2(const uint8_t* buf, std::size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero, acc1 = zero;
+
+    for ( std::size_t i = 0; i < len; i += 16 )
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(buf + i));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v, zero));
+    }
+    acc0 = _mm_add_epi64(acc0, acc1);
+
+    return (uint64_t)_mm_cvtsi128_si64(acc0) +
+        (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc0, acc0));
+}
+#endif
+
+inline uint64_t sum_words(const uint8_t* buf, std::size_t len, uint64_t sum)
+{
+#ifdef CHECKSUM_SIMD
+    if ( len >= 64 )
+    {
+        const std::size_t n = len & ~(std::size_t)31;
 
-    if (len & 1)
-        cksum += (*(unsigned char*)sp);
+        if ( __builtin_cpu_supports("avx2") )
+            sum += sum_avx2(buf, n);
+        else
+            sum += sum_sse2(buf, n);
+
+        buf += n;
+        len -= n;
+    }
+#endif
+
+    while ( len >= 4 )
+    {
+        uint32_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += w;
+        buf += 4;
+        len -= 4;
+    }
+
+    if ( len >= 2 )
+    {
+        uint16_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += w;
+        buf += 2;
+        len -= 2;
+    }
+
+    if ( len )
+        sum += *buf;
+
+    return sum;
+}
+
+inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+{
+    uint64_t sum = sum_words((const uint8_t*)buf, len, cksum);
 
-    cksum  = (cksum >> 16) + (cksum & 0x0000ffff);
-    cksum += (cksum >> 16);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
 
-    return (uint16_t)(~cksum);
+    return (uint16_t)(~sum);
 }
 
 inline void add_ipv4_pseudoheader(const Pseudoheader* const ph4,
@@ -27,6 +27,8 @@
 #include "main/thread.h"
 #include "utils/util.h"
 
+#include "inflate_pool.h"
+
 #ifdef UNIT_TEST
 #include "catch/catch.hpp"
 #endif
@@ -907,24 +909,17 @@ static fd_status_t Init_Stream(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
-
-        memset( (char*)z_s, 0, sizeof(z_stream));
-
-        z_s->zalloc = (alloc_func)NULL;
-        z_s->zfree = (free_func)NULL;
-        SYNC_IN(z_s)
+        z_stream* z_s = InflatePool::get(47);
 
-        z_ret = inflateInit2(z_s, 47);
-
-        if ( z_ret != Z_OK )
+        if ( z_s == NULL )
         {
             File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
             return( File_Decomp_Error );
         }
 
+        StPtr->PDF_Decomp_State.Deflate.StreamDeflate = z_s;
+        SYNC_IN(z_s)
+
         break;
     }
     default:
@@ -950,7 +945,7 @@ static fd_status_t Decomp_Stream(fd_session_p_t SessionPtr)
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
         int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        z_stream* z_s = StPtr->PDF_Decomp_State.Deflate.StreamDeflate;
 
         SYNC_IN(z_s)
 
@@ -982,6 +977,15 @@ static fd_status_t Decomp_Stream(fd_session_p_t SessionPtr)
    and return the state of the parser. */
 static fd_status_t Close_Stream(fd_session_p_t SessionPtr)
 {
+    fd_PDF_p_t StPtr = SessionPtr->PDF;
+
+    /* Release the decompression engine for the next stream */
+    if ( StPtr->Decomp_Type == FILE_COMPRESSION_TYPE_DEFLATE )
+    {
+        InflatePool::put(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        StPtr->PDF_Decomp_State.Deflate.StreamDeflate = NULL;
+    }
+
     /* Put the parser state back where it was interrupted */
     if ( Pop_State(&(SessionPtr->PDF->Parse) ) == File_Decomp_Error )
         return( File_Decomp_Error );
@@ -1009,17 +1013,8 @@ fd_status_t File_Decomp_End_PDF(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
-
-        z_ret = inflateEnd(z_s);
-
-        if ( z_ret != Z_OK )
-        {
-            File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
-            return( File_Decomp_Error );
-        }
-
+        InflatePool::put(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        StPtr->PDF_Decomp_State.Deflate.StreamDeflate = NULL;
         break;
     }
     default:
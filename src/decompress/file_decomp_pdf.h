@@ -64,7 +64,7 @@ struct fd_PDF_Parse_t
 
 struct fd_PDF_Deflate_t
 {
-    z_stream StreamDeflate;
+    z_stream* StreamDeflate;   /* from the InflatePool while a stream is open */
 };
 
 struct fd_PDF_t
@@ -62,7 +62,7 @@ enum fd_SWF_States
 
 struct fd_SWF_t
 {
-    z_stream StreamZLIB;
+    z_stream* StreamZLIB;      /* from the InflatePool */
 #ifdef HAVE_LZMA
     lzma_stream StreamLZMA;
 #endif
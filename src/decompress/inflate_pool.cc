@@ -0,0 +1,210 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// inflate_pool.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "inflate_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "main/thread.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+static THREAD_LOCAL z_stream* free_streams[InflatePool::MAX_FREE];
+static THREAD_LOCAL unsigned num_free = 0;
+static THREAD_LOCAL bool closed = false;
+static THREAD_LOCAL InflatePoolStats stats;
+
+// each zlib block is prefixed with its size so it can be uncharged
+static const size_t zhdr = 16;
+
+static voidpf zalloc_counted(voidpf, uInt items, uInt size)
+{
+    size_t len = size_t(items) * size;
+    uint8_t* p = (uint8_t*)malloc(len + zhdr);
+
+    if ( !p )
+        return Z_NULL;
+
+    *(size_t*)p = len;
+    stats.memory += len;
+    return p + zhdr;
+}
+
+static void zfree_counted(voidpf, voidpf address)
+{
+    uint8_t* p = (uint8_t*)address - zhdr;
+    stats.memory -= *(size_t*)p;
+    free(p);
+}
+
+static z_stream* new_stream(int window_bits)
+{
+    z_stream* zs = new z_stream;
+    memset(zs, 0, sizeof(*zs));
+
+    zs->zalloc = zalloc_counted;
+    zs->zfree = zfree_counted;
+    zs->next_in = Z_NULL;
+    zs->avail_in = 0;
+
+    if ( inflateInit2(zs, window_bits) != Z_OK )
+    {
+        delete zs;
+        return nullptr;
+    }
+    stats.memory += sizeof(*zs);
+    return zs;
+}
+
+static void end_stream(z_stream* zs)
+{
+    inflateEnd(zs);
+    stats.memory -= sizeof(*zs);
+    delete zs;
+}
+
+z_stream* InflatePool::get(int window_bits)
+{
+    while ( num_free )
+    {
+        z_stream* zs = free_streams[--num_free];
+
+        // a failed reset leaves the stream unusable but still allocated
+        if ( inflateReset2(zs, window_bits) == Z_OK )
+        {
+            zs->next_in = Z_NULL;
+            zs->avail_in = 0;
+            stats.reuses++;
+            return zs;
+        }
+        end_stream(zs);
+    }
+
+    return new_stream(window_bits);
+}
+
+void InflatePool::put(z_stream* zs)
+{
+    if ( !zs )
+        return;
+
+    if ( closed or num_free == MAX_FREE )
+        end_stream(zs);
+    else
+        free_streams[num_free++] = zs;
+}
+
+void InflatePool::tterm()
+{
+    while ( num_free )
+        end_stream(free_streams[--num_free]);
+
+    closed = true;
+}
+
+const InflatePoolStats& InflatePool::get_stats()
+{ return stats; }
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static bool inflate_all(z_stream* zs, const uint8_t* in, unsigned in_len, const char* expect)
+{
+    uint8_t out[64];
+
+    zs->next_in = (Bytef*)in;
+    zs->avail_in = in_len;
+    zs->next_out = out;
+    zs->avail_out = sizeof(out);
+
+    if ( inflate(zs, Z_SYNC_FLUSH) != Z_STREAM_END )
+        return false;
+
+    return (sizeof(out) - zs->avail_out == strlen(expect)) and
+        !memcmp(out, expect, strlen(expect));
+}
+
+TEST_CASE("inflate pool reuse", "[InflatePool]")
+{
+    const char* text = "snort snort snort snort";
+    uint8_t zipped[64];
+
+    z_stream def;
+    memset(&def, 0, sizeof(def));
+    REQUIRE(deflateInit2(&def, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8,
+        Z_DEFAULT_STRATEGY) == Z_OK);
+
+    def.next_in = (Bytef*)text;
+    def.avail_in = strlen(text);
+    def.next_out = zipped;
+    def.avail_out = sizeof(zipped);
+    REQUIRE(deflate(&def, Z_FINISH) == Z_STREAM_END);
+    unsigned zipped_len = sizeof(zipped) - def.avail_out;
+    deflateEnd(&def);
+
+    PegCount reuses = InflatePool::get_stats().reuses;
+    PegCount memory = InflatePool::get_stats().memory;
+
+    z_stream* zs = InflatePool::get(31);
+    REQUIRE(zs);
+    CHECK(inflate_all(zs, zipped, zipped_len, text));
+
+    // the inflate state is charged while the stream is held
+    PegCount held = InflatePool::get_stats().memory;
+    CHECK(held > memory + sizeof(z_stream));
+
+    // the next user gets the same stream reset
+    InflatePool::put(zs);
+
+    z_stream* again = InflatePool::get(31);
+    CHECK(again == zs);
+    CHECK(InflatePool::get_stats().reuses == reuses + 1);
+    CHECK(InflatePool::get_stats().memory == held);
+    CHECK(inflate_all(again, zipped, zipped_len, text));
+
+    // the reset applies the new window bits so gzip data is now rejected
+    InflatePool::put(again);
+    zs = InflatePool::get(15);
+    uint8_t out[64];
+    zs->next_in = zipped;
+    zs->avail_in = zipped_len;
+    zs->next_out = out;
+    zs->avail_out = sizeof(out);
+    CHECK(inflate(zs, Z_SYNC_FLUSH) == Z_DATA_ERROR);
+    InflatePool::put(zs);
+
+    // idle streams stay charged until they are ended
+    CHECK(InflatePool::get_stats().memory > memory);
+
+    InflatePool::tterm();
+    CHECK(InflatePool::get_stats().memory == memory);
+}
+
+#endif
+
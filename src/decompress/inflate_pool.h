@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// inflate_pool.h
+
+#ifndef INFLATE_POOL_H
+#define INFLATE_POOL_H
+
+// Per thread cache of zlib inflate streams.  inflateInit2() allocates the
+// inflate state and inflateEnd() frees it along with the window, so doing
+// both for every compressed message or file is a significant fixed cost.
+// Streams returned to the pool keep their allocations and are made ready
+// for the next user with inflateReset2().  At most MAX_FREE idle streams
+// are kept per thread; extras are ended.
+//
+// zlib allocates through the pool so the memory held by each thread's
+// streams, in use or idle, can be charged to the inspectors using them.
+//
+// Any zlib compatible library found at build time (e.g. zlib-ng in
+// compat mode) works here unchanged.
+
+#include <zlib.h>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+
+struct InflatePoolStats
+{
+    PegCount reuses;  // gets satisfied by an idle stream
+    PegCount memory;  // bytes held by this thread's streams and their zlib state
+};
+
+class SO_PUBLIC InflatePool
+{
+public:
+    // returns a stream ready to inflate with the given window bits or
+    // nullptr if zlib could not be initialized
+    static z_stream* get(int window_bits);
+
+    // return a stream from get(); it need not be ended
+    static void put(z_stream*);
+
+    // free the calling thread's idle streams; streams put after this are
+    // ended immediately
+    static void tterm();
+
+    // the calling thread's counts
+    static const InflatePoolStats& get_stats();
+
+    static const unsigned MAX_FREE = 16;
+};
+
+#endif
+
@@ -31,6 +31,7 @@
 #include "detect.h"
 
 #include "events/event.h"
+#include "latency/flow_cpu.h"
 #include "latency/packet_latency.h"
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
@@ -78,6 +79,7 @@ void snort_inspect(Packet* p)
     bool inspected = false;
     {
         PacketLatency::Context pkt_latency_ctx { p };
+        FlowCpu::Context flow_cpu_ctx { p };
 
         // If the packet has errors, we won't analyze it.
         if ( p->ptrs.decode_flags & DECODE_ERR_FLAGS )
@@ -550,6 +550,12 @@ int detection_option_node_evaluate(
 
         {
             RulePause pause(profile);
+
+            // children are timed separately so tell them what this evaluation
+            // of the path has cost so far
+            const hr_duration path_elapsed = eval_data->path_elapsed;
+            eval_data->path_elapsed += profile.get();
+
             // Passed, check the children.
             if ( node->num_children )
             {
@@ -625,6 +631,7 @@ int detection_option_node_evaluate(
 
                     if ( PacketLatency::fastpath() )
                     {
+                        eval_data->path_elapsed = path_elapsed;
                         state.last_check.result = result;
                         return result;
                     }
@@ -645,6 +652,7 @@ int detection_option_node_evaluate(
                 //for (i = 0; i < node->num_children; i++)
                 //    node->children[i]->result;
             }
+            eval_data->path_elapsed = path_elapsed;
         }
 
         if ( rval == DETECTION_OPTION_NO_ALERT )
@@ -689,6 +697,14 @@ int detection_option_node_evaluate(
 
     state.last_check.result = result;
 
+    if ( node->option_type == RULE_OPTION_TYPE_LEAF_NODE )
+    {
+        // one sample per evaluation that reaches the rule, covering its path
+        profile.pause();
+        OptTreeNode* otn = (OptTreeNode*)node->option_data;
+        otn->state[get_instance_id()].hist.update(eval_data->path_elapsed + profile.get());
+    }
+
     profile.stop(result != DETECTION_OPTION_NO_MATCH);
 
     return result;
@@ -107,6 +107,9 @@ struct detection_option_eval_data_t
     Packet* p;
     char flowbit_failed;
     char flowbit_noalert;
+
+    // time spent on the option path above the node being evaluated
+    hr_duration path_elapsed = 0_ticks;
 };
 
 // return existing data or add given and return nullptr
@@ -382,6 +382,9 @@ static int fpFinishPortGroupRule(
 
     pg->mpse[pmd->pm_type]->add_pattern(sc, (uint8_t*)pattern, pattern_length, desc, pmx);
 
+    if ( (unsigned)pattern_length > pg->max_len[pmd->pm_type] )
+        pg->max_len[pmd->pm_type] = pattern_length;
+
     return 0;
 }
 
@@ -458,6 +461,9 @@ static void fpAddAlternatePatterns(SnortConfig* sc, PortGroup* pg,
 
     pg->mpse[pmd->pm_type]->add_pattern(
         sc, (uint8_t*)pmd->pattern_buf, pmd->pattern_size, desc, pmx);
+
+    if ( pmd->pattern_size > pg->max_len[pmd->pm_type] )
+        pg->max_len[pmd->pm_type] = pmd->pattern_size;
 }
 
 static int fpAddPortGroupRule(
@@ -66,8 +66,10 @@
 #include "detection_util.h"
 #include "fp_config.h"
 #include "fp_create.h"
+#include "ips_context.h"
 #include "pattern_match_data.h"
 #include "pcrm.h"
+#include "regex_offload.h"
 #include "service_map.h"
 
 THREAD_LOCAL ProfileStats rulePerfStats;
@@ -77,23 +79,6 @@ THREAD_LOCAL ProfileStats ruleNFPEvalPerfStats;
 
 THREAD_LOCAL uint64_t rule_eval_pkt_count = 0;
 
-static THREAD_LOCAL OTNX_MATCH_DATA t_omd;
-
-/* initialize the global OTNX_MATCH_DATA variable */
-void otnx_match_data_init(int num_rule_types)
-{
-    t_omd.iMatchInfoArraySize = num_rule_types;
-    t_omd.matchInfo = (MATCH_INFO*)snort_calloc(num_rule_types, sizeof(MATCH_INFO));
-}
-
-void otnx_match_data_term()
-{
-    if ( t_omd.matchInfo )
-        snort_free(t_omd.matchInfo);
-
-    t_omd.matchInfo = nullptr;
-}
-
 // Initialize the OTNX_MATCH_DATA structure.  We do this for
 // every packet so this only sets the necessary counters to
 // zero which saves us time.
@@ -225,6 +210,26 @@ int fpLogEvent(const RuleTreeNode* rtn, const OptTreeNode* otn, Packet* p)
     return 0;
 }
 
+// true if a should be logged before b in the configured event order
+static inline bool fpEventBefore(const OptTreeNode* a, const OptTreeNode* b, int order)
+{
+    if ( order == SNORT_EVENTQ_CONTENT_LEN )
+    {
+        // FIXIT-L pattern length is not a valid event sort criterion for
+        // non-literals
+        if ( a->longestPatternLen != b->longestPatternLen )
+            return a->longestPatternLen > b->longestPatternLen;
+
+        // This improves stability of repeated tests
+        return a->sigInfo.sid > b->sigInfo.sid;
+    }
+
+    if ( a->sigInfo.priority != b->sigInfo.priority )
+        return a->sigInfo.priority < b->sigInfo.priority;
+
+    return a->sigInfo.sid < b->sigInfo.sid;
+}
+
 /*
 **
 **  NAME
@@ -236,6 +241,11 @@ int fpLogEvent(const RuleTreeNode* rtn, const OptTreeNode* otn, Packet* p)
 **    one.  This function also allows us to change the order of alert,
 **    pass, and log signatures by caching them for decision later.
 **
+**    Each queue is kept in event order as matches are added.  Once a
+**    queue holds max_queue_events matches, a new match replaces the
+**    last one if it comes before it, so the queue always holds the
+**    best matches seen so far.
+**
 **    IMPORTANT NOTE:
 **    fpAddMatch must be called even when the queue has been maxed
 **    out.  This is because there are three different queues (alert,
@@ -265,30 +275,52 @@ int fpAddMatch(OTNX_MATCH_DATA* omd_local, int /*pLen*/, const OptTreeNode* otn)
     }
     MATCH_INFO* pmi = &omd_local->matchInfo[evalIndex];
 
+    // don't store the same otn again
+    for ( int i=0; i< pmi->iMatchCount; i++ )
+    {
+        if ( pmi->MatchArray[ i  ] == otn )
+            return 0;
+    }
+
+    unsigned max_events = snort_conf->fast_pattern_config->get_max_queue_events();
+    int max = (max_events < MAX_EVENT_MATCH) ? (int)max_events : MAX_EVENT_MATCH;
+    int order = snort_conf->event_queue_config->order;
+    int pos = pmi->iMatchCount;
+    int ret = 0;
+
+    // nothing is queued when max_queue_events is 0
+    if ( !max )
+    {
+        pc.match_limit++;
+        return 1;
+    }
+
     /*
     **  If we hit the max number of unique events for any rule type alert,
-    **  log or pass, then we don't add it to the list.
+    **  log or pass, then we only keep this one if it goes before the last.
     */
-    if ( pmi->iMatchCount >= (int)snort_conf->fast_pattern_config->get_max_queue_events() ||
-        pmi->iMatchCount >= MAX_EVENT_MATCH)
+    if ( pos >= max )
     {
         pc.match_limit++;
-        return 1;
+
+        if ( !fpEventBefore(otn, pmi->MatchArray[max - 1], order) )
+            return 1;
+
+        pos = max - 1;
+        ret = 1;
     }
+    else
+        pmi->iMatchCount++;
 
-    // don't store the same otn again
-    for ( int i=0; i< pmi->iMatchCount; i++ )
+    while ( pos > 0 and fpEventBefore(otn, pmi->MatchArray[pos - 1], order) )
     {
-        if ( pmi->MatchArray[ i  ] == otn )
-            return 0;
+        pmi->MatchArray[pos] = pmi->MatchArray[pos - 1];
+        --pos;
     }
 
-    //  add the event to the appropriate list
-    pmi->MatchArray[ pmi->iMatchCount ] = otn;
-
-    pmi->iMatchCount++;
+    pmi->MatchArray[pos] = otn;
     omd_local->have_match = true;
-    return 0;
+    return ret;
 }
 
 /*
@@ -461,62 +493,6 @@ static int rule_tree_match(
     return 0;
 }
 
-static int sortOrderByPriority(const void* e1, const void* e2)
-{
-    OptTreeNode* otn1;
-    OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode**)e1;
-    otn2 = *(OptTreeNode**)e2;
-
-    if ( otn1->sigInfo.priority < otn2->sigInfo.priority )
-        return -1;
-
-    if ( otn1->sigInfo.priority > otn2->sigInfo.priority )
-        return +1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return -1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return +1;
-
-    return 0;
-}
-
-// FIXIT-L pattern length is not a valid event sort criterion for
-// non-literals
-static int sortOrderByContentLength(const void* e1, const void* e2)
-{
-    OptTreeNode* otn1;
-    OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode**)e1;
-    otn2 = *(OptTreeNode**)e2;
-
-    if (otn1->longestPatternLen < otn2->longestPatternLen)
-        return +1;
-
-    if (otn1->longestPatternLen > otn2->longestPatternLen)
-        return -1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return +1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return -1;
-
-    return 0;
-}
-
 /*
 **
 **  NAME
@@ -653,7 +629,6 @@ static inline int fpFinalSelectEvent(OTNX_MATCH_DATA* o, Packet* p)
 
     int i;
     int j;
-    int k;
     const OptTreeNode* otn;
     int tcnt = 0;
     EventQueueConfig* eq = snort_conf->event_queue_config;
@@ -669,9 +644,9 @@ static inline int fpFinalSelectEvent(OTNX_MATCH_DATA* o, Packet* p)
         if (o->matchInfo[i].iMatchCount)
         {
             /*
-             * We must always sort so if we que 8 and log 3 and they are
-             * all from the same action group we want them sorted so we get
-             * the highest 3 in priority, priority and length sort do NOT
+             * fpAddMatch keeps each action group sorted so if we que 8 and
+             * log 3 and they are all from the same action group we get the
+             * highest 3 in priority, priority and length order do NOT
              * take precedence over 'alert drop pass ...' ordering.  If
              * order is 'drop alert', and we log 3 for drop alerts do not
              * get logged.  IF order is 'alert drop', and we log 3 for
@@ -679,18 +654,8 @@ static inline int fpFinalSelectEvent(OTNX_MATCH_DATA* o, Packet* p)
              * built in drop/sdrop/reject comes before alert/pass/log as
              * part of the natural ordering....Jan '06..
              */
-            /* Sort the rules in this action group */
-            if (eq->order == SNORT_EVENTQ_PRIORITY)
-            {
-                qsort(o->matchInfo[i].MatchArray, o->matchInfo[i].iMatchCount,
-                    sizeof(void*), sortOrderByPriority);
-            }
-            else if (eq->order == SNORT_EVENTQ_CONTENT_LEN)
-            {
-                qsort(o->matchInfo[i].MatchArray, o->matchInfo[i].iMatchCount,
-                    sizeof(void*), sortOrderByContentLength);
-            }
-            else
+            if ( eq->order != SNORT_EVENTQ_PRIORITY and
+                eq->order != SNORT_EVENTQ_CONTENT_LEN )
             {
                 FatalError("fpdetect: Order function for event queue is invalid.\n");
             }
@@ -708,19 +673,7 @@ static inline int fpFinalSelectEvent(OTNX_MATCH_DATA* o, Packet* p)
                         return 1;
                 }
 
-                /*
-                **  Loop here so we don't log the same event
-                **  multiple times.
-                */
-                for (k = 0; k < j; k++)
-                {
-                    if (o->matchInfo[i].MatchArray[k] == otn)
-                    {
-                        otn = nullptr;
-                        break;
-                    }
-                }
-
+                // fpAddMatch doesn't queue the same event twice
                 if ( otn && !fpSessionAlerted(p, otn) )
                 {
                     /*
@@ -760,31 +713,6 @@ static inline int fpFinalSelectEvent(OTNX_MATCH_DATA* o, Packet* p)
     return 0;
 }
 
-class MpseStash
-{
-public:
-    static const unsigned max = 32;
-
-    void init()
-    { count = flushed = 0; }
-
-    bool push(void* user, void* tree, int index, void* list);
-    bool process(MpseMatch, void*);
-
-private:
-    unsigned count;
-    unsigned flushed;
-
-    struct Node {
-        void* user;
-        void* tree;
-        void* list;
-        int index;
-    } queue[max];
-};
-
-static THREAD_LOCAL MpseStash stash;
-
 // uniquely insert into q, should splay elements for performance
 // return true if maxed out to trigger a flush
 bool MpseStash::push(void* user, void* tree, int index, void* list)
@@ -845,9 +773,11 @@ bool MpseStash::process(MpseMatch match, void* context)
 static int rule_tree_queue(
     void* user, void* tree, int index, void* context, void* list)
 {
-    if ( stash.push(user, tree, index, list) )
+    MpseStash* stash = IpsContext::get_current()->stash;
+
+    if ( stash->push(user, tree, index, list) )
     {
-        if ( stash.process(rule_tree_match, context) )
+        if ( stash->process(rule_tree_match, context) )
         {
             return 1;
         }
@@ -855,15 +785,17 @@ static int rule_tree_queue(
     return 0;
 }
 
-#define SEARCH_DATA(buf, len, cnt) \
+#define SEARCH_DATA(buf, len, pmt, cnt) \
     { \
         assert(so->get_pattern_count() > 0); \
         int start_state = 0; \
         cnt++; \
         omd->data = buf; omd->size = len; \
-        stash.init(); \
-        so->search(buf, len, rule_tree_queue, omd, &start_state); \
-        stash.process(rule_tree_match, omd); \
+        stash->init(); \
+        if ( !RegexOffload::search( \
+            so, port_group->max_len[pmt], buf, len, rule_tree_queue, omd) ) \
+            so->search(buf, len, rule_tree_queue, omd, &start_state); \
+        stash->process(rule_tree_match, omd); \
         if ( PacketLatency::fastpath() ) \
             return 1; \
     }
@@ -872,7 +804,7 @@ static int rule_tree_queue(
     if ( gadget->get_fp_buf(ibt, p, buf) ) \
     { \
         if ( Mpse* so = port_group->mpse[pmt] ) \
-            SEARCH_DATA(buf.data, buf.len, cnt) \
+            SEARCH_DATA(buf.data, buf.len, pmt, cnt) \
     }
 
 static int fp_search(
@@ -880,6 +812,7 @@ static int fp_search(
     int check_ports, int type, OTNX_MATCH_DATA* omd)
 {
     Inspector* gadget = p->flow ? p->flow->gadget : nullptr;
+    MpseStash* stash = IpsContext::get_current()->stash;
     InspectionBuffer buf;
 
     omd->pg = port_group;
@@ -899,7 +832,7 @@ static int fp_search(
                 pattern_match_size = p->alt_dsize;
 
             if ( pattern_match_size )
-                SEARCH_DATA(p->data, pattern_match_size, pc.pkt_searches);
+                SEARCH_DATA(p->data, pattern_match_size, PM_TYPE_PKT, pc.pkt_searches);
 
             if ( pattern_match_size )
                 p->is_cooked() ?  pc.cooked_searches++ : pc.raw_searches++;
@@ -927,7 +860,7 @@ static int fp_search(
             // FIXIT-M file data should be obtained from
             // inspector gadget as is done with SEARCH_BUFFER
             if ( g_file_data.len )
-                SEARCH_DATA(g_file_data.data, g_file_data.len, pc.file_searches);
+                SEARCH_DATA(g_file_data.data, g_file_data.len, PM_TYPE_FILE, pc.file_searches);
         }
     }
     return 0;
@@ -1172,7 +1105,7 @@ static inline bool fpEvalHeaderSvc(Packet* p, OTNX_MATCH_DATA* omd, int proto)
 
 static void fpEvalPacketUdp(Packet* p)
 {
-    OTNX_MATCH_DATA* omd = &t_omd;
+    OTNX_MATCH_DATA* omd = IpsContext::get_current()->otnx;
 
     uint16_t tmp_sp = p->ptrs.sp;
     uint16_t tmp_dp = p->ptrs.dp;
@@ -1236,7 +1169,7 @@ static void fpEvalPacketUdp(Packet* p)
 */
 int fpEvalPacket(Packet* p)
 {
-    OTNX_MATCH_DATA* omd = &t_omd;
+    OTNX_MATCH_DATA* omd = IpsContext::get_current()->otnx;
     InitMatchInfo(omd);
 
     /* Run UDP rules against the UDP header of Teredo packets */
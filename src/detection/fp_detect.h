@@ -63,8 +63,8 @@ int fpEvalRTN(RuleTreeNode*, Packet*, int check_ports);
 /*
 **  MATCH_INFO
 **  The events that are matched get held in this structure,
-**  and iMatchIndex gets set to the event that holds the
-**  highest priority.
+**  sorted by the event queue order with the highest priority
+**  first.
 */
 struct MATCH_INFO
 {
@@ -98,9 +98,6 @@ struct OTNX_MATCH_DATA
     int iMatchInfoArraySize;
 };
 
-void otnx_match_data_init(int);
-void otnx_match_data_term();
-
 int fpAddMatch(OTNX_MATCH_DATA*, int pLen, const OptTreeNode*);
 OptTreeNode* GetOTN(uint32_t gid, uint32_t sid);
 
@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_context.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ips_context.h"
+
+#include "events/event_queue.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "utils/util.h"
+
+#include "fp_detect.h"
+
+THREAD_LOCAL IpsContext* IpsContext::pool[IpsContext::max_depth];
+THREAD_LOCAL unsigned IpsContext::depth = 0;
+THREAD_LOCAL unsigned IpsContext::overflow = 0;
+
+IpsContext::IpsContext(const SnortConfig* sc)
+{
+    otnx = (OTNX_MATCH_DATA*)snort_calloc(sizeof(OTNX_MATCH_DATA));
+    otnx->iMatchInfoArraySize = sc->num_rule_types;
+    otnx->matchInfo = (MATCH_INFO*)snort_calloc(sc->num_rule_types, sizeof(MATCH_INFO));
+
+    stash = new MpseStash;
+    stash->init();
+
+    const EventQueueConfig* eqc = sc->event_queue_config;
+    equeue = sfeventq_new(eqc->max_events, eqc->log_events, sizeof(EventNode));
+
+    if ( !equeue )
+        FatalError("Failed to initialize Snort event queue.\n");
+}
+
+IpsContext::~IpsContext()
+{
+    sfeventq_free(equeue);
+    delete stash;
+    snort_free(otnx->matchInfo);
+    snort_free(otnx);
+}
+
+void IpsContext::thread_init(const SnortConfig* sc)
+{
+    for ( unsigned i = 0; i < max_depth; ++i )
+        pool[i] = new IpsContext(sc);
+
+    depth = overflow = 0;
+}
+
+void IpsContext::thread_term()
+{
+    for ( unsigned i = 0; i < max_depth; ++i )
+    {
+        delete pool[i];
+        pool[i] = nullptr;
+    }
+}
+
+// push and pop ensure that depth stays in bounds and that it is only
+// popped after it was successfully pushed.
+void IpsContext::push()
+{
+    if ( depth < max_depth-1 )
+        depth++;
+    else
+        overflow++;
+}
+
+void IpsContext::pop()
+{
+    if ( overflow > 0 )
+        overflow--;
+    else if ( depth > 0 )
+        depth--;
+}
+
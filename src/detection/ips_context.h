@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_context.h
+
+#ifndef IPS_CONTEXT_H
+#define IPS_CONTEXT_H
+
+// IpsContext holds what detection keeps for one packet: the rule matches,
+// the fast pattern match stash and the event queue.  Each packet thread has
+// a small stack of them drawn from its pool at startup.  Wire packets use
+// the bottom one; a packet detected while another is being processed (eg a
+// rebuilt PDU) pushes the next so neither disturbs the other.
+
+#include "events/sfeventq.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+#include "search_engines/search_common.h"
+
+struct OTNX_MATCH_DATA;
+struct SnortConfig;
+
+// fast pattern matches are queued here and the rule trees evaluated in
+// batches; the methods are in fp_detect.cc
+class MpseStash
+{
+public:
+    static const unsigned max = 32;
+
+    void init()
+    { count = flushed = 0; }
+
+    bool push(void* user, void* tree, int index, void* list);
+    bool process(MpseMatch, void*);
+
+private:
+    unsigned count;
+    unsigned flushed;
+
+    struct Node
+    {
+        void* user;
+        void* tree;
+        void* list;
+        int index;
+    } queue[max];
+};
+
+class IpsContext
+{
+public:
+    IpsContext(const SnortConfig*);
+    ~IpsContext();
+
+    OTNX_MATCH_DATA* otnx;
+    MpseStash* stash;
+    SF_EVENTQ* equeue;
+
+    static void thread_init(const SnortConfig*);
+    static void thread_term();
+
+    static IpsContext* get_current()
+    { return pool[depth]; }
+
+    // the top context is shared if the stack is already full
+    static void push();
+    static void pop();
+
+    static const unsigned max_depth = 3;
+
+private:
+    IpsContext(const IpsContext&) = delete;
+    IpsContext& operator=(const IpsContext&) = delete;
+
+    static THREAD_LOCAL IpsContext* pool[max_depth];
+    static THREAD_LOCAL unsigned depth;
+    static THREAD_LOCAL unsigned overflow;
+};
+
+#endif
+
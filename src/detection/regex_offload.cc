@@ -0,0 +1,324 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// regex_offload.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "regex_offload.h"
+
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "framework/mpse.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "profiler/profiler_defs.h"
+#include "utils/stats.h"
+
+#ifdef UNIT_TEST
+#include <set>
+#include <utility>
+
+#include "catch/catch.hpp"
+#include "managers/mpse_manager.h"
+#endif
+
+namespace
+{
+struct Match
+{
+    void* user;
+    void* tree;
+    void* list;
+    int index;
+};
+
+struct Request
+{
+    std::mutex mutex;
+    std::condition_variable done;
+    unsigned pending = 0;
+};
+
+struct Chunk
+{
+    Mpse* mpse;
+    const uint8_t* buf;
+    unsigned len;
+    unsigned offset;  // of buf in the whole buffer
+    Request* req;
+    std::vector<Match> matches;
+};
+
+// what a packet thread needs to offload; kept for reuse
+struct ThreadChunks
+{
+    Request req;
+    std::vector<Chunk> chunks;
+};
+}
+
+static std::vector<std::thread*> workers;
+static std::mutex queue_mutex;
+static std::condition_variable queue_ready;
+static std::deque<Chunk*> queue;
+static bool running = false;
+
+static THREAD_LOCAL ThreadChunks* thread_chunks = nullptr;
+
+static int collect(void* user, void* tree, int index, void* context, void* list)
+{
+    Chunk* c = (Chunk*)context;
+    c->matches.push_back({ user, tree, list, index + (int)c->offset });
+    return 0;
+}
+
+// same engine entry point as a direct search so each match comes with the
+// tree and negated list it would have had
+static void search_chunk(Chunk* c)
+{
+    int start_state = 0;
+    c->mpse->search_chunk(c->buf, c->len, collect, c, &start_state);
+}
+
+static void worker()
+{
+    while ( true )
+    {
+        Chunk* c;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [] { return !running or !queue.empty(); });
+
+            if ( queue.empty() )
+                return;
+
+            c = queue.front();
+            queue.pop_front();
+        }
+
+        search_chunk(c);
+
+        std::lock_guard<std::mutex> lock(c->req->mutex);
+
+        if ( --c->req->pending == 0 )
+            c->req->done.notify_one();
+    }
+}
+
+void RegexOffload::init(unsigned threads)
+{
+    assert(workers.empty());
+    running = true;
+
+    for ( unsigned i = 0; i < threads; ++i )
+        workers.push_back(new std::thread(worker));
+}
+
+void RegexOffload::term()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        running = false;
+    }
+    queue_ready.notify_all();
+
+    for ( auto* t : workers )
+    {
+        t->join();
+        delete t;
+    }
+    workers.clear();
+}
+
+void RegexOffload::tterm()
+{
+    delete thread_chunks;
+    thread_chunks = nullptr;
+}
+
+bool RegexOffload::search(
+    Mpse* mpse, unsigned max_len, const uint8_t* buf, unsigned len,
+    MpseMatch match, void* context)
+{
+    if ( workers.empty() or len < snort_conf->offload_limit )
+        return false;
+
+    // hyperscan scratch space belongs to the packet thread
+    if ( !strcmp(mpse->get_method(), "hyperscan") )
+        return false;
+
+    const unsigned num = workers.size() + 1;
+    const unsigned size = (len + num - 1) / num;
+    const unsigned overlap = max_len ? max_len - 1 : 0;
+
+    if ( overlap >= size )
+        return false;
+
+    Profile profile(mpsePerfStats);
+
+    if ( !thread_chunks )
+        thread_chunks = new ThreadChunks;
+
+    std::vector<Chunk>& chunks = thread_chunks->chunks;
+    Request& req = thread_chunks->req;
+    unsigned n = 0;
+
+    chunks.resize(num);
+
+    for ( unsigned start = 0; start < len; start += size )
+    {
+        const unsigned from = (start > overlap) ? start - overlap : 0;
+        const unsigned end = (start + size < len) ? start + size : len;
+
+        Chunk& c = chunks[n++];
+        c.mpse = mpse;
+        c.buf = buf + from;
+        c.len = end - from;
+        c.offset = from;
+        c.req = &req;
+        c.matches.clear();
+    }
+
+    req.pending = n - 1;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+
+        for ( unsigned i = 1; i < n; ++i )
+            queue.push_back(&chunks[i]);
+    }
+    queue_ready.notify_all();
+
+    search_chunk(&chunks[0]);
+
+    {
+        std::unique_lock<std::mutex> lock(req.mutex);
+        req.done.wait(lock, [&req] { return !req.pending; });
+    }
+    pc.offloads++;
+    mpse->searched(len);
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        for ( const Match& m : chunks[i].matches )
+        {
+            if ( match(m.user, m.tree, m.index, context, m.list) > 0 )
+                return true;
+        }
+    }
+    return true;
+}
+
+#ifdef UNIT_TEST
+
+// the tree of a match is the list of ids sharing its state, as the detection
+// engine's trees hold the rules sharing a fast pattern
+static int build_tree(SnortConfig*, void* id, void** tree)
+{
+    if ( !*tree )
+        *tree = new std::vector<long>;
+
+    ((std::vector<long>*)*tree)->push_back((long)id);
+    return 0;
+}
+
+static int negate_list(void*, void**)
+{ return 0; }
+
+static void user_free(void*)
+{ }
+
+static void list_free(void**)
+{ }
+
+static void tree_free(void** tree)
+{
+    delete (std::vector<long>*)*tree;
+    *tree = nullptr;
+}
+
+static MpseAgent agent = { build_tree, negate_list, user_free, tree_free, list_free };
+
+typedef std::set<std::pair<long, int>> Hits;
+
+static int hit(void*, void* tree, int index, void* context, void*)
+{
+    if ( tree )
+    {
+        for ( long id : *(std::vector<long>*)tree )
+            ((Hits*)context)->insert({ id, index });
+    }
+    return 0;
+}
+
+TEST_CASE("offloaded search finds the rules a direct search does", "[RegexOffload]")
+{
+    static const char* pats[] = { "abc", "abc", "bc", "ABC", "c", "cab", "bca" };
+    const MpseApi* api = MpseManager::get_search_api("ac_full");
+
+    if ( !api or !snort_conf )
+        return;
+
+    // search_opt selects the dfa, which is where search_all differs
+    Mpse* mpse = MpseManager::get_search_engine(snort_conf, api, false, &agent);
+    mpse->set_opt(1);
+    long id = 0;
+
+    for ( const char* pat : pats )
+    {
+        // odd ids are case sensitive
+        Mpse::PatternDescriptor desc(!(id & 1), false, true);
+        mpse->add_pattern(snort_conf, (const uint8_t*)pat, strlen(pat), desc, (void*)++id);
+    }
+    mpse->prep_patterns(snort_conf);
+
+    std::vector<uint8_t> buf(8192);
+    unsigned seed = 7;
+
+    for ( auto& b : buf )
+        b = "abcABCx"[rand_r(&seed) % 7];
+
+    Hits direct, offloaded;
+    int state = 0;
+    mpse->search(buf.data(), buf.size(), hit, &direct, &state);
+
+    const unsigned limit = snort_conf->offload_limit;
+    snort_conf->offload_limit = 1024;
+    RegexOffload::init(3);
+
+    CHECK(RegexOffload::search(mpse, 3, buf.data(), buf.size(), hit, &offloaded));
+
+    RegexOffload::term();
+    RegexOffload::tterm();
+    snort_conf->offload_limit = limit;
+
+    CHECK(!direct.empty());
+    CHECK(direct == offloaded);
+
+    MpseManager::delete_search_engine(mpse);
+}
+
+#endif
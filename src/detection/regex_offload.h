@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// regex_offload.h
+
+#ifndef REGEX_OFFLOAD_H
+#define REGEX_OFFLOAD_H
+
+// RegexOffload splits the fast pattern search of a large buffer into
+// chunks.  A pool of threads searches all but the first while the packet
+// thread searches that one.  The matches are then handed to the packet
+// thread's callback in buffer order so rule evaluation and events stay on
+// the packet thread and come out as if the buffer was searched in one go.
+// Chunks overlap by the longest pattern length less one so no match is
+// lost; a match in the overlap may be reported twice, which the stash
+// ignores.
+
+#include <cstdint>
+
+#include "search_engines/search_common.h"
+
+class Mpse;
+
+class RegexOffload
+{
+public:
+    // start and stop the pool; no threads means no offload
+    static void init(unsigned threads);
+    static void term();
+
+    // free the calling packet thread's chunk buffers
+    static void tterm();
+
+    // returns false if the buffer must be searched directly
+    static bool search(
+        Mpse*, unsigned max_len, const uint8_t* buf, unsigned len, MpseMatch, void* context);
+};
+
+#endif
+
@@ -248,6 +248,9 @@ void OtnFree(void* data)
     if (otn->detection_filter)
         snort_free(otn->detection_filter);
 
+    if ( otn->hist )
+        snort_free(otn->hist);
+
     snort_free(otn->state);
     snort_free(otn);
 }
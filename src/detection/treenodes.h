@@ -26,6 +26,7 @@
 #include "detection/signature.h"
 #include "detection/rule_option_types.h"
 #include "main/snort_types.h"
+#include "profiler/tick_histogram.h"
 #include "time/clock_defs.h"
 
 class IpsOption;
@@ -65,6 +66,9 @@ struct OtnState
     uint64_t latency_timeouts = 0;
     uint64_t latency_suspends = 0;
 
+    // ticks spent on the rule's option path per evaluation
+    ThreadHistogram hist = { };
+
     operator bool() const
     { return elapsed > 0_ticks || checks > 0; }
 };
@@ -90,6 +94,9 @@ struct OptTreeNode
 
     OtnState* state;
 
+    // state[].hist merged from the packet threads as they exit
+    RuleHistogram* hist;
+
     int chain_node_number;
     int evalIndex;       /* where this rule sits in the evaluation sets */
     int proto;           /* protocol, added for integrity checks
@@ -59,6 +59,7 @@
 #include "event_queue.h"
 
 #include "detection/fp_detect.h"
+#include "detection/ips_context.h"
 #include "filters/sfthreshold.h"
 #include "log/messages.h"
 #include "parser/parser.h"
@@ -72,32 +73,20 @@ typedef struct s_SNORT_EVENTQ_USER
     void* pkt;
 } SNORT_EVENTQ_USER;
 
-#define NUM_EVENT_QUEUES 3
-static THREAD_LOCAL SF_EVENTQ* event_queue[NUM_EVENT_QUEUES];
-
-static THREAD_LOCAL unsigned qIndex = 0;
 static THREAD_LOCAL unsigned s_events = 0;
-static THREAD_LOCAL unsigned qOverflow = 0;
 
 //-------------------------------------------------
-// the push/pop methods ensure that qIndex stays in
-// bounds and that it is only popped after it was
-// successfully pushed.
+// each detection context has its own queue so that
+// events from a rebuilt packet don't mix with those
+// of the packet that caused it.
 void SnortEventqPush()
-{
-    if ( qIndex < NUM_EVENT_QUEUES-1 )
-        qIndex++;
-    else
-        qOverflow++;
-}
+{ IpsContext::push(); }
 
 void SnortEventqPop()
-{
-    if ( qOverflow > 0 )
-        qOverflow--;
-    else if ( qIndex > 0 )
-        qIndex--;
-}
+{ IpsContext::pop(); }
+
+static inline SF_EVENTQ* get_queue()
+{ return IpsContext::get_current()->equeue; }
 
 //-------------------------------------------------
 /*
@@ -138,7 +127,7 @@ int SnortEventqAdd(const OptTreeNode* otn)
         return 0;
     }
 
-    EventNode* en = (EventNode*)sfeventq_event_alloc(event_queue[qIndex]);
+    EventNode* en = (EventNode*)sfeventq_event_alloc(get_queue());
 
     if ( !en )
         return -1;
@@ -146,7 +135,7 @@ int SnortEventqAdd(const OptTreeNode* otn)
     en->otn = otn;
     en->rtn = rtn;
 
-    if ( sfeventq_add(event_queue[qIndex], en) )
+    if ( sfeventq_add(get_queue(), en) )
         return -1;
 
     s_events++;
@@ -162,7 +151,7 @@ int SnortEventqAdd(uint32_t gid, uint32_t sid, RuleType type)
     if ( !otn )
         return 0;
 
-    EventNode* en = (EventNode*)sfeventq_event_alloc(event_queue[qIndex]);
+    EventNode* en = (EventNode*)sfeventq_event_alloc(get_queue());
 
     if ( !en )
         return -1;
@@ -171,7 +160,7 @@ int SnortEventqAdd(uint32_t gid, uint32_t sid, RuleType type)
     en->rtn = nullptr;  // lookup later after ips policy selection
     en->type = type;
 
-    if ( sfeventq_add(event_queue[qIndex], en) )
+    if ( sfeventq_add(get_queue(), en) )
         return -1;
 
     s_events++;
@@ -184,27 +173,6 @@ bool event_is_enabled(uint32_t gid, uint32_t sid)
     return ( otn != nullptr );
 }
 
-void SnortEventqNew(EventQueueConfig* eq_config)
-{
-    int i;
-
-    for ( i = 0; i < NUM_EVENT_QUEUES; i++ )
-    {
-        event_queue[i] = sfeventq_new(eq_config->max_events,
-            eq_config->log_events, sizeof(EventNode));
-
-        if (event_queue[i] == NULL)
-            FatalError("Failed to initialize Snort event queue.\n");
-    }
-}
-
-void SnortEventqFree()
-{
-    int i;
-    for ( i = 0; i < NUM_EVENT_QUEUES; i++ )
-        sfeventq_free(event_queue[i]);
-}
-
 static int LogSnortEvents(void* event, void* user)
 {
     if ( !event || !user )
@@ -250,7 +218,7 @@ int SnortEventqLog(Packet* p)
 {
     SNORT_EVENTQ_USER user;
     user.pkt = (void*)p;
-    sfeventq_action(event_queue[qIndex], LogSnortEvents, (void*)&user);
+    sfeventq_action(get_queue(), LogSnortEvents, (void*)&user);
     return 0;
 }
 
@@ -267,7 +235,7 @@ void SnortEventqResetCounts()
 
 void SnortEventqReset()
 {
-    sfeventq_reset(event_queue[qIndex]);
+    sfeventq_reset(get_queue());
     reset_counts();
 }
 
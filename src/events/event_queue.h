@@ -47,9 +47,6 @@ struct EventNode
 EventQueueConfig* EventQueueConfigNew();
 void EventQueueConfigFree(EventQueueConfig*);
 
-void SnortEventqNew(EventQueueConfig*);
-void SnortEventqFree();
-
 SO_PUBLIC void SnortEventqReset();
 void SnortEventqResetCounts();
 
@@ -79,15 +79,14 @@ SF_EVENTQ* sfeventq_new(int max_nodes, int log_nodes, int event_size)
     eq = (SF_EVENTQ*)snort_calloc(sizeof(SF_EVENTQ));
 
     /* Initialize the memory for the nodes that we are going to use. */
-    eq->node_mem = (SF_EVENTQ_NODE*)snort_calloc(max_nodes, sizeof(SF_EVENTQ_NODE));
-    eq->event_mem = (char*)snort_calloc(max_nodes + 1, event_size);
+    eq->nodes = (void**)snort_calloc(max_nodes, sizeof(void*));
+    eq->event_mem = (char*)snort_calloc(max_nodes, event_size);
 
     eq->max_nodes = max_nodes;
     eq->log_nodes = log_nodes;
     eq->event_size = event_size;
     eq->cur_nodes = 0;
     eq->cur_events = 0;
-    eq->reserve_event = (char*)(&eq->event_mem[max_nodes * eq->event_size]);
 
     return eq;
 }
@@ -101,7 +100,8 @@ SF_EVENTQ* sfeventq_new(int max_nodes, int log_nodes, int event_size)
 **  function is meant to be called first, the event structure filled in,
 **  and then added to the queue.  While you can allocate several times before
 **  adding to the queue, this is not recommended as you may get a NULL ptr
-**  if you allocate more than the max node number.
+**  if you allocate more than the max node number.  Once the queue is full
+**  NULL is returned since the event could not be added anyway.
 **
 **  @return  void *
 **
@@ -113,15 +113,7 @@ void* sfeventq_event_alloc(SF_EVENTQ* eq)
     void* event;
 
     if (eq->cur_events >= eq->max_nodes)
-    {
-        if (eq->reserve_event == NULL)
-            return NULL;
-
-        event = (void*)eq->reserve_event;
-        eq->reserve_event = NULL;
-
-        return event;
-    }
+        return NULL;
 
     event = (void*)(&eq->event_mem[eq->cur_events * eq->event_size]);
 
@@ -135,17 +127,15 @@ void* sfeventq_event_alloc(SF_EVENTQ* eq)
 **    sfeventq_reset::
 */
 /**
-**  Resets the event queue.  We also set the reserve event back
-**  to the last event in the queue.
+**  Resets the event queue.  The node and event memory is kept
+**  for the next packet.
 **
 **  @return void
 */
 void sfeventq_reset(SF_EVENTQ* eq)
 {
-    eq->head = NULL;
     eq->cur_nodes = 0;
     eq->cur_events = 0;
-    eq->reserve_event = (char*)(&eq->event_mem[eq->max_nodes * eq->event_size]);
 }
 
 /*
@@ -164,10 +154,10 @@ void sfeventq_free(SF_EVENTQ* eq)
         return;
 
     /* Free the memory for the nodes that were in use. */
-    if (eq->node_mem != NULL)
+    if (eq->nodes != NULL)
     {
-        snort_free(eq->node_mem);
-        eq->node_mem = NULL;
+        snort_free(eq->nodes);
+        eq->nodes = NULL;
     }
 
     if (eq->event_mem != NULL)
@@ -179,46 +169,13 @@ void sfeventq_free(SF_EVENTQ* eq)
     snort_free(eq);
 }
 
-/*
-**  NAME
-**    get_eventq_node::
-*/
-/**
-**  This function returns a ptr to the node to use.  We allocate the last
-**  event node if we have exhausted the event queue.  Before we allocate
-**  the last node, we determine if the incoming event has a higher
-**  priority than the last node.  If it does, we allocate the node, otherwise
-**  we drop it because it is lower priority.
-**
-**  If the last node is allocated, we have to point the reserve_event to
-**  the allocated event memory, since the reserved_event memory was used
-**  for the incoming event.
-**
-**  @return SF_EVENTQ_NODE *
-**
-**  @retval NULL resource exhaustion and event is lower priority than last node
-**  @retval !NULL ptr to node memory.
-*/
-static SF_EVENTQ_NODE* get_eventq_node(SF_EVENTQ* eq, void*)
-{
-    if (eq->cur_nodes >= eq->max_nodes)
-        return NULL;
-
-    /*
-    **  We grab the next node from the node memory.
-    */
-    return &eq->node_mem[eq->cur_nodes++];
-}
-
 /*
 **  NAME
 **    sfeventq_add:
 */
 /**
-**  Add this event to the queue using the supplied ordering
-**  function.  If the queue is exhausted, then we compare the
-**  event to be added with the last event, and decide whether
-**  it is a higher priority than the last node.
+**  Add this event to the end of the queue.  The event must
+**  have been allocated with sfeventq_event_alloc().
 **
 **  @return integer
 **
@@ -227,41 +184,16 @@ static SF_EVENTQ_NODE* get_eventq_node(SF_EVENTQ* eq, void*)
 */
 int sfeventq_add(SF_EVENTQ* eq, void* event)
 {
-    SF_EVENTQ_NODE* node;
-
     if (!event)
         return -1;
 
     /*
-    **  If get_eventq_node() returns NULL, this means that
-    **  we have exhausted the eventq and the incoming event
-    **  is lower in priority then the last ranked event.
-    **  So we just drop it.
+    **  If the queue is full, we just drop it.
     */
-    node = get_eventq_node(eq, event);
-    if (!node)
+    if (eq->cur_nodes >= eq->max_nodes)
         return -1;
 
-    node->event = event;
-    node->next  = NULL;
-    node->prev  = NULL;
-
-    /*
-    **  This is the first node
-    */
-    if (eq->cur_nodes == 1)
-    {
-        eq->head = eq->last = node;
-        return 0;
-    }
-
-    /*
-    **  This means we are the last node.
-    */
-    node->prev = eq->last;
-
-    eq->last->next = node;
-    eq->last = node;
+    eq->nodes[eq->cur_nodes++] = event;
 
     return 0;
 }
@@ -282,21 +214,20 @@ int sfeventq_add(SF_EVENTQ* eq, void* event)
 */
 int sfeventq_action(SF_EVENTQ* eq, int (* action_func)(void*, void*), void* user)
 {
-    SF_EVENTQ_NODE* node;
     int logged = 0;
 
     if (action_func == NULL)
         return -1;
 
-    if (eq->head == NULL)
+    if (eq->cur_nodes == 0)
         return 0;
 
-    for (node = eq->head; node != NULL; node = node->next)
+    for (int i = 0; i < eq->cur_nodes; i++)
     {
         if (logged >= eq->log_nodes)
             return 1;
 
-        if (action_func(node->event, user))
+        if (action_func(eq->nodes[i], user))
             return -1;
 
         logged++;
@@ -20,34 +20,17 @@
 #ifndef SFEVENTQ_H
 #define SFEVENTQ_H
 
-typedef struct s_SF_EVENTQ_NODE
-{
-    void* event;
-
-    struct s_SF_EVENTQ_NODE* prev;
-    struct s_SF_EVENTQ_NODE* next;
-}  SF_EVENTQ_NODE;
-
 typedef struct s_SF_EVENTQ
 {
     /*
-    **  Handles the actual ordering and memory
-    **  of the event queue and it's nodes.
+    **  Events are logged in the order they are added so the
+    **  queue is just an array of the added events.  Both the
+    **  array and the event memory are allocated up front and
+    **  reused for every packet.
     */
-    SF_EVENTQ_NODE* head;
-    SF_EVENTQ_NODE* last;
-
-    SF_EVENTQ_NODE* node_mem;
+    void** nodes;
     char* event_mem;
 
-    /*
-    **  The reserve event allows us to allocate one extra node
-    **  and compare against the last event in the queue to determine
-    **  if the incoming event is a higher priority than the last
-    **  event in the queue.
-    */
-    char* reserve_event;
-
     /*
     **  Queue configuration
     */
@@ -30,9 +30,12 @@
 
 #include "file_capture.h"
 
-#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <cassert>
+#include <climits>
 
 #include "log/messages.h"
 #include "utils/stats.h"
@@ -41,14 +44,18 @@
 #include "file_mempool.h"
 #include "file_stats.h"
 
+// blocks written per system call
+#if defined(IOV_MAX) && (IOV_MAX < 64)
+#define MAX_WRITE_BLOCKS IOV_MAX
+#else
+#define MAX_WRITE_BLOCKS 64
+#endif
+
 FileMemPool* FileCapture::file_mempool = nullptr;
 int64_t FileCapture::capture_block_size = 0;
 
-std::mutex FileCapture::capture_mutex;
-std::condition_variable FileCapture::capture_cv;
-std::thread* FileCapture::file_storer = nullptr;
-std::queue<FileCapture*> FileCapture::files_waiting;
-bool FileCapture::running = true;
+std::vector<FileCapture::FileWriter*> FileCapture::writers;
+std::atomic<bool> FileCapture::running { true };
 
 FileCaptureState FileCapture::error_capture(FileCaptureState state)
 {
@@ -56,24 +63,32 @@ FileCaptureState FileCapture::error_capture(FileCaptureState state)
     return state;
 }
 
-// Only one writer thread supported
-void FileCapture::writer_thread()
+// Files still queued at exit are stored before the thread ends
+void FileCapture::writer_thread(FileWriter* writer)
 {
+    std::queue<FileCapture*> files;
+
     while (1)
     {
-        // Wait until there are files
-        std::unique_lock<std::mutex> lk(capture_mutex);
-        capture_cv.wait(lk, [] { return !running or files_waiting.size(); });
+        // Wait until there are files and take all of them at once
+        std::unique_lock<std::mutex> lk(writer->queue_mutex);
+        writer->queue_cv.wait(lk, [writer]
+            { return !running or !writer->files_waiting.empty(); });
 
-        if (!running)
+        if (writer->files_waiting.empty())
             break;
 
-        FileCapture* file = files_waiting.front();
-        files_waiting.pop();
+        files.swap(writer->files_waiting);
         lk.unlock();
 
-        file->store_file();
-        delete file;
+        while (!files.empty())
+        {
+            FileCapture* file = files.front();
+            files.pop();
+
+            file->store_file();
+            delete file;
+        }
     }
 }
 
@@ -123,11 +138,19 @@ FileCapture::~FileCapture()
         delete file_info;
 }
 
-void FileCapture::init(int64_t memcap, int64_t block_size)
+void FileCapture::init(int64_t memcap, int64_t block_size, unsigned num_writers)
 {
     capture_block_size = block_size;
     init_mempool(memcap, capture_block_size);
-    file_storer = new std::thread(writer_thread);
+
+    running = true;
+
+    for (unsigned i = 0; i < num_writers; i++)
+    {
+        FileWriter* writer = new FileWriter;
+        writer->thread = new std::thread(writer_thread, writer);
+        writers.push_back(writer);
+    }
 }
 
 /*
@@ -137,14 +160,21 @@ void FileCapture::init(int64_t memcap, int64_t block_size)
 void FileCapture::exit()
 {
     running = false;
-    capture_cv.notify_one();
 
-    if (file_storer)
+    for (auto writer : writers)
+    {
+        // the lock makes sure a writer is either waiting or will see running
+        std::lock_guard<std::mutex> lk(writer->queue_mutex);
+        writer->queue_cv.notify_one();
+    }
+
+    for (auto writer : writers)
     {
-        file_storer->join();
-        delete file_storer;
-        file_storer = nullptr;
+        writer->thread->join();
+        delete writer->thread;
+        delete writer;
     }
+    writers.clear();
 
     if (file_mempool)
     {
@@ -441,42 +471,46 @@ uint64_t FileCapture::get_capture_size() const
 }
 
 /*
- * writing file data to the disk.
+ * writing a batch of file blocks to the disk.
  *
- * In the case of interrupt errors, the write is retried, but only for a
- * finite number of times.
+ * Partial writes are resumed. In the case of interrupt errors, the write is
+ * retried, but only for a finite number of times.
  */
-void FileCapture::write_file_data(uint8_t* buf, size_t buf_len, FILE* fh)
+bool FileCapture::write_file_data(int fd, struct iovec* iov, int iov_cnt)
 {
     int max_retries = 3;
-    size_t bytes_written = 0;
-    int err;
 
-    /* Nothing to write or nothing to write to */
-    if ((buf == nullptr) || (fh == nullptr))
-        return;
-
-    /* writing several times */
-    do
+    while (iov_cnt > 0)
     {
-        size_t bytes_left = buf_len - bytes_written;
+        ssize_t bytes_written = writev(fd, iov, iov_cnt);
+
+        if (bytes_written <= 0)
+        {
+            int err = bytes_written ? errno : EAGAIN;
+
+            if (((err == EINTR) || (err == EAGAIN)) && (--max_retries > 0))
+                continue;
 
-        bytes_written += fwrite(buf + bytes_written, 1, bytes_left, fh);
+            ErrorMessage("File inspect: disk writing error - %s!\n", get_error(err));
+            return false;
+        }
 
-        err = ferror(fh);
-        if (err && (err != EINTR) && (err != EAGAIN))
+        /* skip the blocks done, the rest of a partial block is written next time */
+        while ((iov_cnt > 0) && ((size_t)bytes_written >= iov->iov_len))
         {
-            break;
+            bytes_written -= iov->iov_len;
+            iov++;
+            iov_cnt--;
         }
 
-        max_retries--;
+        if (iov_cnt > 0)
+        {
+            iov->iov_base = (uint8_t*)iov->iov_base + bytes_written;
+            iov->iov_len -= bytes_written;
+        }
     }
-    while ((max_retries > 0) && (bytes_written < buf_len));
 
-    if (bytes_written < buf_len)
-    {
-        ErrorMessage("File inspect: disk writing error - %s!\n", get_error(err));
-    }
+    return true;
 }
 
 // Store files on local disk
@@ -487,38 +521,45 @@ void FileCapture::store_file()
 
     std::string& file_full_name = file_info->get_file_name();
 
-    /*Check whether the file exists*/
-    struct stat buffer;
-    if (stat (file_full_name.c_str(), &buffer) == 0)
+    /* Files are named by SHA256, so skip a file that is stored already */
+    int fd = open(file_full_name.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0)
     {
         return;
     }
 
-    FILE* fh = fopen(file_full_name.c_str(), "w");
-    if (!fh )
-    {
-        return;
-    }
-
-    // Check the file buffer
+    // Gather the file buffer so each system call writes many blocks
+    struct iovec iov[MAX_WRITE_BLOCKS];
+    int iov_cnt = 0;
     uint8_t* buff = nullptr;
     int size = 0;
     void* file_mem;
+    bool written = true;
 
     do
     {
         file_mem = get_file_data(&buff, &size);
-        // Get file from file buffer
-        if (!buff || !size )
+
+        if (buff && size)
         {
-            return;
+            iov[iov_cnt].iov_base = buff;
+            iov[iov_cnt].iov_len = size;
+            iov_cnt++;
         }
 
-        write_file_data(buff, size, fh);
+        if ((iov_cnt == MAX_WRITE_BLOCKS) || (!file_mem && iov_cnt))
+        {
+            written = write_file_data(fd, iov, iov_cnt);
+            iov_cnt = 0;
+        }
     }
-    while (file_mem);
+    while (file_mem && written);
 
-    fclose(fh);
+    close(fd);
+
+    /* Don't leave a truncated file behind under the name of the whole one */
+    if (!written)
+        unlink(file_full_name.c_str());
 }
 
 // Queue files to be stored to disk
@@ -529,7 +570,7 @@ void FileCapture::store_file_async()
         return;
 
     uint8_t* sha = file_info->get_file_sig_sha256();
-    if (!sha)
+    if (!sha || writers.empty())
         return;
 
     std::string file_name = file_info->sha_to_string(sha);
@@ -538,9 +579,13 @@ void FileCapture::store_file_async()
     get_instance_file(file_full_name, file_name.c_str());
     file_info->set_file_name(file_full_name.c_str(), file_full_name.size());
 
-    std::lock_guard<std::mutex> lk(capture_mutex);
-    files_waiting.push(this);
-    capture_cv.notify_one();
+    // The same file always goes to the same writer so two copies of it
+    // are never written at once
+    FileWriter* writer = writers[sha[0] % writers.size()];
+
+    std::lock_guard<std::mutex> lk(writer->queue_mutex);
+    writer->files_waiting.push(this);
+    writer->queue_cv.notify_one();
 }
 
 /*Log file capture mempool usage*/
@@ -31,15 +31,18 @@
 // 3) Then file data can be read through file_capture_read()
 // 4) Finally, file data must be released from mempool file_capture_release()
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 #include "file_api.h"
 
 class FileInfo;
 class FileMemPool;
+struct iovec;
 
 struct FileCaptureBlock
 {
@@ -54,7 +57,7 @@ public:
     ~FileCapture();
 
     // this must be called during snort init
-    static void init(int64_t memcap, int64_t block_size);
+    static void init(int64_t memcap, int64_t block_size, unsigned num_writers = 1);
 
     // Capture file data to local buffer
     // This is the main function call to enable file capture
@@ -81,7 +84,7 @@ public:
     // Store files on local disk
     void store_file();
 
-    // Store file to disk asynchronously
+    // Store file to disk asynchronously, the writer thread takes ownership
     void store_file_async();
 
     // Log file capture mempool usage
@@ -97,20 +100,27 @@ public:
 
 private:
 
+    // Each writer thread has its own queue so the packet threads only
+    // contend with the one writer a file is given to
+    struct FileWriter
+    {
+        std::mutex queue_mutex;
+        std::condition_variable queue_cv;
+        std::queue<FileCapture*> files_waiting;
+        std::thread* thread = nullptr;
+    };
+
     static void init_mempool(int64_t max_file_mem, int64_t block_size);
-    static void writer_thread();
+    static void writer_thread(FileWriter*);
     inline FileCaptureBlock* create_file_buffer();
     inline FileCaptureState save_to_file_buffer(const uint8_t* file_data, int data_size,
         int64_t max_size);
-    void write_file_data(uint8_t* buf, size_t buf_len, FILE* fh);
+    bool write_file_data(int fd, struct iovec* iov, int iov_cnt);
 
     static FileMemPool* file_mempool;
     static int64_t capture_block_size;
-    static std::mutex capture_mutex;
-    static std::condition_variable capture_cv;
-    static std::thread* file_storer;
-    static std::queue<FileCapture*> files_waiting;
-    static bool running;
+    static std::vector<FileWriter*> writers;
+    static std::atomic<bool> running;
 
     bool reserved;
     uint64_t capture_size;
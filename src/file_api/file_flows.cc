@@ -77,6 +77,16 @@ FileContext* FileFlows::get_current_file_context()
     return current_context;
 }
 
+bool FileFlows::needs_inspection()
+{
+    FileContext* context = get_current_file_context();
+
+    if ( context and context->is_processing() )
+        return true;
+
+    return main_context and main_context->is_processing();
+}
+
 uint32_t FileFlows::get_new_file_instance()
 {
     return max_file_id++;
@@ -108,6 +118,7 @@ FileContext* FileFlows::find_main_file_context(FilePosition pos, FileDirection d
 
     context = new FileContext;
     main_context = context;
+    context->config_signature_lanes(true);
     context->check_policy(flow, dir);
 
     if (!index)
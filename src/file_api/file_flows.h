@@ -64,6 +64,8 @@ public:
     bool file_process(uint64_t file_id, const uint8_t* file_data,
         int data_size, uint64_t offset, FileDirection);
 
+    bool needs_inspection() override;
+
     //void handle_retransmit(Packet*) override;
     static unsigned flow_id;
 
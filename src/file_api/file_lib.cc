@@ -29,12 +29,11 @@
 
 #include "file_lib.h"
 
-#include <openssl/sha.h>
-
 #include <iostream>
 #include <iomanip>
 
 #include "hash/hashes.h"
+#include "hash/sha256.h"
 #include "framework/data_bus.h"
 #include "main/snort_config.h"
 #include "managers/inspector_manager.h"
@@ -180,7 +179,7 @@ FileContext::FileContext ()
 FileContext::~FileContext ()
 {
     if (file_signature_context)
-        snort_free(file_signature_context);
+        delete file_signature_context;
     if (file_capture)
         stop_file_capture();
     if (file_segments)
@@ -423,33 +422,34 @@ void FileContext::process_file_signature_sha256(const uint8_t* file_data, int si
     switch (position)
     {
     case SNORT_FILE_START:
-        if (!file_signature_context)
-            file_signature_context = snort_calloc(sizeof(SHA256_CTX));
-        SHA256_Init((SHA256_CTX*)file_signature_context);
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        delete file_signature_context;
+        file_signature_context = new Sha256(signature_lanes);
+        file_signature_context->update(file_data, data_size);
         break;
     case SNORT_FILE_MIDDLE:
         if (!file_signature_context)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        file_signature_context->update(file_data, data_size);
         break;
     case SNORT_FILE_END:
         if (!file_signature_context)
             return;
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+        file_signature_context->update(file_data, data_size);
         sha256 = new uint8_t[SHA256_HASH_SIZE];
-        SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
+        file_signature_context->final(sha256);
+        delete file_signature_context;
+        file_signature_context = nullptr;
         file_state.sig_state = FILE_SIG_DONE;
         break;
     case SNORT_FILE_FULL:
-        if (!file_signature_context)
-            file_signature_context = snort_calloc(sizeof (SHA256_CTX));
-        SHA256_Init((SHA256_CTX*)file_signature_context);
-        SHA256_Update((SHA256_CTX*)file_signature_context, file_data, data_size);
+    {
+        Sha256 sha;
+        sha.update(file_data, data_size);
         sha256 = new uint8_t[SHA256_HASH_SIZE];
-        SHA256_Final(sha256, (SHA256_CTX*)file_signature_context);
+        sha.final(sha256);
         file_state.sig_state = FILE_SIG_DONE;
         break;
+    }
     default:
         break;
     }
@@ -521,6 +521,11 @@ void FileContext::config_file_signature(bool enabled)
     file_signature_enabled = enabled;
 }
 
+void FileContext::config_signature_lanes(bool enabled)
+{
+    signature_lanes = enabled and Sha256::lanes_enabled();
+}
+
 bool FileContext::is_file_signature_enabled()
 {
     return file_signature_enabled;
@@ -536,6 +541,12 @@ bool FileContext::is_file_capture_enabled()
     return file_capture_enabled;
 }
 
+bool FileContext::is_processing()
+{
+    return file_type_enabled or
+        (file_signature_enabled and file_state.sig_state != FILE_SIG_DEPTH_FAIL);
+}
+
 uint64_t FileContext::get_processed_bytes()
 {
     return processed_bytes;
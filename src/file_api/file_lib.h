@@ -35,6 +35,7 @@
 class FileCapture;
 class FileConfig;
 class FileSegments;
+class Sha256;
 class Flow;
 class FileInspect;
 
@@ -108,9 +109,15 @@ public:
     bool is_file_type_enabled();
     void config_file_signature(bool enabled);
     bool is_file_signature_enabled();
+    // Only for contexts that stay with one packet thread, whose signature
+    // may then be hashed alongside other files of that thread
+    void config_signature_lanes(bool enabled);
     void config_file_capture(bool enabled);
     bool is_file_capture_enabled();
 
+    // true until file type and signature are done or past their depths
+    bool is_processing();
+
     //File properties
     uint64_t get_processed_bytes();
 
@@ -122,9 +129,10 @@ private:
     bool file_type_enabled = false;
     bool file_signature_enabled = false;
     bool file_capture_enabled = false;
+    bool signature_lanes = false;
     uint64_t processed_bytes = 0;
     void* file_type_context;
-    void* file_signature_context;
+    Sha256* file_signature_context;
     FileConfig* file_config;
     FileInspect* inspector;
     FileCapture* file_capture;
@@ -34,36 +34,28 @@
 #include "log/messages.h"
 #include "utils/util.h"
 
+#ifdef UNIT_TEST
+#include <thread>
+#include <vector>
+
+#include "catch/catch.hpp"
+#endif
+
 /*This magic is used for double free detection*/
 
 #define FREE_MAGIC    0x2525252525252525
 typedef uint64_t MagicType;
 
+#define INDEX_MASK    0xffffffffULL
+#define TAG_INCREMENT 0x100000000ULL
+
 #ifdef DEBUG_MSGS
 void FileMemPool::verify()
 {
-    uint64_t free_size;
-    uint64_t release_size;
-
-    free_size = cbuffer_used(free_list);
-    release_size = cbuffer_used(released_list);
-
-    if (free_size > cbuffer_size(free_list))
-    {
-        ErrorMessage("%s(%d) file_mempool: failed to verify free list!\n",
-            __FILE__, __LINE__);
-    }
-
-    if (release_size > cbuffer_size(released_list))
-    {
-        ErrorMessage("%s(%d) file_mempool: failed to verify release list!\n",
-            __FILE__, __LINE__);
-    }
-
     /* The free mempool and size of release mempool should be smaller than
      * or equal to the size of mempool
      */
-    if (free_size + release_size > total)
+    if (freed() + released() > total)
     {
         ErrorMessage("%s(%d) file_mempool: failed to verify mempool size!\n",
             __FILE__, __LINE__);
@@ -80,8 +72,46 @@ void FileMemPool::free_pools()
         datapool = nullptr;
     }
 
-    cbuffer_free(free_list);
-    cbuffer_free(released_list);
+    delete[] next;
+    next = nullptr;
+}
+
+void FileMemPool::push(FreeStack& stack, uint32_t index)
+{
+    uint64_t head = stack.head.load(std::memory_order_relaxed);
+    uint64_t top;
+
+    // counted first so a racing pop never takes the count below zero
+    stack.count.fetch_add(1, std::memory_order_relaxed);
+
+    do
+    {
+        next[index].store((uint32_t)(head & INDEX_MASK), std::memory_order_relaxed);
+        top = ((head & ~INDEX_MASK) + TAG_INCREMENT) | (index + 1);
+    }
+    while (!stack.head.compare_exchange_weak(head, top,
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool FileMemPool::pop(FreeStack& stack, uint32_t& index)
+{
+    uint64_t head = stack.head.load(std::memory_order_acquire);
+    uint64_t top;
+
+    do
+    {
+        if (!(head & INDEX_MASK))
+            return false;
+
+        index = (uint32_t)(head & INDEX_MASK) - 1;
+        top = ((head & ~INDEX_MASK) + TAG_INCREMENT) |
+            next[index].load(std::memory_order_relaxed);
+    }
+    while (!stack.head.compare_exchange_weak(head, top,
+        std::memory_order_acquire, std::memory_order_acquire));
+
+    stack.count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
 }
 
 /*
@@ -93,51 +123,31 @@ void FileMemPool::free_pools()
 
 FileMemPool::FileMemPool(uint64_t num_objects, size_t o_size)
 {
-    unsigned int i;
-
-    if ((num_objects < 1) || (o_size < 1))
+    if ((num_objects < 1) || (o_size < sizeof(MagicType)))
         return;
 
-    obj_size = o_size;
-
-    // this is the basis pool that represents all the *data pointers in the list
-    datapool = (void**)snort_calloc(num_objects, obj_size);
-
-    /* sets up the memory list */
-    free_list = cbuffer_init(num_objects);
-    if (!free_list)
+    /* object indices must fit below the version tag */
+    if (num_objects >= INDEX_MASK)
     {
-        ErrorMessage("%s(%d) file_mempool: Failed to init free list\n",
+        ErrorMessage("%s(%d) file_mempool: Too many objects\n",
             __FILE__, __LINE__);
-        free_pools();
         return;
     }
 
-    released_list = cbuffer_init(num_objects);
-    if (!released_list)
-    {
-        ErrorMessage("%s(%d) file_mempool: "
-            "Failed to init release list\n", __FILE__, __LINE__);
-        free_pools();
-        return;
-    }
+    obj_size = o_size;
 
-    total = 0;
-    for (i=0; i<num_objects; i++)
-    {
-        void* data = ((char*)datapool) + (i * obj_size);
+    // this is the basis pool that represents all the *data pointers in the list
+    datapool = (void**)snort_calloc(num_objects, obj_size);
+    next = new std::atomic<uint32_t>[num_objects];
 
-        if (cbuffer_write(free_list,  data))
-        {
-            ErrorMessage("%s(%d) file_mempool: "
-                "Failed to add to free list\n",
-                __FILE__, __LINE__);
-            free_pools();
-            return;
-        }
+    /* sets up the memory list, lowest address on top */
+    for (uint64_t i = num_objects; i > 0; i--)
+    {
+        void* data = ((char*)datapool) + ((i - 1) * obj_size);
         *(MagicType*)data = FREE_MAGIC;
-        total++;
+        push(free_list, (uint32_t)(i - 1));
     }
+    total = num_objects;
 }
 
 /*
@@ -160,24 +170,26 @@ FileMemPool::~FileMemPool()
 
 void* FileMemPool::m_alloc()
 {
-    void* b = nullptr;
+    uint32_t index;
 
-    std::lock_guard<std::mutex> lock(pool_mutex);
-
-    if (cbuffer_read(free_list, &b))
+    if (!pop(free_list, index))
     {
-        if (cbuffer_read(released_list, &b))
+        if (!pop(released_list, index))
         {
             return nullptr;
         }
     }
 
+    void* b = ((char*)datapool) + ((uint64_t)index * obj_size);
+
     if (*(MagicType*)b != FREE_MAGIC)
     {
         ErrorMessage("%s(%d) file_mempool_alloc(): Allocation errors! \n",
             __FILE__, __LINE__);
     }
 
+    *(MagicType*)b = 0;
+
     DEBUG_WRAP(verify(); );
 
     return b;
@@ -185,17 +197,18 @@ void* FileMemPool::m_alloc()
 
 /*
  * Free a new object from the buffer
- * We use circular buffer to synchronize one reader and one writer
+ * The magic is checked before the object is pushed so a double free
+ * can't put the same object on a stack twice
  */
-int FileMemPool::remove(CircularBuffer* cb, void* obj)
+int FileMemPool::remove(FreeStack& stack, void* obj)
 {
     if (obj == nullptr)
         return FILE_MEM_FAIL;
 
-    if (cbuffer_write(cb, obj))
-    {
+    uint64_t offset = (char*)obj - (char*)datapool;
+
+    if ((obj < (void*)datapool) || (offset >= total * obj_size) || (offset % obj_size))
         return FILE_MEM_FAIL;
-    }
 
     if (*(MagicType*)obj == FREE_MAGIC)
     {
@@ -205,14 +218,13 @@ int FileMemPool::remove(CircularBuffer* cb, void* obj)
     }
 
     *(MagicType*)obj = FREE_MAGIC;
+    push(stack, (uint32_t)(offset / obj_size));
 
     return FILE_MEM_SUCCESS;
 }
 
 int FileMemPool::m_free(void* obj)
 {
-    std::lock_guard<std::mutex> lock(pool_mutex);
-
     int ret = remove(free_list, obj);
 
     DEBUG_WRAP(verify(); );
@@ -229,8 +241,6 @@ int FileMemPool::m_free(void* obj)
 
 int FileMemPool::m_release(void* obj)
 {
-    std::lock_guard<std::mutex> lock(pool_mutex);
-
     /*A writer that might from different thread*/
     int ret = remove(released_list, obj);
 
@@ -243,18 +253,95 @@ int FileMemPool::m_release(void* obj)
 uint64_t FileMemPool::allocated()
 {
     uint64_t total_freed = released() + freed();
-    return (total - total_freed);
+    return (total > total_freed) ? (total - total_freed) : 0;
 }
 
 /* Returns number of elements freed in current buffer*/
 uint64_t FileMemPool::freed()
 {
-    return (cbuffer_used(free_list));
+    return free_list.count.load(std::memory_order_relaxed);
 }
 
 /* Returns number of elements released in current buffer*/
 uint64_t FileMemPool::released()
 {
-    return (cbuffer_used(released_list));
+    return released_list.count.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("file mempool alloc and free", "[FileMemPool]")
+{
+    FileMemPool pool(4, 64);
+    void* objs[4];
+
+    for (auto& obj : objs)
+    {
+        obj = pool.m_alloc();
+        CHECK(obj != nullptr);
+    }
+    CHECK(pool.m_alloc() == nullptr);
+    CHECK(pool.allocated() == 4);
+
+    CHECK(pool.m_free(objs[0]) == FILE_MEM_SUCCESS);
+    CHECK(pool.m_release(objs[1]) == FILE_MEM_SUCCESS);
+    CHECK(pool.freed() == 1);
+    CHECK(pool.released() == 1);
+
+    // double free and foreign pointers are rejected
+    CHECK(pool.m_free(objs[0]) == FILE_MEM_FAIL);
+    CHECK(pool.m_release(objs[0]) == FILE_MEM_FAIL);
+    CHECK(pool.m_free((char*)objs[2] + 1) == FILE_MEM_FAIL);
+    CHECK(pool.freed() == 1);
+
+    // freed objects are used before released ones
+    CHECK(pool.m_alloc() == objs[0]);
+    CHECK(pool.m_alloc() == objs[1]);
+    CHECK(pool.m_alloc() == nullptr);
+}
+
+TEST_CASE("file mempool threads", "[FileMemPool]")
+{
+    const unsigned num_threads = 4;
+    const unsigned num_loops = 20000;
+
+    FileMemPool pool(16, 64);
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> errors { 0 };
+
+    for (unsigned t = 0; t < num_threads; t++)
+    {
+        threads.emplace_back([&pool, &errors, t]()
+            {
+                for (unsigned i = 0; i < num_loops; i++)
+                {
+                    uint64_t* obj = (uint64_t*)pool.m_alloc();
+                    if (!obj)
+                        continue;
+
+                    // nobody else may hold this object
+                    obj[1] = t;
+                    std::this_thread::yield();
+                    if (obj[1] != t)
+                        errors++;
+
+                    if ((i & 1 ? pool.m_release(obj) : pool.m_free(obj)) != FILE_MEM_SUCCESS)
+                        errors++;
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(errors == 0);
+    CHECK(pool.allocated() == 0);
+    CHECK(pool.freed() + pool.released() == 16);
 }
 
+#endif
+
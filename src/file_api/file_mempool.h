@@ -23,17 +23,15 @@
 #define FILE_MEMPOOL_H
 
 //  This mempool implementation has very efficient alloc/free operations.
-//  In addition, it provides thread-safe alloc/free for one allocation/free
-//  thread and one release thread.
+//  Free objects are kept on two lock free stacks, one for objects freed by
+//  the packet thread and one for objects released by a file writer thread.
+//  Any number of threads may allocate, free and release concurrently.
 //  One more bonus: Double free detection is also added into this library
-//  This is a thread safe version of memory pool for one writer and one reader thread
 
-#include <mutex>
+#include <atomic>
 
 #include "main/snort_debug.h"
 
-#include "circular_buffer.h"
-
 #define FILE_MEM_SUCCESS    0  // FIXIT-L use bool
 #define FILE_MEM_FAIL      -1
 
@@ -49,11 +47,11 @@ public:
     // Returns: a pointer to the FileMemPool object on success, nullptr on failure
     void* m_alloc();
 
-    // This must be called by the same thread calling file_mempool_alloc()
+    // Return an object that was never handed to a writer thread
     // Return: FILE_MEM_SUCCESS or FILE_MEM_FAIL
     int m_free(void* obj);
 
-    // This can be called by a different thread calling file_mempool_alloc()
+    // Return an object once it has been stored; may be called from any thread
     // Return: FILE_MEM_SUCCESS or FILE_MEM_FAIL
     int m_release(void* obj);
 
@@ -71,18 +69,29 @@ public:
 
 private:
 
+    // Treiber stack of object indices. The head packs a version tag above
+    // the index + 1 so a pop racing with a pop and push of the same object
+    // fails its compare and retries instead of corrupting the list.
+    struct FreeStack
+    {
+        std::atomic<uint64_t> head { 0 };
+        std::atomic<uint64_t> count { 0 };
+    };
+
     void free_pools();
-    int remove(CircularBuffer* cb, void* obj);
+    void push(FreeStack&, uint32_t index);
+    bool pop(FreeStack&, uint32_t& index);
+    int remove(FreeStack&, void* obj);
 #ifdef DEBUG_MSGS
     void verify();
 #endif
 
-    void** datapool; /* memory buffer */
-    uint64_t total;
-    CircularBuffer* free_list;
-    CircularBuffer* released_list;
-    size_t obj_size;
-    std::mutex pool_mutex;
+    void** datapool = nullptr; /* memory buffer */
+    std::atomic<uint32_t>* next = nullptr;  /* index + 1 of the next free object */
+    uint64_t total = 0;
+    FreeStack free_list;
+    FreeStack released_list;
+    size_t obj_size = 0;
 };
 
 #endif
@@ -29,6 +29,7 @@
 
 #include "file_module.h"
 
+#include "hash/sha256.h"
 #include "main/snort_config.h"
 
 #include "file_stats.h"
@@ -141,6 +142,9 @@ static const Parameter file_id_params[] =
     { "capture_block_size", Parameter::PT_INT, "8:", "32768",
       "file capture block size in bytes" },
 
+    { "capture_writers", Parameter::PT_INT, "1:32", "1",
+      "number of threads storing captured files to disk" },
+
     { "max_files_cached", Parameter::PT_INT, "8:", "65536",
       "maximal number of files cached in memory" },
 
@@ -150,6 +154,10 @@ static const Parameter file_id_params[] =
     { "enable_signature", Parameter::PT_BOOL, nullptr, "false",
       "enable signature calculation" },
 
+    { "signature_lanes", Parameter::PT_BOOL, nullptr, "false",
+      "hash files of several flows together with AVX2 when the CPU lacks the SHA extensions; "
+      "uses 2 KiB per file being hashed" },
+
     { "enable_capture", Parameter::PT_BOOL, nullptr, "false",
       "enable file capture" },
 
@@ -179,6 +187,10 @@ static const PegInfo file_pegs[] =
     { "total_files", "number of files processed" },
     { "total_file_data", "number of file data bytes processed" },
     { "cache_failures", "number of file cache add failures" },
+    { "sha256_openssl_bytes", "number of bytes hashed by OpenSSL" },
+    { "sha256_sha_ext_bytes", "number of bytes hashed with the SHA extensions" },
+    { "sha256_lane_bytes", "number of bytes hashed in AVX2 lanes" },
+    { "sha256_lane_batches", "number of times eight files were hashed together" },
     { nullptr, nullptr }
 };
 
@@ -198,6 +210,12 @@ PegCount* FileIdModule::get_counts() const
 
 void FileIdModule::sum_stats(bool accumulate_now_stats)
 {
+    file_counts.sha256_openssl_bytes += sha256_stats.openssl_bytes;
+    file_counts.sha256_sha_ext_bytes += sha256_stats.sha_ext_bytes;
+    file_counts.sha256_lane_bytes += sha256_stats.lane_bytes;
+    file_counts.sha256_lane_batches += sha256_stats.lane_batches;
+    memset(&sha256_stats, 0, sizeof(sha256_stats));
+
     file_stats_sum();
     Module::sum_stats(accumulate_now_stats);
 }
@@ -236,6 +254,9 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("capture_block_size") )
         fc->capture_block_size = v.get_long();
 
+    else if ( v.is("capture_writers") )
+        fc->capture_writers = v.get_long();
+
     else if ( v.is("max_files_cached") )
         fc->max_files_cached = v.get_long();
 
@@ -253,6 +274,9 @@ bool FileIdModule::set(const char*, Value& v, SnortConfig*)
             fp.set_file_signature(true);
         }
     }
+    else if ( v.is("signature_lanes") )
+        fc->signature_lanes = v.get_bool();
+
     else if ( v.is("enable_capture") )
     {
         if ( v.get_bool() )
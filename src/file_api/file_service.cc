@@ -29,6 +29,7 @@
 
 #include "file_service.h"
 
+#include "hash/sha256.h"
 #include "main/snort_config.h"
 #include "mime/file_mime_process.h"
 
@@ -58,8 +59,11 @@ void FileService::post_init()
     if (!conf)
         return;
 
+    Sha256::enable_lanes(conf->signature_lanes);
+
     if (file_capture_enabled)
-        FileCapture::init(conf->capture_memcap, conf->capture_block_size);
+        FileCapture::init(conf->capture_memcap, conf->capture_block_size,
+            conf->capture_writers);
 }
 
 void FileService::close()
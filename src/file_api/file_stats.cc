@@ -30,6 +30,7 @@
 
 #include "file_stats.h"
 
+#include "hash/sha256.h"
 #include "log/messages.h"
 #include "utils/stats.h"
 #include "utils/util.h"
@@ -165,6 +166,9 @@ void file_stats_print()
     LogMessage("            Total          " FMTu64("-10") " " FMTu64("-10") " \n",
         processed_total[0], processed_total[1]);
 
+    LogMessage("SHA-256 by %s%s\n", Sha256::get_backend_name(),
+        Sha256::lanes_enabled() ? " and AVX2 lanes" : "");
+
 #if 0
     LogLabel("file type verdicts");  // FIXIT-L what's up with this code
 
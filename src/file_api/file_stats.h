@@ -37,6 +37,10 @@ struct FileCounts
     PegCount files_total;
     PegCount file_data_total;
     PegCount cache_add_fails;
+    PegCount sha256_openssl_bytes;
+    PegCount sha256_sha_ext_bytes;
+    PegCount sha256_lane_bytes;
+    PegCount sha256_lane_batches;
     PegCount files_buffered_total;
     PegCount files_released_total;
     PegCount files_freed_total;
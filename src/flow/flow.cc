@@ -26,6 +26,7 @@
 #include "flow/ha.h"
 #include "flow/session.h"
 #include "ips_options/ips_flowbits.h"
+#include "latency/flow_cpu.h"
 #include "protocols/packet.h"
 #include "sfip/sf_ip.h"
 #include "utils/bitop.h"
@@ -159,6 +160,9 @@ void Flow::reset(bool do_cleanup)
     if ( ha_state )
         ha_state->reset();
 
+    if ( cpu_ticks )
+        FlowCpu::release(this);
+
     constexpr size_t offset = offsetof(Flow, flow_data);
     // FIXIT-L need a struct to zero here to make future proof
     memset((uint8_t*)this+offset, 0, sizeof(Flow)-offset);
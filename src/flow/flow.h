@@ -120,6 +120,12 @@ public:
     virtual void handle_retransmit(Packet*) { }
     virtual void handle_eof(Packet*) { }
 
+    // true while the inspector still has data to see within its depth
+    // limits; a flow past stream.trust_bytes is trusted only once this is
+    // false for all of its flow data.  inspectors that don't say otherwise
+    // keep the flow untrusted.
+    virtual bool needs_inspection() { return true; }
+
 public:  // FIXIT-L privatize
     FlowData* next;
     FlowData* prev;
@@ -153,6 +159,14 @@ public:
         RESET,
         ALLOW
     };
+    // why inspection of the flow was stopped and the DAQ told to whitelist it
+    enum class TrustReason : uint8_t
+    {
+        NONE = 0,
+        BINDER,     // allowed when the flow was set up
+        INSPECTOR,  // Stream::stop_inspection()
+        ELEPHANT    // stream.trust_bytes reached with no inspector interested
+    };
     Flow();
     ~Flow();
 
@@ -327,6 +341,8 @@ public:  // FIXIT-M privatize if possible
     const char* service;
 
     uint64_t expire_time;
+    uint64_t payload_bytes;  // wire packet payload in both directions
+    uint64_t cpu_ticks;  // inspection and detection time when latency.flow.top is set
 
     SfIp client_ip;
     SfIp server_ip;
@@ -338,6 +354,7 @@ public:  // FIXIT-M privatize if possible
     AppId application_ids[APP_PROTOID_MAX];
 
     FlowState flow_state;
+    TrustReason trust_reason;
     unsigned policy_id;
 
     int32_t iface_in;
@@ -348,6 +365,7 @@ public:  // FIXIT-M privatize if possible
 
     uint16_t ssn_policy;
     uint16_t session_state;
+    uint16_t cpu_slot;  // 1 based position in the thread's top flows; 0 = none
 
     uint8_t inner_client_ttl, inner_server_ttl;
     uint8_t outer_client_ttl, outer_server_ttl;
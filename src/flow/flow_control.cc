@@ -70,6 +70,8 @@ static THREAD_LOCAL PegCount tcp_count = 0;
 static THREAD_LOCAL PegCount udp_count = 0;
 static THREAD_LOCAL PegCount user_count = 0;
 static THREAD_LOCAL PegCount file_count = 0;
+static THREAD_LOCAL PegCount elephant_count = 0;
+static THREAD_LOCAL PegCount trusted_count = 0;
 
 PegCount FlowControl::get_flows(PktType type)
 {
@@ -97,11 +99,18 @@ PegCount FlowControl::get_prunes(PktType type, PruneReason reason) const
     return cache ? cache->get_prunes(reason) : 0;
 }
 
+PegCount FlowControl::get_elephants() const
+{ return elephant_count; }
+
+PegCount FlowControl::get_trusted() const
+{ return trusted_count; }
+
 void FlowControl::clear_counts()
 {
     ip_count = icmp_count = 0;
     tcp_count = udp_count = 0;
     user_count = file_count = 0;
+    elephant_count = trusted_count = 0;
 
     FlowCache* cache;
 
@@ -441,12 +450,17 @@ unsigned FlowControl::process(Flow* flow, Packet* p)
     case Flow::FlowState::INSPECT:
         assert(flow->ssn_client);
         assert(flow->ssn_server);
-        flow->session->process(p);
+
+        if ( !trust_elephant(flow, p) )
+            flow->session->process(p);
         break;
 
     case Flow::FlowState::ALLOW:
         if ( news )
+        {
+            flow->trust_reason = Flow::TrustReason::BINDER;
             Stream::stop_inspection(flow, p, SSN_DIR_BOTH, -1, 0);
+        }
         else
             DisableInspection();
 
@@ -476,6 +490,40 @@ unsigned FlowControl::process(Flow* flow, Packet* p)
     return news;
 }
 
+// flows past trust_bytes are trusted as soon as none of their inspectors
+// needs more data.  queued data is flushed, the flow data is released, and
+// the wire packet is marked so the DAQ whitelists the rest of the flow.
+// this runs before the packet reaches the session so that the previous
+// packet has been completely processed when the flow data goes away.
+bool FlowControl::trust_elephant(Flow* flow, Packet* p)
+{
+    if ( !trust_bytes or (p->packet_flags & PKT_PSEUDO) )
+        return false;
+
+    uint64_t before = flow->payload_bytes;
+    flow->payload_bytes += p->dsize;
+
+    if ( flow->payload_bytes < trust_bytes )
+        return false;
+
+    if ( before < trust_bytes )
+        ++elephant_count;
+
+    for ( FlowData* fd = flow->flow_data; fd; fd = fd->next )
+    {
+        if ( fd->needs_inspection() )
+            return false;
+    }
+
+    flow->trust_reason = Flow::TrustReason::ELEPHANT;
+    Stream::stop_inspection(flow, p, SSN_DIR_BOTH, -1, 0);
+    flow->free_flow_data();
+
+    p->ptrs.decode_flags |= DECODE_PKT_TRUST;
+    ++trusted_count;
+    return true;
+}
+
 //-------------------------------------------------------------------------
 // ip
 //-------------------------------------------------------------------------
@@ -66,6 +66,8 @@ public:
     void init_user(const FlowConfig&, InspectSsnFunc);
     void init_file(const FlowConfig&, InspectSsnFunc);
     void init_exp(uint32_t max);
+    void init_trust(uint64_t bytes)
+    { trust_bytes = bytes; }
 
     void delete_flow(const FlowKey*);
     void delete_flow(Flow*, PruneReason);
@@ -92,6 +94,8 @@ public:
     PegCount get_flows(PktType);
     PegCount get_total_prunes(PktType) const;
     PegCount get_prunes(PktType, PruneReason) const;
+    PegCount get_elephants() const;
+    PegCount get_trusted() const;
 
     void clear_counts();
 
@@ -102,6 +106,7 @@ private:
     void set_key(FlowKey*, Packet*);
 
     unsigned process(Flow*, Packet*);
+    bool trust_elephant(Flow*, Packet*);
     void preemptive_cleanup();
 
 private:
@@ -129,6 +134,7 @@ private:
 
     class ExpectCache* exp_cache = nullptr;
     PktType last_pkt_type = PktType::NONE;
+    uint64_t trust_bytes = 0;
 
     std::vector<PktType> types;
     unsigned next = 0;
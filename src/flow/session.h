@@ -57,6 +57,7 @@ public:
 
     virtual void set_splitter(bool /*c2s*/, StreamSplitter*) { }
     virtual StreamSplitter* get_splitter(bool /*c2s*/) { return nullptr; }
+    virtual void set_header_only(bool /*c2s*/, StreamSplitter*) { }
 
     virtual void set_extra_data(Packet*, uint32_t /*flag*/) { }
     virtual void clear_extra_data(Packet*, uint32_t /*flag*/) { }
@@ -29,7 +29,8 @@
 
 // this is the current version of the base api
 // must be prefixed to subtype version
-#define BASE_API_VERSION 1
+// 2: Module::get_count_types() added (changes the Module vtable)
+#define BASE_API_VERSION 2
 
 // set options to API_OPTIONS to ensure compatibility
 #ifndef API_OPTIONS
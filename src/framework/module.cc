@@ -131,9 +131,9 @@ void Module::sum_stats_helper(bool accumulate_now_stats, const CountType* const
     }
 }
 
-void Module::sum_stats(bool)
+void Module::sum_stats(bool accumulate_now_stats)
 {
-    sum_stats_helper(false, nullptr);
+    sum_stats_helper(accumulate_now_stats, get_count_types());
 }
 
 void Module::show_interval_stats(IndexVec& peg_idxs, FILE* fh)
@@ -135,6 +135,10 @@ public:
     virtual int get_num_counts() const
     { return num_counts; }
 
+    // one per count; nullptr if all are CountType::SUM
+    virtual const CountType* get_count_types() const
+    { return nullptr; }
+
     virtual ProfileStats* get_profile() const
     { return nullptr; }
 
@@ -58,6 +58,12 @@ int Mpse::search(
     return ret;
 }
 
+void Mpse::searched(int n)
+{
+    if ( inc_global_counter )
+        s_bcnt += n;
+}
+
 int Mpse::search_all(
     const unsigned char* T, int n, MpseMatch match,
     void* context, int* current_state)
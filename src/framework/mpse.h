@@ -71,6 +71,15 @@ public:
     virtual int search_all(
         const uint8_t* T, int n, MpseMatch, void* context, int* current_state);
 
+    // RegexOffload searches the chunks of a split buffer, possibly on other
+    // threads, the same way search() does; the packet thread then accounts
+    // for the whole buffer with searched()
+    int search_chunk(
+        const uint8_t* T, int n, MpseMatch match, void* context, int* current_state)
+    { return _search(T, n, match, context, current_state); }
+
+    void searched(int n);
+
     virtual void set_opt(int) { }
     virtual int print_info() { return 0; }
     virtual int get_pattern_count() { return 0; }
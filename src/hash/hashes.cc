@@ -26,12 +26,13 @@
 #include <openssl/md5.h>
 #include <openssl/sha.h>
 
+#include "sha256.h"
+
 void sha256(const unsigned char* data, size_t size, unsigned char* digest)
 {
-    SHA256_CTX c;
-    SHA256_Init(&c);
-    SHA256_Update(&c, data, size);
-    SHA256_Final(digest, &c);
+    Sha256 c;
+    c.update(data, size);
+    c.final(digest);
 }
 
 void sha512(const unsigned char* data, size_t size, unsigned char* digest)
@@ -0,0 +1,478 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sha256.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sha256.h"
+
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "utils/util.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+THREAD_LOCAL Sha256Stats sha256_stats;
+
+static const uint32_t sha256_init[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t sha256_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+//-------------------------------------------------------------------------
+// block functions
+//-------------------------------------------------------------------------
+
+// whole blocks go straight to the OpenSSL block function without buffering
+static void openssl_blocks(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    SHA256_CTX c;
+    SHA256_Init(&c);
+    memcpy(c.h, state, sizeof(c.h));
+    SHA256_Update(&c, data, blocks * SHA256_BLOCK_SIZE);
+    memcpy(state, c.h, sizeof(c.h));
+}
+
+#ifdef SHA256_X86
+
+__attribute__((target("sha,sse4.1")))
+static void sha_ext_blocks(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // the round instructions want the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xB1);
+    __m128i cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1B);
+    __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+
+// four rounds; the message words for rounds 16 and up are made from the last 16
+#define SHA_EXT_ROUNDS(q) \
+    do { \
+        if ( q < 4 ) \
+            w[q] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * q)), swap); \
+        else \
+        { \
+            __m128i t = _mm_alignr_epi8(w[(q - 1) & 3], w[(q - 2) & 3], 4); \
+            t = _mm_add_epi32(_mm_sha256msg1_epu32(w[q & 3], w[(q - 3) & 3]), t); \
+            w[q & 3] = _mm_sha256msg2_epu32(t, w[(q - 1) & 3]); \
+        } \
+        __m128i msg = _mm_add_epi32(w[q & 3], \
+            _mm_loadu_si128((const __m128i*)(sha256_k + 4 * q))); \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg); \
+        msg = _mm_shuffle_epi32(msg, 0x0E); \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, msg); \
+    } while ( 0 )
+
+    while ( blocks-- )
+    {
+        const __m128i abef_save = abef;
+        const __m128i cdgh_save = cdgh;
+        __m128i w[4];
+
+        SHA_EXT_ROUNDS(0);  SHA_EXT_ROUNDS(1);  SHA_EXT_ROUNDS(2);  SHA_EXT_ROUNDS(3);
+        SHA_EXT_ROUNDS(4);  SHA_EXT_ROUNDS(5);  SHA_EXT_ROUNDS(6);  SHA_EXT_ROUNDS(7);
+        SHA_EXT_ROUNDS(8);  SHA_EXT_ROUNDS(9);  SHA_EXT_ROUNDS(10); SHA_EXT_ROUNDS(11);
+        SHA_EXT_ROUNDS(12); SHA_EXT_ROUNDS(13); SHA_EXT_ROUNDS(14); SHA_EXT_ROUNDS(15);
+
+        abef = _mm_add_epi32(abef, abef_save);
+        cdgh = _mm_add_epi32(cdgh, cdgh_save);
+        data += SHA256_BLOCK_SIZE;
+    }
+
+#undef SHA_EXT_ROUNDS
+
+    tmp = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, cdgh, 0xF0));
+    _mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(cdgh, tmp, 8));
+}
+
+// one stream per 32 bit lane, every stream has the same number of blocks
+__attribute__((target("avx2")))
+static void avx2_lane_blocks(uint32_t* state[], const uint8_t* data[], size_t blocks)
+{
+    const __m256i swap = _mm256_set_epi64x(
+        0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+        0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+#define ROR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define ADD(x, y) _mm256_add_epi32(x, y)
+#define XOR(x, y) _mm256_xor_si256(x, y)
+
+    __m256i s[8];
+
+    for ( unsigned i = 0; i < 8; ++i )
+        s[i] = _mm256_set_epi32(state[7][i], state[6][i], state[5][i], state[4][i],
+            state[3][i], state[2][i], state[1][i], state[0][i]);
+
+    for ( size_t off = 0; off < blocks * SHA256_BLOCK_SIZE; off += SHA256_BLOCK_SIZE )
+    {
+        __m256i w[16];
+
+        // transpose 8 words of each stream into one vector per word
+        for ( unsigned half = 0; half < 2; ++half )
+        {
+            __m256i r[8], t[8], u[8];
+
+            for ( unsigned i = 0; i < 8; ++i )
+                r[i] = _mm256_loadu_si256((const __m256i*)(data[i] + off + 32 * half));
+
+            for ( unsigned i = 0; i < 8; i += 2 )
+            {
+                t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+                t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+            }
+            for ( unsigned i = 0; i < 8; i += 4 )
+            {
+                u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+                u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+                u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+                u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+            }
+            for ( unsigned i = 0; i < 4; ++i )
+            {
+                w[8 * half + i] = _mm256_shuffle_epi8(
+                    _mm256_permute2x128_si256(u[i], u[i + 4], 0x20), swap);
+                w[8 * half + i + 4] = _mm256_shuffle_epi8(
+                    _mm256_permute2x128_si256(u[i], u[i + 4], 0x31), swap);
+            }
+        }
+
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+        __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+
+        for ( unsigned t = 0; t < 64; ++t )
+        {
+            if ( t >= 16 )
+            {
+                const __m256i w15 = w[(t - 15) & 15];
+                const __m256i w2 = w[(t - 2) & 15];
+                const __m256i s0 = XOR(XOR(ROR(w15, 7), ROR(w15, 18)), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = XOR(XOR(ROR(w2, 17), ROR(w2, 19)), _mm256_srli_epi32(w2, 10));
+                w[t & 15] = ADD(ADD(w[t & 15], s0), ADD(w[(t - 7) & 15], s1));
+            }
+            const __m256i ch = XOR(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            const __m256i t1 = ADD(ADD(ADD(h, XOR(XOR(ROR(e, 6), ROR(e, 11)), ROR(e, 25))),
+                ADD(ch, _mm256_set1_epi32(sha256_k[t]))), w[t & 15]);
+            const __m256i t2 = ADD(XOR(XOR(ROR(a, 2), ROR(a, 13)), ROR(a, 22)), maj);
+
+            h = g; g = f; f = e; e = ADD(d, t1);
+            d = c; c = b; b = a; a = ADD(t1, t2);
+        }
+
+        s[0] = ADD(s[0], a); s[1] = ADD(s[1], b); s[2] = ADD(s[2], c); s[3] = ADD(s[3], d);
+        s[4] = ADD(s[4], e); s[5] = ADD(s[5], f); s[6] = ADD(s[6], g); s[7] = ADD(s[7], h);
+    }
+
+#undef ROR
+#undef ADD
+#undef XOR
+
+    for ( unsigned i = 0; i < 8; ++i )
+    {
+        uint32_t v[8];
+        _mm256_storeu_si256((__m256i*)v, s[i]);
+
+        for ( unsigned j = 0; j < 8; ++j )
+            state[j][i] = v[j];
+    }
+}
+
+static bool cpu_has_sha_ext()
+{
+    unsigned a, b, c, d;
+
+    if ( !__get_cpuid(1, &a, &b, &c, &d) or !(c & bit_SSE4_1) )
+        return false;
+
+    if ( __get_cpuid_max(0, nullptr) < 7 )
+        return false;
+
+    __cpuid_count(7, 0, a, b, c, d);
+    return (b & (1 << 29)) != 0;
+}
+
+static bool cpu_has_avx2()
+{
+    unsigned a, b, c, d;
+
+    if ( !__get_cpuid(1, &a, &b, &c, &d) or !(c & bit_OSXSAVE) )
+        return false;
+
+    // the OS must save the upper halves of the vector registers
+    unsigned lo, hi;
+    __asm__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+
+    if ( (lo & 6) != 6 or __get_cpuid_max(0, nullptr) < 7 )
+        return false;
+
+    __cpuid_count(7, 0, a, b, c, d);
+    return (b & bit_AVX2) != 0;
+}
+
+#else
+
+static bool cpu_has_sha_ext()
+{ return false; }
+
+static bool cpu_has_avx2()
+{ return false; }
+
+#endif
+
+//-------------------------------------------------------------------------
+// backend selection
+//-------------------------------------------------------------------------
+
+static const bool use_sha_ext = cpu_has_sha_ext();
+static const bool have_lanes = cpu_has_avx2();
+static bool use_lanes = false;
+
+static inline void hash_blocks(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+#ifdef SHA256_X86
+    if ( use_sha_ext )
+    {
+        sha_ext_blocks(state, data, blocks);
+        sha256_stats.sha_ext_bytes += blocks * SHA256_BLOCK_SIZE;
+        return;
+    }
+#endif
+    openssl_blocks(state, data, blocks);
+    sha256_stats.openssl_bytes += blocks * SHA256_BLOCK_SIZE;
+}
+
+// one stream with the SHA extensions outruns eight lanes
+void Sha256::enable_lanes(bool enable)
+{ use_lanes = enable and have_lanes and !use_sha_ext; }
+
+bool Sha256::lanes_enabled()
+{ return use_lanes; }
+
+const char* Sha256::get_backend_name()
+{ return use_sha_ext ? "sha_ext" : "openssl"; }
+
+//-------------------------------------------------------------------------
+// streams
+//-------------------------------------------------------------------------
+
+// streams of this thread with a full backlog
+static THREAD_LOCAL Sha256* waiting[SHA256_LANES];
+static THREAD_LOCAL unsigned num_waiting = 0;
+
+Sha256::Sha256(bool mb)
+{
+    memcpy(state, sha256_init, sizeof(state));
+    multi_buffer = mb and use_lanes;
+    backlog = multi_buffer ? nullptr : block;
+}
+
+Sha256::~Sha256()
+{
+    leave_lanes();
+
+    if ( multi_buffer and backlog )
+        snort_free(backlog);
+}
+
+void Sha256::update(const uint8_t* data, size_t len)
+{
+    length += len;
+
+    if ( multi_buffer )
+    {
+        if ( !backlog )
+            backlog = (uint8_t*)snort_alloc(SHA256_BACKLOG);
+
+        while ( len )
+        {
+            if ( used == SHA256_BACKLOG )
+                hash_backlog();
+
+            size_t n = std::min(len, (size_t)(SHA256_BACKLOG - used));
+            memcpy(backlog + used, data, n);
+            used += n;
+            data += n;
+            len -= n;
+
+            if ( used >= SHA256_LANE_MIN )
+                join_lanes();
+        }
+        return;
+    }
+
+    if ( used )
+    {
+        size_t n = std::min(len, (size_t)(SHA256_BLOCK_SIZE - used));
+        memcpy(block + used, data, n);
+        used += n;
+        data += n;
+        len -= n;
+
+        if ( used < SHA256_BLOCK_SIZE )
+            return;
+
+        hash_blocks(state, block, 1);
+        used = 0;
+    }
+
+    size_t blocks = len / SHA256_BLOCK_SIZE;
+
+    if ( blocks )
+    {
+        hash_blocks(state, data, blocks);
+        data += blocks * SHA256_BLOCK_SIZE;
+        len -= blocks * SHA256_BLOCK_SIZE;
+    }
+
+    if ( len )
+    {
+        memcpy(block, data, len);
+        used = len;
+    }
+}
+
+void Sha256::final(uint8_t* digest)
+{
+    if ( multi_buffer and backlog )
+        hash_backlog();
+
+    // at most one partial block is left
+    uint8_t pad[2 * SHA256_BLOCK_SIZE] = { };
+    unsigned n = (used < SHA256_BLOCK_SIZE - 8) ? SHA256_BLOCK_SIZE : 2 * SHA256_BLOCK_SIZE;
+    uint64_t bits = length * 8;
+
+    if ( used )
+        memcpy(pad, backlog, used);
+    pad[used] = 0x80;
+
+    for ( unsigned i = 1; i <= 8; ++i, bits >>= 8 )
+        pad[n - i] = (uint8_t)bits;
+
+    hash_blocks(state, pad, n / SHA256_BLOCK_SIZE);
+
+    for ( unsigned i = 0; i < 8; ++i )
+    {
+        digest[4 * i] = (uint8_t)(state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)state[i];
+    }
+
+    memcpy(state, sha256_init, sizeof(state));
+    length = 0;
+    used = 0;
+}
+
+// hash the whole blocks of the backlog alone
+void Sha256::hash_backlog()
+{
+    leave_lanes();
+
+    unsigned blocks = used / SHA256_BLOCK_SIZE;
+
+    if ( !blocks )
+        return;
+
+    hash_blocks(state, backlog, blocks);
+    used -= blocks * SHA256_BLOCK_SIZE;
+    memmove(backlog, backlog + blocks * SHA256_BLOCK_SIZE, used);
+}
+
+void Sha256::join_lanes()
+{
+    if ( slot >= 0 )
+        return;
+
+    slot = num_waiting;
+    waiting[num_waiting++] = this;
+
+    if ( num_waiting == SHA256_LANES )
+        run_lanes();
+}
+
+void Sha256::leave_lanes()
+{
+    if ( slot < 0 )
+        return;
+
+    if ( (unsigned)slot != --num_waiting )
+    {
+        waiting[slot] = waiting[num_waiting];
+        waiting[slot]->slot = slot;
+    }
+    slot = -1;
+}
+
+// every waiting stream has at least half a backlog
+void Sha256::run_lanes()
+{
+#ifdef SHA256_X86
+    uint32_t* states[SHA256_LANES];
+    const uint8_t* data[SHA256_LANES];
+    unsigned blocks = SHA256_BACKLOG / SHA256_BLOCK_SIZE;
+
+    for ( unsigned i = 0; i < SHA256_LANES; ++i )
+    {
+        states[i] = waiting[i]->state;
+        data[i] = waiting[i]->backlog;
+        blocks = std::min(blocks, waiting[i]->used / SHA256_BLOCK_SIZE);
+    }
+
+    avx2_lane_blocks(states, data, blocks);
+
+    for ( unsigned i = 0; i < SHA256_LANES; ++i )
+    {
+        Sha256* s = waiting[i];
+        s->used -= blocks * SHA256_BLOCK_SIZE;
+        memmove(s->backlog, s->backlog + blocks * SHA256_BLOCK_SIZE, s->used);
+        s->slot = -1;
+    }
+    num_waiting = 0;
+
+    sha256_stats.lane_bytes += SHA256_LANES * blocks * SHA256_BLOCK_SIZE;
+    sha256_stats.lane_batches++;
+#endif
+}
+
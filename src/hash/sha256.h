@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sha256.h
+
+#ifndef SHA256_H
+#define SHA256_H
+
+// Incremental SHA-256 with the block function picked at startup. The SHA
+// extensions are used when the CPU has them, otherwise OpenSSL, which makes
+// its own choice between AVX2, AVX and SSSE3.
+//
+// Multi-buffer streams copy their data to a 2 KiB backlog instead of hashing
+// it right away. Once eight streams of a packet thread have at least half a
+// backlog, the blocks they all have are hashed together, one stream per AVX2
+// lane. A stream with a full backlog, or finished, hashes it alone.
+// Multi-buffer streams must only be used by the thread that created them;
+// other streams may move between threads.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+#define SHA256_BLOCK_SIZE   64
+#define SHA256_DIGEST_SIZE  32
+#define SHA256_LANES        8
+#define SHA256_BACKLOG      (32 * SHA256_BLOCK_SIZE)
+#define SHA256_LANE_MIN     (SHA256_BACKLOG / 2)
+
+struct Sha256Stats
+{
+    PegCount openssl_bytes;
+    PegCount sha_ext_bytes;
+    PegCount lane_bytes;
+    PegCount lane_batches;
+};
+
+extern THREAD_LOCAL Sha256Stats sha256_stats;
+
+class SO_PUBLIC Sha256
+{
+public:
+    Sha256(bool multi_buffer = false);
+    ~Sha256();
+
+    void update(const uint8_t* data, size_t len);
+    void final(uint8_t* digest);
+
+    // lanes are only used if enabled and the CPU has AVX2 but not the SHA
+    // extensions; call at startup
+    static void enable_lanes(bool);
+    static bool lanes_enabled();
+    static const char* get_backend_name();
+
+private:
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void hash_backlog();
+    void join_lanes();
+    void leave_lanes();
+    static void run_lanes();
+
+    uint32_t state[8];
+    uint64_t length = 0;
+    uint8_t* backlog;          // block buffer or multi-buffer backlog, allocated when needed
+    unsigned used = 0;         // bytes in backlog
+    int slot = -1;             // position among the streams waiting for lanes
+    bool multi_buffer;
+    uint8_t block[SHA256_BLOCK_SIZE];
+};
+
+#endif
+
@@ -0,0 +1,168 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sha256_test.cc
+// unit tests for Sha256 class, results are checked against OpenSSL
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hash/sha256.h"
+
+#include <openssl/sha.h>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static std::vector<uint8_t> make_data(size_t len, unsigned seed)
+{
+    std::vector<uint8_t> data(len);
+    srand(seed);
+
+    for ( auto& b : data )
+        b = (uint8_t)rand();
+
+    return data;
+}
+
+static bool same_as_openssl(const std::vector<uint8_t>& data, const uint8_t* digest)
+{
+    uint8_t expected[SHA256_DIGEST_SIZE];
+    SHA256(data.data(), data.size(), expected);
+    return !memcmp(expected, digest, SHA256_DIGEST_SIZE);
+}
+
+TEST_GROUP(sha256)
+{
+};
+
+TEST(sha256, known_answer)
+{
+    static const uint8_t abc[SHA256_DIGEST_SIZE] =
+    {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    Sha256 sha;
+
+    sha.update((const uint8_t*)"abc", 3);
+    sha.final(digest);
+    CHECK(!memcmp(abc, digest, sizeof(digest)));
+}
+
+// every length around the padding boundaries, fed in uneven pieces
+TEST(sha256, incremental)
+{
+    for ( size_t len = 0; len < 300; ++len )
+    {
+        std::vector<uint8_t> data = make_data(len, len);
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        Sha256 sha;
+        size_t off = 0;
+
+        for ( size_t n = 1; off < len; n = n * 3 + 1 )
+        {
+            size_t k = std::min(n, len - off);
+            sha.update(data.data() + off, k);
+            off += k;
+        }
+        sha.final(digest);
+        CHECK(same_as_openssl(data, digest));
+    }
+}
+
+// streams of different sizes interleaved like file data from many flows
+TEST(sha256, multi_buffer)
+{
+    const unsigned num = 20;
+    const size_t seg = 1460;
+
+    Sha256::enable_lanes(true);
+
+    std::vector<std::vector<uint8_t> > data;
+    std::vector<Sha256*> sha;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        data.push_back(make_data(seg * (i + 1) + 17 * i, i + 1000));
+        sha.push_back(new Sha256(true));
+    }
+
+    for ( size_t off = 0; off < data.back().size(); off += seg )
+    {
+        for ( unsigned i = 0; i < num; ++i )
+        {
+            if ( off < data[i].size() )
+                sha[i]->update(data[i].data() + off, std::min(seg, data[i].size() - off));
+        }
+    }
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        sha[i]->final(digest);
+        CHECK(same_as_openssl(data[i], digest));
+        delete sha[i];
+    }
+
+    if ( Sha256::lanes_enabled() )
+        CHECK(sha256_stats.lane_batches > 0);
+
+    Sha256::enable_lanes(false);
+}
+
+// a stream deleted while waiting for lanes must not be hashed
+TEST(sha256, abandoned)
+{
+    Sha256::enable_lanes(true);
+
+    std::vector<uint8_t> data = make_data(SHA256_BACKLOG * 3, 7);
+    Sha256* gone = new Sha256(true);
+    Sha256* sha[SHA256_LANES];
+
+    gone->update(data.data(), SHA256_BACKLOG);
+    delete gone;
+
+    for ( auto& s : sha )
+    {
+        s = new Sha256(true);
+        s->update(data.data(), data.size());
+    }
+
+    for ( auto& s : sha )
+    {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        s->final(digest);
+        CHECK(same_as_openssl(data, digest));
+        delete s;
+    }
+
+    Sha256::enable_lanes(false);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
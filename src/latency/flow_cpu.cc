@@ -0,0 +1,408 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow_cpu.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "flow/flow.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "protocols/packet.h"
+#include "sfip/sf_ip.h"
+
+#include "latency_config.h"
+#include "latency_stats.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+namespace flow_cpu
+{
+// -----------------------------------------------------------------------------
+// helpers
+// -----------------------------------------------------------------------------
+
+// a copy is kept so the entry outlives the flow
+struct Entry
+{
+    Flow* flow;  // nullptr once the flow has ended
+    uint64_t ticks;
+    uint64_t packets;
+
+    SfIp client_ip;
+    SfIp server_ip;
+    uint16_t client_port;
+    uint16_t server_port;
+    uint8_t ip_proto;
+
+    AppId service;
+    const char* service_name;
+};
+
+struct Service
+{
+    uint64_t ticks = 0;
+    uint64_t flows = 0;
+};
+
+static inline long usecs(uint64_t ticks)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    return clock_usecs(duration_cast<microseconds>(hr_duration(ticks)).count());
+}
+
+// -----------------------------------------------------------------------------
+// implementation
+// -----------------------------------------------------------------------------
+
+class Impl
+{
+public:
+    Impl(unsigned max) : max(max)
+    { heap.reserve(max); }
+
+    void charge(Flow*, hr_duration);
+    void release(Flow*);
+    void dump();
+
+    const std::vector<Entry>& get_heap() const
+    { return heap; }
+
+    const std::unordered_map<AppId, Service>& get_services() const
+    { return services; }
+
+private:
+    void update(Entry&, Flow*);
+    void swap(unsigned, unsigned);
+    void sift_up(unsigned);
+    void sift_down(unsigned);
+
+private:
+    unsigned max;
+    uint64_t total = 0;
+    uint64_t most = 0;
+
+    // min heap on ticks so the cheapest of the top flows is at the root
+    std::vector<Entry> heap;
+    std::unordered_map<AppId, Service> services;
+};
+
+void Impl::update(Entry& e, Flow* f)
+{
+    e.ticks = f->cpu_ticks;
+    e.service = f->application_ids[APP_PROTOID_SERVICE];
+    e.service_name = f->service;
+}
+
+void Impl::swap(unsigned a, unsigned b)
+{
+    std::swap(heap[a], heap[b]);
+
+    if ( heap[a].flow )
+        heap[a].flow->cpu_slot = a + 1;
+
+    if ( heap[b].flow )
+        heap[b].flow->cpu_slot = b + 1;
+}
+
+void Impl::sift_up(unsigned i)
+{
+    while ( i )
+    {
+        unsigned up = (i - 1) / 2;
+
+        if ( heap[up].ticks <= heap[i].ticks )
+            break;
+
+        swap(up, i);
+        i = up;
+    }
+}
+
+void Impl::sift_down(unsigned i)
+{
+    while ( true )
+    {
+        unsigned low = i;
+        unsigned l = 2 * i + 1;
+        unsigned r = l + 1;
+
+        if ( l < heap.size() and heap[l].ticks < heap[low].ticks )
+            low = l;
+
+        if ( r < heap.size() and heap[r].ticks < heap[low].ticks )
+            low = r;
+
+        if ( low == i )
+            break;
+
+        swap(low, i);
+        i = low;
+    }
+}
+
+void Impl::charge(Flow* f, hr_duration d)
+{
+    uint64_t ticks = d.count();
+    f->cpu_ticks += ticks;
+
+    // add the change in the rounded total so sub usec charges aren't lost
+    latency_stats.flow_usecs += usecs(total + ticks) - usecs(total);
+    total += ticks;
+
+    if ( f->cpu_ticks > most )
+    {
+        most = f->cpu_ticks;
+        latency_stats.max_flow_usecs = usecs(most);
+    }
+
+    if ( f->cpu_slot )
+    {
+        unsigned i = f->cpu_slot - 1;
+        update(heap[i], f);
+        heap[i].packets++;
+        sift_down(i);
+        return;
+    }
+
+    if ( heap.size() == max )
+    {
+        // most packets stop here
+        if ( f->cpu_ticks <= heap[0].ticks )
+            return;
+
+        if ( heap[0].flow )
+            heap[0].flow->cpu_slot = 0;
+
+        heap[0] = heap.back();
+        heap.pop_back();
+
+        if ( !heap.empty() )
+        {
+            if ( heap[0].flow )
+                heap[0].flow->cpu_slot = 1;
+
+            sift_down(0);
+        }
+        ++latency_stats.top_flow_evictions;
+    }
+
+    Entry e;
+    e.flow = f;
+    e.packets = 1;
+    e.client_ip = f->client_ip;
+    e.server_ip = f->server_ip;
+    e.client_port = f->client_port;
+    e.server_port = f->server_port;
+    e.ip_proto = f->ip_proto;
+    update(e, f);
+
+    heap.push_back(e);
+    f->cpu_slot = heap.size();
+    sift_up(heap.size() - 1);
+}
+
+void Impl::release(Flow* f)
+{
+    auto& svc = services[f->application_ids[APP_PROTOID_SERVICE]];
+    svc.ticks += f->cpu_ticks;
+    svc.flows++;
+
+    if ( f->cpu_slot )
+    {
+        auto& e = heap[f->cpu_slot - 1];
+        update(e, f);
+        e.flow = nullptr;
+        f->cpu_slot = 0;
+    }
+}
+
+void Impl::dump()
+{
+    std::vector<Entry> top(heap);
+
+    std::sort(top.begin(), top.end(),
+        [](const Entry& a, const Entry& b) { return a.ticks > b.ticks; });
+
+    unsigned id = get_instance_id();
+    LogMessage("flow cpu (thread %u): top %zu flows\n", id, top.size());
+
+    for ( const auto& e : top )
+    {
+        char cip[INET6_ADDRSTRLEN], sip[INET6_ADDRSTRLEN];
+        sfip_ntop(&e.client_ip, cip, sizeof(cip));
+        sfip_ntop(&e.server_ip, sip, sizeof(sip));
+
+        LogMessage("    %10ld usecs %8" PRIu64 " pkts  %u %s:%u -> %s:%u  %s (%d)%s\n",
+            usecs(e.ticks), e.packets, e.ip_proto, cip, e.client_port, sip, e.server_port,
+            e.service_name ? e.service_name : "-", e.service, e.flow ? "" : " closed");
+    }
+
+    std::vector<std::pair<AppId, Service>> svcs(services.begin(), services.end());
+
+    std::sort(svcs.begin(), svcs.end(),
+        [](const std::pair<AppId, Service>& a, const std::pair<AppId, Service>& b)
+        { return a.second.ticks > b.second.ticks; });
+
+    LogMessage("flow cpu (thread %u): closed flows by service\n", id);
+
+    for ( const auto& s : svcs )
+    {
+        LogMessage("    %10ld usecs %8" PRIu64 " flows  appid %d\n",
+            usecs(s.second.ticks), s.second.flows, s.first);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// static variables
+// -----------------------------------------------------------------------------
+
+static THREAD_LOCAL Impl* impl = nullptr;
+static THREAD_LOCAL bool busy = false;
+
+static inline const FlowCpuConfig& get_config()
+{ return snort_conf->latency->flow_cpu; }
+
+static inline Impl& get_impl()
+{
+    if ( !impl )
+        impl = new Impl(get_config().top);
+
+    return *impl;
+}
+
+} // namespace flow_cpu
+
+// -----------------------------------------------------------------------------
+// flow cpu interface
+// -----------------------------------------------------------------------------
+
+// rebuilt packets are inspected within the raw packet's context so only the
+// outermost context is timed
+bool FlowCpu::push()
+{
+    if ( !flow_cpu::get_config().enabled() or flow_cpu::busy )
+        return false;
+
+    flow_cpu::busy = true;
+    return true;
+}
+
+void FlowCpu::pop(const Packet* p, hr_duration d)
+{
+    flow_cpu::busy = false;
+
+    if ( p->flow )
+        flow_cpu::get_impl().charge(p->flow, d);
+}
+
+void FlowCpu::release(Flow* f)
+{
+    if ( flow_cpu::impl )
+        flow_cpu::impl->release(f);
+}
+
+void FlowCpu::dump()
+{
+    if ( flow_cpu::impl )
+        flow_cpu::impl->dump();
+}
+
+void FlowCpu::tterm()
+{
+    using flow_cpu::impl;
+
+    if ( impl )
+    {
+        delete impl;
+        impl = nullptr;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE ( "flow cpu top flows", "[latency]" )
+{
+    flow_cpu::Impl top(2);
+    Flow a, b, c;
+
+    a.application_ids[APP_PROTOID_SERVICE] = 1;
+    b.application_ids[APP_PROTOID_SERVICE] = 2;
+    c.application_ids[APP_PROTOID_SERVICE] = 2;
+
+    top.charge(&a, 10_ticks);
+    top.charge(&b, 20_ticks);
+
+    CHECK( top.get_heap().size() == 2 );
+    CHECK( top.get_heap()[0].flow == &a );
+    CHECK( a.cpu_slot == 1 );
+    CHECK( b.cpu_slot == 2 );
+
+    SECTION( "cheap flows don't displace" )
+    {
+        top.charge(&c, 5_ticks);
+        CHECK( c.cpu_slot == 0 );
+        CHECK( c.cpu_ticks == 5 );
+        CHECK( top.get_heap().size() == 2 );
+    }
+
+    SECTION( "expensive flows evict the cheapest" )
+    {
+        top.charge(&c, 15_ticks);
+        CHECK( a.cpu_slot == 0 );
+        CHECK( top.get_heap()[c.cpu_slot - 1].flow == &c );
+        CHECK( top.get_heap()[0].ticks == 15 );
+    }
+
+    SECTION( "charges reorder" )
+    {
+        top.charge(&a, 20_ticks);
+        CHECK( top.get_heap()[0].flow == &b );
+        CHECK( a.cpu_slot == 2 );
+        CHECK( top.get_heap()[1].packets == 2 );
+    }
+
+    SECTION( "release keeps the entry and charges the service" )
+    {
+        top.release(&b);
+        CHECK( b.cpu_slot == 0 );
+        CHECK( top.get_heap().size() == 2 );
+        CHECK( top.get_heap()[1].flow == nullptr );
+        CHECK( top.get_heap()[1].ticks == 20 );
+        CHECK( top.get_services().at(2).ticks == 20 );
+        CHECK( top.get_services().at(2).flows == 1 );
+    }
+}
+
+#endif
+
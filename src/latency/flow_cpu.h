@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef FLOW_CPU_H
+#define FLOW_CPU_H
+
+// FlowCpu charges the time spent inspecting and detecting each packet to
+// its flow and keeps the most expensive flows in a bounded min heap per
+// packet thread.  the time of ended flows is rolled up by appid service.
+// enabled with latency.flow.top.
+
+#include "time/clock_defs.h"
+#include "time/stopwatch.h"
+
+class Flow;
+struct Packet;
+
+class FlowCpu
+{
+public:
+    static bool push();
+    static void pop(const Packet*, hr_duration);
+
+    // called when a flow with cpu_ticks is reset
+    static void release(Flow*);
+
+    // log this thread's top flows and services
+    static void dump();
+
+    static void tterm();
+
+    class Context
+    {
+    public:
+        Context(const Packet* p) : p(p)
+        {
+            if ( (timing = FlowCpu::push()) )
+                sw.start();
+        }
+
+        ~Context()
+        {
+            if ( timing )
+                FlowCpu::pop(p, sw.get());
+        }
+
+    private:
+        const Packet* p;
+        Stopwatch<SnortClock> sw;
+        bool timing;
+    };
+};
+
+#endif
+
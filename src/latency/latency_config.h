@@ -24,10 +24,18 @@
 #include "packet_latency_config.h"
 #include "rule_latency_config.h"
 
+struct FlowCpuConfig
+{
+    unsigned top = 0;
+
+    bool enabled() const { return top > 0; }
+};
+
 struct LatencyConfig
 {
     PacketLatencyConfig packet_latency;
     RuleLatencyConfig rule_latency;
+    FlowCpuConfig flow_cpu;
 };
 
 #endif
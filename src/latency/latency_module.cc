@@ -24,7 +24,9 @@
 
 #include "latency_module.h"
 
+#include <cassert>
 #include <chrono>
+#include <cstddef>
 
 #include "main/snort_config.h"
 
@@ -76,6 +78,15 @@ static const Parameter s_rule_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter s_flow_params[] =
+{
+    { "top", Parameter::PT_INT, "0:1024", "0",
+        "charge inspection time to flows and track this many of the most expensive "
+        "flows per packet thread (0 = disabled)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter s_params[] =
 {
     { "packet", Parameter::PT_TABLE, s_packet_params, nullptr,
@@ -84,6 +95,9 @@ static const Parameter s_params[] =
     { "rule", Parameter::PT_TABLE, s_rule_params, nullptr,
       "rule latency" },
 
+    { "flow", Parameter::PT_TABLE, s_flow_params, nullptr,
+      "flow cpu accounting" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -107,6 +121,9 @@ static const PegInfo latency_pegs[] =
     { "total_rule_evals", "total rule evals monitored" },
     { "rule_eval_timeouts", "rule evals that timed out" },
     { "rule_tree_enables", "rule tree re-enables" },
+    { "flow_usecs", "total usecs charged to flows" },
+    { "max_flow_usecs", "most usecs charged to a single flow" },
+    { "top_flow_evictions", "flows displaced from the top flows by more expensive ones" },
     { nullptr, nullptr }
 };
 
@@ -170,6 +187,17 @@ static inline bool latency_set(Value& v, RuleLatencyConfig& config)
     return true;
 }
 
+static inline bool latency_set(Value& v, FlowCpuConfig& config)
+{
+    if ( v.is("top") )
+        config.top = v.get_long();
+
+    else
+        return false;
+
+    return true;
+}
+
 LatencyModule::LatencyModule() :
     Module(s_name, s_help, s_params)
 { }
@@ -178,6 +206,7 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
 {
     const char* slp = "latency.packet";
     const char* slr = "latency.rule";
+    const char* slf = "latency.flow";
 
     if ( !strncmp(fqn, slp, strlen(slp)) )
         return latency_set(v, sc->latency->packet_latency);
@@ -185,6 +214,9 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, slr, strlen(slr)) )
         return latency_set(v, sc->latency->rule_latency);
 
+    else if ( !strncmp(fqn, slf, strlen(slf)) )
+        return latency_set(v, sc->latency->flow_cpu);
+
     return false;
 }
 
@@ -199,3 +231,15 @@ const PegInfo* LatencyModule::get_pegs() const
 
 PegCount* LatencyModule::get_counts() const
 { return reinterpret_cast<PegCount*>(&latency_stats); }
+
+// the per flow maximum is kept per thread and must not be summed
+const CountType* LatencyModule::get_count_types() const
+{
+    static const unsigned num_pegs = sizeof(LatencyStats) / sizeof(PegCount);
+    static CountType count_types[num_pegs] = { };
+
+    assert(num_pegs == sizeof(latency_pegs) / sizeof(latency_pegs[0]) - 1);
+    count_types[offsetof(LatencyStats, max_flow_usecs) / sizeof(PegCount)] = CountType::MAX;
+
+    return count_types;
+}
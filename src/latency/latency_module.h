@@ -35,6 +35,7 @@ public:
 
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
+    const CountType* get_count_types() const override;
 };
 
 #endif
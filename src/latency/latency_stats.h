@@ -33,6 +33,9 @@ struct LatencyStats
     PegCount total_rule_evals;
     PegCount rule_eval_timeouts;
     PegCount rule_tree_enables;
+    PegCount flow_usecs;
+    PegCount max_flow_usecs;
+    PegCount top_flow_evictions;
 };
 
 extern THREAD_LOCAL LatencyStats latency_stats;
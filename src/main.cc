@@ -298,6 +298,14 @@ int main_rotate_stats(lua_State* L)
     return 0;
 }
 
+int main_dump_flow_cpu(lua_State* L)
+{
+    bool from_shell = ( L != nullptr );
+    current_request->respond("== dumping flow cpu\n", from_shell);
+    broadcast(get_command(new ACDumpFlowCpu(), from_shell));
+    return 0;
+}
+
 int main_reload_config(lua_State* L)
 {
     if ( Swapper::get_reload_in_progress() )
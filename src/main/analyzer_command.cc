@@ -25,6 +25,7 @@
 
 #include <cassert>
 
+#include "latency/flow_cpu.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "utils/stats.h"
@@ -64,6 +65,11 @@ void ACRotate::execute(Analyzer&)
     Snort::thread_rotate();
 }
 
+void ACDumpFlowCpu::execute(Analyzer&)
+{
+    FlowCpu::dump();
+}
+
 void ACGetStats::execute(Analyzer&)
 {
     // FIXIT-P This incurs locking on all threads to retrieve stats.  It could be reimplemented to
@@ -43,6 +43,13 @@ public:
     ~ACGetStats();
 };
 
+class ACDumpFlowCpu : public AnalyzerCommand
+{
+public:
+    void execute(Analyzer&) override;
+    const char* stringify() override { return "DUMP_FLOW_CPU"; }
+};
+
 class ACPause : public AnalyzerCommand
 {
 public:
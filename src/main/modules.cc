@@ -24,6 +24,8 @@
 
 #include "modules.h"
 
+#include <lua.hpp>
+
 #include "codecs/codec_module.h"
 #include "detection/fp_config.h"
 #include "filters/detection_filter.h"
@@ -46,6 +48,7 @@
 #include "parser/parse_ip.h"
 #include "parser/parser.h"
 #include "profiler/profiler_defs.h"
+#include "profiler/rule_profiler.h"
 #include "search_engines/pat_stats.h"
 #include "side_channel/side_channel_module.h"
 #include "sfip/sf_ipvar.h"
@@ -69,6 +72,12 @@ static const Parameter detection_params[] =
     { "asn1", Parameter::PT_INT, "1:", "256",
       "maximum decode nodes" },
 
+    { "offload_limit", Parameter::PT_INT, "0:", "32768",
+      "minimum buffer size to split a fast pattern search across offload threads" },
+
+    { "offload_threads", Parameter::PT_INT, "0:", "0",
+      "number of threads that help packet threads search large buffers (0 = off)" },
+
     { "pcre_enable", Parameter::PT_BOOL, nullptr, "true",
       "disable pcre pattern matching" },
 
@@ -103,6 +112,12 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     if ( v.is("asn1") )
         sc->asn1_mem = v.get_long();
 
+    else if ( v.is("offload_limit") )
+        sc->offload_limit = v.get_long();
+
+    else if ( v.is("offload_threads") )
+        sc->offload_threads = v.get_long();
+
     else if ( v.is("pcre_enable") )
         v.update_mask(sc->run_flags, RUN_FLAG__NO_PCRE, true);
 
@@ -355,6 +370,9 @@ static const Parameter profiler_time_params[] =
     { "max_depth", Parameter::PT_INT, "-1:", "-1",
       "limit depth to max_depth (-1 = no limit)" },
 
+    { "sample", Parameter::PT_INT, "0:", "0",
+      "only time 1 in sample packets and scale the results (0 = time all)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -386,7 +404,7 @@ static const Parameter profiler_rule_params[] =
 
     { "sort", Parameter::PT_ENUM,
       "none | checks | avg_check | total_time | matches | no_matches | "
-      "avg_match | avg_no_match",
+      "avg_match | avg_no_match | p99 | max",
       "total_time", "sort by given field" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -409,6 +427,28 @@ static const Parameter profiler_params[] =  // FIXIT-L add help
 #define profiler_help \
     "configure profiling of rules and/or modules"
 
+static int rule_histogram(lua_State* L)
+{
+    show_rule_histograms(lua_tointeger(L, 1));
+    return 0;
+}
+
+static const Parameter profiler_hist_params[] =
+{
+    { "count", Parameter::PT_INT, "0:", nullptr,
+      "limit results to the worst count rules by p99 (0 or none = all)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+static const Command profiler_cmds[] =
+{
+    { "rule_histogram", rule_histogram, profiler_hist_params,
+      "show rule time percentiles from packet threads that have exited" },
+
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
 template<typename T>
 static bool s_profiler_module_set_max_depth(T& config, Value& v)
 { config.max_depth = v.get_long(); return true; }
@@ -416,6 +456,13 @@ static bool s_profiler_module_set_max_depth(T& config, Value& v)
 static bool s_profiler_module_set_max_depth(RuleProfilerConfig&, Value&)
 { return false; }
 
+template<typename T>
+static bool s_profiler_module_set_sample(T&, Value&)
+{ return false; }
+
+static bool s_profiler_module_set_sample(TimeProfilerConfig& config, Value& v)
+{ config.sample = v.get_long(); return true; }
+
 template<typename T>
 static bool s_profiler_module_set(T& config, Value& v)
 {
@@ -431,6 +478,9 @@ static bool s_profiler_module_set(T& config, Value& v)
     else if ( v.is("max_depth") )
         return s_profiler_module_set_max_depth(config, v);
 
+    else if ( v.is("sample") )
+        return s_profiler_module_set_sample(config, v);
+
     else
         return false;
 
@@ -442,6 +492,9 @@ class ProfilerModule : public Module
 public:
     ProfilerModule() : Module("profiler", profiler_help, profiler_params) { }
     bool set(const char*, Value&, SnortConfig*) override;
+
+    const Command* get_commands() const override
+    { return profiler_cmds; }
 };
 
 bool ProfilerModule::set(const char* fqn, Value& v, SnortConfig* sc)
@@ -963,6 +1016,9 @@ static const Parameter network_params[] =
     { "decode_drops", Parameter::PT_BOOL, nullptr, "false",
       "enable dropping of packets by the decoder" },
 
+    { "fast_decode", Parameter::PT_BOOL, nullptr, "true",
+      "decode eth / vlan / ip4 / ip6 / tcp / udp with less per layer overhead" },
+
     { "id", Parameter::PT_INT, "0:65535", "0",
       "correlate unified2 events with configuration" },
 
@@ -1010,6 +1066,9 @@ bool NetworkModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("decode_drops") )
         p->decoder_drop = v.get_bool();
 
+    else if ( v.is("fast_decode") )
+        sc->fast_decode = v.get_bool();
+
     else if ( v.is("id") )
         p->user_policy_id = v.get_long();
 
@@ -30,10 +30,13 @@
 #include "codecs/codec_api.h"
 #include "connectors/connectors.h"
 #include "decompress/file_decomp.h"
+#include "decompress/inflate_pool.h"
 #include "detection/detect.h"
 #include "detection/detection_util.h"
 #include "detection/fp_config.h"
 #include "detection/fp_detect.h"
+#include "detection/ips_context.h"
+#include "detection/regex_offload.h"
 #include "detection/tag.h"
 #include "file_api/file_service.h"
 #include "filters/detection_filter.h"
@@ -45,6 +48,7 @@
 #include "host_tracker/host_cache.h"
 #include "ips_options/ips_flowbits.h"
 #include "ips_options/ips_options.h"
+#include "latency/flow_cpu.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
 #include "log/log.h"
@@ -215,6 +219,7 @@ void Snort::init(int argc, char** argv)
 #endif
 
     InitProtoNames();
+    InitJSNormLookupTable();
     SFAT_Init();
 
     load_actions();
@@ -507,6 +512,7 @@ void Snort::setup(int argc, char* argv[])
     OpenLogger();
 
     init(argc, argv);
+    RegexOffload::init(snort_conf->offload_threads);
 
     LogMessage("%s\n", LOG_DIV);
     SFDAQ::init(snort_conf);
@@ -539,6 +545,8 @@ void Snort::cleanup()
     if ( !SnortConfig::test_mode() )  // FIXIT-M ideally the check is in one place
         PrintStatistics();
 
+    RegexOffload::term();
+
     CloseLogger();
     ThreadConfig::term();
     clean_exit(0);
@@ -689,15 +697,13 @@ void Snort::thread_init_unprivileged()
     // so it is done here instead of init()
     Active::init(snort_conf);
 
-    SnortEventqNew(snort_conf->event_queue_config);
+    IpsContext::thread_init(snort_conf);
 
     InitTag();
 
     EventTrace_Init();
     detection_filter_init(snort_conf->detection_filter_config);
 
-    otnx_match_data_init(snort_conf->num_rule_types);
-
     EventManager::open_outputs();
     IpsManager::setup_options();
     ActionManager::thread_init(snort_conf);
@@ -742,16 +748,18 @@ void Snort::thread_term()
 
     PacketLatency::tterm();
     RuleLatency::tterm();
+    FlowCpu::tterm();
 
     Profiler::consolidate_stats();
 
-    otnx_match_data_term();
+    RegexOffload::tterm();
     detection_filter_term();
     EventTrace_Term();
     CleanupTag();
     FileService::thread_term();
+    InflatePool::tterm();
 
-    SnortEventqFree();
+    IpsContext::thread_term();
     Active::term();
 }
 
@@ -871,6 +879,7 @@ DAQ_Verdict Snort::packet_callback(
     void*, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt)
 {
     set_default_policy();
+    TimeProfilerSample::next(snort_conf->profiler->time.sample);
     Profile profile(totalPerfStats);
 
     pc.total_from_daq++;
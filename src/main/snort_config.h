@@ -184,6 +184,9 @@ public:
     int asn1_mem = 0;
     uint32_t run_flags = 0;
 
+    unsigned offload_limit = 32768;
+    unsigned offload_threads = 0;
+
     //------------------------------------------------------
     // process stuff
 
@@ -212,6 +215,7 @@ public:
     uint8_t num_layers = 0;
     uint8_t max_ip6_extensions = 0;
     uint8_t max_ip_layers = 0;
+    bool fast_decode = true;
 
     //------------------------------------------------------
     // active stuff
@@ -64,6 +64,8 @@ static const Command snort_cmds[] =
     { "show_plugins", main_dump_plugins, nullptr, "show available plugins" },
     { "dump_stats", main_dump_stats, nullptr, "show summary statistics" },
     { "rotate_stats", main_rotate_stats, nullptr, "roll perfmonitor log files" },
+    { "dump_flow_cpu", main_dump_flow_cpu, nullptr,
+      "log the most expensive flows per thread (latency.flow.top)" },
     { "reload_config", main_reload_config, s_reload, "load new configuration" },
     { "reload_hosts", main_reload_hosts, s_reload, "load a new hosts table" },
 
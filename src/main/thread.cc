@@ -122,3 +122,26 @@ const char* get_instance_file(std::string& file, const char* name)
 
     return file.c_str();
 }
+
+//-------------------------------------------------------------------------
+// format is:
+//     <logdir>/[<run_prefix>_]<name>
+//-------------------------------------------------------------------------
+
+const char* get_main_file(std::string& file, const char* name)
+{
+    file = !snort_conf->log_dir.empty() ? snort_conf->log_dir : "./";
+
+    if ( file.back() != '/' )
+        file += '/';
+
+    if ( !snort_conf->run_prefix.empty() )
+    {
+        file += snort_conf->run_prefix;
+        file += '_';
+    }
+
+    file += name;
+
+    return file.c_str();
+}
@@ -58,6 +58,9 @@ SO_PUBLIC inline bool is_packet_thread()
 // derived therefrom.
 SO_PUBLIC const char* get_instance_file(std::string&, const char* name);
 
+// as above but for files shared by all packet threads
+SO_PUBLIC const char* get_main_file(std::string&, const char* name);
+
 void take_break();
 bool break_time();
 
@@ -49,6 +49,9 @@ std::array<Codec*, UINT8_MAX> CodecManager::s_protocols {
 THREAD_LOCAL ProtocolId CodecManager::grinder_id = ProtocolId::ETHERTYPE_NOT_SET;
 THREAD_LOCAL uint8_t CodecManager::grinder = 0;
 THREAD_LOCAL uint8_t CodecManager::max_layers = DEFAULT_LAYERMAX;
+THREAD_LOCAL std::array<bool, UINT8_MAX> CodecManager::fast_codecs {
+    { false }
+};
 
 // This is hardcoded into Snort++
 extern const CodecApi* default_codec;
@@ -232,6 +235,8 @@ void CodecManager::thread_init(SnortConfig* sc)
     if (!grinder)
         ParseError("Unable to find a Codec with data link type %d", daq_dlt);
 
+    set_fast_decode(sc->fast_decode);
+
     if ( s_rand )
         rand_close(s_rand);
 
@@ -246,6 +251,28 @@ void CodecManager::thread_init(SnortConfig* sc)
     rand_get(s_rand, s_id_pool.data(), s_id_pool.size());
 }
 
+void CodecManager::set_fast_decode(bool enable)
+{
+    // the common encapsulations; see PacketManager::decode_fast()
+    static const ProtocolId fast_ids[] =
+    {
+        ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_8021Q,
+        ProtocolId::ETHERTYPE_IPV4, ProtocolId::ETHERTYPE_IPV6,
+        ProtocolId::TCP, ProtocolId::UDP
+    };
+
+    fast_codecs.fill(false);
+
+    if ( !enable )
+        return;
+
+    for ( auto id : fast_ids )
+        fast_codecs[s_proto_map[to_utype(id)]] = true;
+
+    // ids without a codec map to the default codec, which ends the decode
+    fast_codecs[0] = false;
+}
+
 void CodecManager::thread_term()
 {
     PacketManager::accumulate(); // statistics
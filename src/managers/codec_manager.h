@@ -68,6 +68,9 @@ class CodecManager
 {
 public:
     friend class PacketManager;
+#ifdef UNIT_TEST
+    friend class DecodeTest;
+#endif
 
     // global plugin initializer
     static void add_plugin(const struct CodecApi*);
@@ -81,6 +84,8 @@ public:
     static void thread_init(SnortConfig*);
     // destroy thread_local data
     static void thread_term();
+    // select the current thread's decode path (network.fast_decode)
+    static void set_fast_decode(bool);
     // print all of the codec plugins
     static void dump_plugins();
 
@@ -102,6 +107,9 @@ private:
     static THREAD_LOCAL ProtocolIndex grinder;
     static THREAD_LOCAL uint8_t max_layers;
 
+    // codecs PacketManager::decode() runs on its fast path, by ProtocolIndex
+    static THREAD_LOCAL std::array<bool, UINT8_MAX> fast_codecs;
+
     /*
      * Private helper functions.  These are all declared here
      * because they need access to private variables.
@@ -26,11 +26,24 @@
 
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 
 #include "utils/util_unfold.h"
 
 #include "decode_buffer.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <emmintrin.h>
+#define QP_SIMD
+#endif
+
+#ifdef UNIT_TEST
+#include <chrono>
+#include <string>
+
+#include "catch/catch.hpp"
+#endif
+
 void QPDecode::reset_decode_state()
 {
     reset_decoded_bytes();
@@ -97,6 +110,52 @@ QPDecode::~QPDecode()
         delete buffer;
 }
 
+// Most encoded text is copied as is.  Returns the length of the leading run
+// of characters that are copied unchanged: printable (other than '='),
+// blank, CR or LF.
+static inline bool qp_is_plain(uint8_t c)
+{
+    return ((c >= 0x20) && (c < 0x7f) && (c != '=')) || (c == '\t') || (c == '\r') ||
+           (c == '\n');
+}
+
+static uint32_t qp_plain_run(const char* src, uint32_t len)
+{
+    uint32_t n = 0;
+
+#ifdef QP_SIMD
+    const __m128i low = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i eq = _mm_set1_epi8('=');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    while ( len - n >= 16 )
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(src + n));
+
+        // signed compares also rule out 0x80 and above
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, del));
+        ok = _mm_andnot_si128(_mm_cmpeq_epi8(v, eq), ok);
+        ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, tab),
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf))));
+
+        const unsigned mask = (unsigned)_mm_movemask_epi8(ok);
+
+        if ( mask != 0xffff )
+            return n + __builtin_ctz(~mask);
+
+        n += 16;
+    }
+#endif
+
+    while ( (n < len) && qp_is_plain((uint8_t)src[n]) )
+        n++;
+
+    return n;
+}
+
 int sf_qpdecode(char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* bytes_read,
     uint32_t* bytes_copied)
 {
@@ -110,6 +169,21 @@ int sf_qpdecode(char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* by
 
     while ( (*bytes_read < slen) && (*bytes_copied < dlen))
     {
+        uint32_t run = slen - *bytes_read;
+
+        if ( run > dlen - *bytes_copied )
+            run = dlen - *bytes_copied;
+
+        run = qp_plain_run(src + *bytes_read, run);
+
+        if ( run )
+        {
+            memcpy(dst + *bytes_copied, src + *bytes_read, run);
+            *bytes_read += run;
+            *bytes_copied += run;
+            continue;
+        }
+
         ch = src[*bytes_read];
         *bytes_read += 1;
         if ( ch == '=' )
@@ -172,3 +246,81 @@ int sf_qpdecode(char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* by
     return 0;
 }
 
+#ifdef UNIT_TEST
+
+static int qp_decode(std::string s, char* out, uint32_t out_len, uint32_t& read, uint32_t& copied)
+{
+    return sf_qpdecode(&s[0], s.size(), out, out_len, &read, &copied);
+}
+
+TEST_CASE("qp escapes", "[decode_qp]")
+{
+    char out[64];
+    uint32_t read = 0, copied = 0;
+
+    REQUIRE(qp_decode("=41=42C", out, sizeof(out), read, copied) == 0);
+    CHECK(copied == 3);
+    CHECK(!memcmp(out, "ABC", 3));
+
+    // soft line breaks are removed
+    REQUIRE(qp_decode("one=\r\ntwo=\nthree", out, sizeof(out), read, copied) == 0);
+    CHECK(copied == 11);
+    CHECK(!memcmp(out, "onetwothree", 11));
+
+    // an escape split at the end is left for the next packet
+    REQUIRE(qp_decode("abc=4", out, sizeof(out), read, copied) == 0);
+    CHECK(read == 3);
+    CHECK(copied == 3);
+
+    // control characters are dropped
+    REQUIRE(qp_decode(std::string("a\x01" "b\x80" "c", 5), out, sizeof(out), read, copied) == 0);
+    CHECK(copied == 3);
+    CHECK(!memcmp(out, "abc", 3));
+}
+
+TEST_CASE("qp long lines", "[decode_qp]")
+{
+    const std::string line = "The quick brown fox jumps over the lazy dog =3D\t0123456789 ~!@#$%^&*()_+";
+    const std::string plain = "The quick brown fox jumps over the lazy dog =\t0123456789 ~!@#$%^&*()_+";
+    std::string text, expected;
+
+    for ( int i = 0; i < 20; i++ )
+    {
+        text += line + "=\r\n" + line + "\r\n";
+        expected += plain + plain + "\r\n";
+    }
+    std::string out(text.size(), '\0');
+    uint32_t read = 0, copied = 0;
+
+    REQUIRE(qp_decode(text, &out[0], out.size(), read, copied) == 0);
+    CHECK(read == text.size());
+    CHECK(out.substr(0, copied) == expected);
+
+    // output limited in the middle of a run
+    REQUIRE(qp_decode(text, &out[0], 100, read, copied) == 0);
+    CHECK(copied == 100);
+    CHECK(out.substr(0, copied) == expected.substr(0, 100));
+}
+
+TEST_CASE("qp benchmark", "[decode_qp][.benchmark]")
+{
+    std::string text;
+
+    while ( text.size() < 4 * 1024 * 1024 )
+        text += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do =C3=A9i=\r\n";
+
+    std::string out(text.size(), '\0');
+    uint32_t read = 0, copied = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for ( int i = 0; i < 20; i++ )
+        qp_decode(text, &out[0], out.size(), read, copied);
+
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    WARN("quoted-printable decode: " << (20 * text.size() / secs.count() / 1e6) << " MB/s");
+    CHECK(read == text.size());
+}
+
+#endif
+
@@ -119,6 +119,14 @@ const PegInfo appid_pegs[] =
     { "tns_flows", "count of tns flows discovered" },
     { "vnc_clients", "count of vnc clients discovered" },
     { "yahoo_messenger_clients", "count of Yahoo Messenger clients discovered" },
+    { "service_port_candidates", "count of service detectors selected by port" },
+    { "service_pattern_candidates", "count of service detectors selected by pattern" },
+    { "service_duplicate_candidates", "count of duplicate service detectors skipped" },
+    { "service_brute_force_tries", "count of service detectors tried by brute force" },
+    { "lua_bytecode_hits", "count of Lua detectors loaded from cached bytecode" },
+    { "lua_bytecode_misses", "count of Lua detectors compiled from source" },
+    { "lua_validate_ref_hits", "count of Lua validate calls using the resolved function" },
+    { "lua_validate_ref_misses", "count of Lua validate calls looking the function up by name" },
     { nullptr, nullptr }
 };
 
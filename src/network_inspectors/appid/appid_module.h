@@ -105,6 +105,14 @@ struct AppIdStats
     PegCount tns_flows;
     PegCount vnc_clients;
     PegCount yahoo_messenger_clients;
+    PegCount service_port_candidates;
+    PegCount service_pattern_candidates;
+    PegCount service_duplicate_candidates;
+    PegCount service_brute_force_tries;
+    PegCount lua_bytecode_hits;
+    PegCount lua_bytecode_misses;
+    PegCount lua_validate_ref_hits;
+    PegCount lua_validate_ref_misses;
 };
 
 extern THREAD_LOCAL AppIdStats appid_stats;
@@ -180,7 +180,8 @@ public:
     char* service_version = nullptr;
     AppIdServiceSubtype* subtype = nullptr;
     char* netbios_name = nullptr;
-    std::vector<ServiceDetector*> service_candidates;
+    ServiceCandidates service_candidates;
+    ServiceCandidateIds service_candidate_ids;
     bool got_incompatible_services = false;
 
     // AppId matching client side
@@ -25,6 +25,12 @@
 
 #include "sf_mlmp.h"
 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "main/snort_debug.h"
 #include "search_engines/search_tool.h"
 #include "utils/util.h"
@@ -46,6 +52,10 @@ struct tPatternNode
     /**Unique non-zero identifier to tie parts of a multi-part patterns together. */
     uint32_t patternId;
 
+    /**Tree this pattern was added to. Matches for other trees at the same level are
+     * ignored.*/
+    tMlmpTree* owner;
+
     tPatternNode* nextPattern;
 };
 
@@ -59,21 +69,56 @@ struct tPatternPrimaryNode
     tMlmpTree* nextLevelMatcher;
 };
 
+/*All pattern nodes at one level with the same bytes share one entry in the search tool for
+  that level. Nodes are ordered by owner so the ones belonging to the tree being searched are
+  found with a binary search. */
+struct tPartGroup
+{
+    std::vector<tPatternNode*> nodes;
+};
+
+/*One search tool per level instead of one per tree node. A URL is searched once for its host
+  and once for its path no matter how many hosts have path patterns, and the tool for a level
+  is built once over the distinct parts rather than once per host. */
+struct tMlmpLevel
+{
+    SearchTool* patternTree = nullptr;
+    std::map<std::string, tPartGroup> parts;
+};
+
 /*Node for mlmp tree */
 struct tMlmpTree
 {
-    SearchTool* patternTree;
+    std::vector<tMlmpLevel>* levels;    /*root only, built by mlmpProcessPatterns() */
     tPatternPrimaryNode* patternList;
     uint32_t level;
 };
 
 /*Used to track matched patterns. */
-struct tMatchedPatternList
+struct tMatchedPattern
 {
     tPatternNode* patternNode;
     size_t match_start_pos;
-    /*uint32_t level; */
-    tMatchedPatternList* next;
+};
+
+typedef std::vector<tMatchedPattern> tMatchedPatternList;
+
+struct tMatchState
+{
+    const tMlmpTree* owner;
+    tMatchedPatternList* matches;
+};
+
+struct tOwnerLess
+{
+    bool operator()(const tPatternNode* node, const tMlmpTree* owner) const
+    { return std::less<const tMlmpTree*>()(node->owner, owner); }
+
+    bool operator()(const tMlmpTree* owner, const tPatternNode* node) const
+    { return std::less<const tMlmpTree*>()(owner, node->owner); }
+
+    bool operator()(const tPatternNode* a, const tPatternNode* b) const
+    { return std::less<const tMlmpTree*>()(a->owner, b->owner); }
 };
 
 static int compareMlmpPatterns(const void* p1, const void* p2);
@@ -82,12 +127,10 @@ static void destroyTreesRecursively(tMlmpTree* root);
 static void dumpTreesRecursively(tMlmpTree* root);
 static int addPatternRecursively(tMlmpTree* root, const tMlmpPattern* inputPatternList,
     void* metaData, uint32_t level);
-static tPatternNode* urlPatternSelector(const tMatchedPatternList* matchList, const
-    uint8_t* payload);
-static tPatternNode* genericPatternSelector(const tMatchedPatternList* matchList, const
-    uint8_t* payload);
+static tPatternNode* patternSelector(const tMatchedPatternList& matchList, const
+    uint8_t* payload, bool domain);
 static void* mlmpMatchPatternCustom(tMlmpTree* root, tMlmpPattern* inputPatternList,
-    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*));
+    bool domain);
 static int patternMatcherCallback(void* id, void* unused_tree, int match_end_pos, void* data,
     void* unused_neg);
 
@@ -118,56 +161,81 @@ int mlmpProcessPatterns(tMlmpTree* root)
 
 void* mlmpMatchPatternUrl(tMlmpTree* root, tMlmpPattern* inputPatternList)
 {
-    return mlmpMatchPatternCustom(root, inputPatternList, urlPatternSelector);
+    return mlmpMatchPatternCustom(root, inputPatternList, true);
 }
 
 void* mlmpMatchPatternGeneric(tMlmpTree* root, tMlmpPattern* inputPatternList)
 {
-    return mlmpMatchPatternCustom(root, inputPatternList, genericPatternSelector);
+    return mlmpMatchPatternCustom(root, inputPatternList, false);
 }
 
-static inline bool match_is_domain_pattern(const tMatchedPatternList* mp, const uint8_t* payload)
+static inline bool match_is_domain_pattern(const tMatchedPattern& mp, const uint8_t* payload)
 {
     if (!payload)
         return false;
 
-    return mp->patternNode->pattern.level != 0 or
-           mp->match_start_pos == 0 or
-           payload[mp->match_start_pos-1] == '.';
+    return mp.patternNode->pattern.level != 0 or
+           mp.match_start_pos == 0 or
+           payload[mp.match_start_pos-1] == '.';
 }
 
+/*orders matches by <patternId, partNum>, keeping the first match reported for each part */
+static void sortMatches(tMatchedPatternList& matches)
+{
+    std::stable_sort(matches.begin(), matches.end(),
+        [](const tMatchedPattern& a, const tMatchedPattern& b)
+        {
+            if (a.patternNode->patternId != b.patternNode->patternId)
+                return a.patternNode->patternId < b.patternNode->patternId;
+            return a.patternNode->partNum < b.patternNode->partNum;
+        });
+
+    auto last = std::unique(matches.begin(), matches.end(),
+        [](const tMatchedPattern& a, const tMatchedPattern& b)
+        {
+            return a.patternNode->patternId == b.patternNode->patternId and
+                   a.patternNode->partNum == b.patternNode->partNum;
+        });
+
+    matches.erase(last, matches.end());
+}
+
+/*Each input pattern is searched once with the tool for its level. The best match at a level
+  picks the tree searched at the next level, and the deepest match with user data wins. */
 static void* mlmpMatchPatternCustom(tMlmpTree* rootNode, tMlmpPattern* inputPatternList,
-    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*))
+    bool domain)
 {
-    tMatchedPatternList* mp = nullptr;
-    tMatchedPatternList* tmpMp;
     void* data = nullptr;
-    void* tmpData = nullptr;
-    tPatternPrimaryNode* primaryNode;
+    tMlmpTree* node = rootNode;
     tMlmpPattern* pattern = inputPatternList;
+    tMatchedPatternList matches;
 
-    if (!rootNode || !pattern || !pattern->pattern)
+    if (!rootNode || !rootNode->levels || !pattern)
         return nullptr;
 
-    rootNode->patternTree->find_all((char*)pattern->pattern, pattern->patternSize,
-        patternMatcherCallback, false, (void*)&mp);
+    for (; node && pattern->pattern; ++pattern)
+    {
+        tMlmpLevel& level = (*rootNode->levels)[node->level];
+        tMatchState state = { node, &matches };
 
-    primaryNode = (tPatternPrimaryNode*)callback(mp, pattern->pattern);
+        matches.clear();
+        level.patternTree->find_all((const char*)pattern->pattern, pattern->patternSize,
+            patternMatcherCallback, false, (void*)&state);
 
-    while (mp)
-    {
-        tmpMp = mp;
-        mp = mp->next;
-        snort_free(tmpMp);
-    }
+        if (matches.empty())
+            break;
 
-    if (primaryNode)
-    {
-        data = primaryNode->patternNode.userData;
-        tmpData = mlmpMatchPatternCustom(primaryNode->nextLevelMatcher, ++inputPatternList,
-            callback);
-        if (tmpData)
-            data = tmpData;
+        sortMatches(matches);
+        tPatternPrimaryNode* primaryNode =
+            (tPatternPrimaryNode*)patternSelector(matches, pattern->pattern, domain);
+
+        if (!primaryNode)
+            break;
+
+        if (primaryNode->patternNode.userData)
+            data = primaryNode->patternNode.userData;
+
+        node = primaryNode->nextLevelMatcher;
     }
 
     return data;
@@ -203,16 +271,13 @@ static int compareMlmpPatterns(const void* p1, const void* p2)
     return ((int)pat1->patternSize - (int)pat2->patternSize);
 }
 
-/*pattern trees are not freed on error because in case of error, caller should call
-   detroyTreesRecursively. */
-static int createTreesRecusively(tMlmpTree* rootNode)
+static void collectPartsRecursively(tMlmpTree* rootNode, std::vector<tMlmpLevel>& levels)
 {
-    SearchTool* patternMatcher;
     tPatternPrimaryNode* primaryPatternNode;
     tPatternNode* ddPatternNode;
 
-    /* set up the MPSE for url patterns */
-    patternMatcher = rootNode->patternTree = new SearchTool("ac_full");
+    if (levels.size() <= rootNode->level)
+        levels.resize(rootNode->level + 1);
 
     for (primaryPatternNode = rootNode->patternList;
         primaryPatternNode;
@@ -220,21 +285,41 @@ static int createTreesRecusively(tMlmpTree* rootNode)
     {
         /*recursion into next lower level */
         if (primaryPatternNode->nextLevelMatcher)
-        {
-            if (createTreesRecusively(primaryPatternNode->nextLevelMatcher))
-                return -1;
-        }
+            collectPartsRecursively(primaryPatternNode->nextLevelMatcher, levels);
 
         for (ddPatternNode = &primaryPatternNode->patternNode;
             ddPatternNode;
             ddPatternNode = ddPatternNode->nextPattern)
         {
-            patternMatcher->add(ddPatternNode->pattern.pattern,
-                ddPatternNode->pattern.patternSize, ddPatternNode, true);
+            std::string part((const char*)ddPatternNode->pattern.pattern,
+                ddPatternNode->pattern.patternSize);
+            levels[rootNode->level].parts[part].nodes.push_back(ddPatternNode);
         }
     }
+}
 
-    patternMatcher->prep();
+/*pattern trees are not freed on error because in case of error, caller should call
+   detroyTreesRecursively. */
+static int createTreesRecusively(tMlmpTree* rootNode)
+{
+    delete rootNode->levels;
+    rootNode->levels = new std::vector<tMlmpLevel>;
+    collectPartsRecursively(rootNode, *rootNode->levels);
+
+    for (auto& level : *rootNode->levels)
+    {
+        /* set up the MPSE for all patterns at this level */
+        level.patternTree = new SearchTool("ac_full");
+
+        for (auto& kv : level.parts)
+        {
+            std::stable_sort(kv.second.nodes.begin(), kv.second.nodes.end(), tOwnerLess());
+
+            level.patternTree->add(kv.first.data(), kv.first.size(), &kv.second, true);
+        }
+
+        level.patternTree->prep();
+    }
 
     return 0;
 }
@@ -265,7 +350,12 @@ static void destroyTreesRecursively(tMlmpTree* rootNode)
         snort_free(primaryPatternNode);
     }
 
-    delete rootNode->patternTree;
+    if (rootNode->levels)
+    {
+        for (auto& level : *rootNode->levels)
+            delete level.patternTree;
+        delete rootNode->levels;
+    }
     snort_free(rootNode);
 }
 
@@ -311,22 +401,11 @@ static void dumpTreesRecursively(tMlmpTree* rootNode)
     }
 }
 
-/*compares multipart patterns, and orders then according to <patternId, partNum>.
-  Comparing multi-parts alphanumerically does not make sense. */
-static int compareMlmpPatternList(const tPatternNode* p1, const tPatternNode* p2)
-{
-    if (p1->patternId != p2->patternId)
-        return (p1->patternId - p2->patternId);
-
-    return (p1->partNum - p2->partNum);
-}
-
-static tPatternNode* patternSelector(const tMatchedPatternList* patternMatchList, const
+static tPatternNode* patternSelector(const tMatchedPatternList& patternMatchList, const
     uint8_t* payload, bool domain)
 {
     tPatternNode* bestNode = nullptr;
     tPatternNode* currentPrimaryNode = nullptr;
-    const tMatchedPatternList* tmpList;
     uint32_t partNum, patternId, patternSize, maxPatternSize;
 
     /*partTotal = 0; */
@@ -335,57 +414,50 @@ static tPatternNode* patternSelector(const tMatchedPatternList* patternMatchList
     patternSize = maxPatternSize = 0;
 
 #if  _MLMP_DEBUG
-    tPatternNode* ddPatternNode;
-    DebugMessage(DEBUG_APPID, "\tMatches found -------------------\n"); for (tmpList =
-        patternMatchList;
-        tmpList;
-        tmpList = tmpList->next)
+    DebugMessage(DEBUG_APPID, "\tMatches found -------------------\n");
+    for (const auto& match : patternMatchList)
     {
-        ddPatternNode = tmpList->patternNode;
-        {
-            DebugFormat(DEBUG_APPID,
-                "\t\tid %d, Pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
-                ddPatternNode->patternId,
-                ddPatternNode->pattern.pattern,
-                (uint32_t)ddPatternNode->pattern.patternSize,
-                ddPatternNode->partNum,
-                ddPatternNode->partTotal,
-                ddPatternNode->userData);
-        }
+        tPatternNode* ddPatternNode = match.patternNode;
+        DebugFormat(DEBUG_APPID,
+            "\t\tid %d, Pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
+            ddPatternNode->patternId,
+            ddPatternNode->pattern.pattern,
+            (uint32_t)ddPatternNode->pattern.patternSize,
+            ddPatternNode->partNum,
+            ddPatternNode->partTotal,
+            ddPatternNode->userData);
     }
 #endif
 
-    for (tmpList = patternMatchList;
-        tmpList;
-        tmpList = tmpList->next)
+    for (const auto& match : patternMatchList)
     {
-        if (tmpList->patternNode->patternId != patternId)
+        if (match.patternNode->patternId != patternId)
         {
             /*first pattern */
 
             /*skip incomplete pattern */
-            if (tmpList->patternNode->partNum != 1)
+            if (match.patternNode->partNum != 1)
                 continue;
 
             /*new pattern started */
-            patternId = tmpList->patternNode->patternId;
-            currentPrimaryNode = tmpList->patternNode;
+            patternId = match.patternNode->patternId;
+            currentPrimaryNode = match.patternNode;
             partNum = 0;
             patternSize = 0;
         }
 
-        if (tmpList->patternNode->partNum == (partNum+1))
+        if (match.patternNode->partNum == (partNum+1))
         {
             partNum++;
-            patternSize += tmpList->patternNode->pattern.patternSize;
+            patternSize += match.patternNode->pattern.patternSize;
         }
 
-        if (tmpList->patternNode->partTotal != partNum)
+        if (match.patternNode->partTotal != partNum)
             continue;
 
         /*backward compatibility */
-        if ((tmpList->patternNode->partTotal == 1)
-            && domain && !match_is_domain_pattern(tmpList, payload))
+        if ((match.patternNode->partTotal == 1)
+            && domain && !match_is_domain_pattern(match, payload))
             continue;
 
         /*last pattern part is seen in sequence */
@@ -399,83 +471,47 @@ static tPatternNode* patternSelector(const tMatchedPatternList* patternMatchList
 #if _MLMP_DEBUG
     if (bestNode)
     {
-        ddPatternNode = bestNode;
-        {
-            DebugFormat(DEBUG_APPID,
-                "\t\tSELECTED Id %d, pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
-                ddPatternNode->patternId,
-                ddPatternNode->pattern.pattern,
-                (uint32_t)ddPatternNode->pattern.patternSize,
-                ddPatternNode->partNum,
-                ddPatternNode->partTotal,
-                ddPatternNode->userData);
-        }
+        DebugFormat(DEBUG_APPID,
+            "\t\tSELECTED Id %d, pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
+            bestNode->patternId,
+            bestNode->pattern.pattern,
+            (uint32_t)bestNode->pattern.patternSize,
+            bestNode->partNum,
+            bestNode->partTotal,
+            bestNode->userData);
     }
     DebugMessage(DEBUG_APPID, "\tMatches end -------------------\n");
 #endif
     return bestNode;
 }
 
-static tPatternNode* urlPatternSelector(const tMatchedPatternList* patternMatchList, const
-    uint8_t* payload)
-{
-    return patternSelector (patternMatchList, payload, true);
-}
-
-static tPatternNode* genericPatternSelector(const tMatchedPatternList* patternMatchList, const
-    uint8_t* payload)
-{
-    return patternSelector (patternMatchList, payload, false);
-}
-
+/*collects the nodes of the tree being searched that use the matched part */
 static int patternMatcherCallback(void* id, void*, int match_end_pos, void* data, void*)
 {
-    tPatternNode* target = (tPatternNode*)id;
-    tMatchedPatternList** matchList = (tMatchedPatternList**)data;
-    tMatchedPatternList* prevNode;
-    tMatchedPatternList* tmpList;
-    tMatchedPatternList* newNode;
-    int cmp;
+    const tPartGroup* group = (tPartGroup*)id;
+    tMatchState* state = (tMatchState*)data;
 
-    /*sort matches by patternId, and then by partId or pattern// */
+    auto range = std::equal_range(group->nodes.begin(), group->nodes.end(), state->owner,
+        tOwnerLess());
 
-#if _MLMP_DEBUG
-    DebugFormat(DEBUG_APPID,
-        "\tCallback id %d, Pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
-        target->patternId,
-        target->pattern.pattern,
-        (uint32_t)target->pattern.patternSize,
-        target->partNum,
-        target->partTotal,
-        target->userData);
-#endif
-
-    for (prevNode = nullptr, tmpList = *matchList;
-        tmpList;
-        prevNode = tmpList, tmpList = tmpList->next)
+    for (auto it = range.first; it != range.second; ++it)
     {
-        cmp = compareMlmpPatternList (target, tmpList->patternNode);
-        if (cmp > 0 )
-            continue;
-        if (cmp == 0)
-            return 0;
-        break;
-    }
+        tPatternNode* target = *it;
+        tMatchedPattern match;
 
-    newNode = (tMatchedPatternList*)snort_calloc(sizeof(tMatchedPatternList));
-    newNode->match_start_pos = match_end_pos - target->pattern.patternSize;
-    newNode->patternNode = target;
-
-    if (prevNode == nullptr)
-    {
-        /*first node */
-        newNode->next = *matchList;
-        *matchList = newNode;
-    }
-    else
-    {
-        newNode->next = prevNode->next;
-        prevNode->next = newNode;
+#if _MLMP_DEBUG
+        DebugFormat(DEBUG_APPID,
+            "\tCallback id %d, Pattern %s, size %u, partNum %u, partTotal %u, userData %p\n",
+            target->patternId,
+            target->pattern.pattern,
+            (uint32_t)target->pattern.patternSize,
+            target->partNum,
+            target->partTotal,
+            target->userData);
+#endif
+        match.patternNode = target;
+        match.match_start_pos = match_end_pos - target->pattern.patternSize;
+        state->matches->push_back(match);
     }
 
     return 0;
@@ -583,6 +619,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
         tmpPrimaryNode->patternNode.partNum = 1;
         tmpPrimaryNode->patternNode.partTotal = partTotal;
         tmpPrimaryNode->patternNode.patternId = patternId;
+        tmpPrimaryNode->patternNode.owner = rootNode;
 
         if (prevPrimaryPatternNode)
         {
@@ -610,6 +647,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
             newNode->partNum = partNum;
             newNode->partTotal = partTotal;
             newNode->patternId = patternId;
+            newNode->owner = rootNode;
             if (partNum < partTotal)
                 newNode->nextPattern = newNode+1;
             else
@@ -24,7 +24,6 @@
 
 #include <vector>
 
-#include "appid_utils/sf_multi_mpse.h"
 #include "appid_utils/sf_mlmp.h"
 #include "flow/flow.h"
 #include "utils/util.h"
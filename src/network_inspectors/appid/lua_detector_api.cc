@@ -49,6 +49,7 @@
 #include "main/snort_debug.h"
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
+#include "time/clock_defs.h"
 
 #define OVECCOUNT 30    /* should be a multiple of 3 */
 
@@ -2420,6 +2421,9 @@ LuaDetector::~LuaDetector()
     // release the reference of the userdata on the lua side
     if ( detector_user_data_ref != LUA_REFNIL )
         luaL_unref(my_lua_state, LUA_REGISTRYINDEX, detector_user_data_ref);
+
+    if ( validate_fn_ref > 0 )
+        luaL_unref(my_lua_state, LUA_REGISTRYINDEX, validate_fn_ref);
 }
 
 int LuaDetector::lua_validate(AppIdDiscoveryArgs& args)
@@ -2441,11 +2445,35 @@ int LuaDetector::lua_validate(AppIdDiscoveryArgs& args)
         return APPID_ENULL;
     }
 
-    lua_getglobal(my_lua_state, validateFn);
+    // the function is normally resolved once at activation instead of by name per call
+    if ( validate_fn_ref > 0 )
+    {
+        lua_rawgeti(my_lua_state, LUA_REGISTRYINDEX, validate_fn_ref);
+        appid_stats.lua_validate_ref_hits++;
+    }
+    else
+    {
+        lua_getglobal(my_lua_state, validateFn);
+        appid_stats.lua_validate_ref_misses++;
+    }
+
     DebugFormat(DEBUG_APPID, "lua detector %s validating: Lua Memory usage %d\n",
         package_info.name.c_str(), lua_gc(my_lua_state, LUA_GCCOUNT, 0));
 
-    if ( lua_pcall(my_lua_state, 0, 1, 0) )
+    int status;
+
+    if ( timed )
+    {
+        hr_time start = SnortClock::now();
+        status = lua_pcall(my_lua_state, 0, 1, 0);
+
+        validate_calls++;
+        validate_ticks += (SnortClock::now() - start).count();
+    }
+    else
+        status = lua_pcall(my_lua_state, 0, 1, 0);
+
+    if ( status )
     {
         // Runtime Lua errors are suppressed in production code since detectors are written for
         // efficiency and with defensive minimum checks. Errors are dealt as exceptions
@@ -67,10 +67,17 @@ public:
     ValidateParameters validate_params;
     lua_State* my_lua_state= nullptr;
     int detector_user_data_ref = 0;    // key into LUA_REGISTRYINDEX
+    int validate_fn_ref = 0;           // key into LUA_REGISTRYINDEX, 0 until resolved
     DetectorPackageInfo package_info;
     bool is_client = false;
     unsigned int service_id = APP_ID_UNKNOWN;
 
+    // per thread validate calls and the clock ticks they took; only kept with
+    // appid debug so validate doesn't read the clock otherwise
+    bool timed = false;
+    uint64_t validate_calls = 0;
+    uint64_t validate_ticks = 0;
+
     int lua_validate(AppIdDiscoveryArgs&);
 };
 
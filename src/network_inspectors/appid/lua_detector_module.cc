@@ -28,14 +28,22 @@
 #include <glob.h>
 #include <libgen.h>
 #include <lua.hpp>
+#include <sys/stat.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
 #include "lua/lua.h"
 
 #include "appid_config.h"
+#include "appid_module.h"
 #include "lua_detector_util.h"
 #include "lua_detector_api.h"
 #include "lua_detector_flow_api.h"
 #include "detector_plugins/detector_http.h"
 #include "main/snort_debug.h"
+#include "time/clock_defs.h"
 #include "utils/util.h"
 #include "utils/sflsq.h"
 #include "log/messages.h"
@@ -48,6 +56,20 @@
 THREAD_LOCAL LuaDetectorManager* lua_detector_mgr;
 THREAD_LOCAL SF_LIST allocated_detector_flow_list;
 
+// Every packet thread loads every detector into its own lua_State. The first
+// thread to load a file keeps its bytecode here and the others load that
+// instead of parsing the source again. Entries are keyed by path and checked
+// against the file size and modification time so a reload picks up edits.
+struct LuaBytecode
+{
+    off_t size;
+    time_t mtime;
+    std::string code;
+};
+
+static std::mutex bytecode_mutex;
+static std::map<std::string, LuaBytecode> bytecode_cache;
+
 static inline bool get_lua_field(lua_State* L, int table, const char* field, std::string& out)
 {
     lua_getfield(L, table, field);
@@ -135,6 +157,55 @@ static lua_State* create_lua_state(AppIdModuleConfig* mod_config)
     return L;
 }
 
+static int dump_chunk(lua_State*, const void* p, size_t size, void* ud)
+{
+    static_cast<std::string*>(ud)->append((const char*)p, size);
+    return 0;
+}
+
+// Leaves the compiled chunk on the stack, or an error message if it fails
+static int load_detector_chunk(lua_State* L, const char* filename)
+{
+    struct stat st;
+
+    if ( stat(filename, &st) )
+    {
+        appid_stats.lua_bytecode_misses++;
+        return luaL_loadfile(L, filename);
+    }
+
+    std::string chunk_name = std::string("@") + filename;
+    {
+        std::lock_guard<std::mutex> lock(bytecode_mutex);
+        auto it = bytecode_cache.find(filename);
+
+        if ( it != bytecode_cache.end() and it->second.size == st.st_size
+            and it->second.mtime == st.st_mtime )
+        {
+            const std::string& code = it->second.code;
+            appid_stats.lua_bytecode_hits++;
+            return luaL_loadbuffer(L, code.data(), code.size(), chunk_name.c_str());
+        }
+    }
+
+    appid_stats.lua_bytecode_misses++;
+    int rc = luaL_loadfile(L, filename);
+
+    if ( rc )
+        return rc;
+
+    LuaBytecode bc;
+    bc.size = st.st_size;
+    bc.mtime = st.st_mtime;
+
+    if ( !lua_dump(L, dump_chunk, &bc.code) )
+    {
+        std::lock_guard<std::mutex> lock(bytecode_mutex);
+        bytecode_cache[filename] = std::move(bc);
+    }
+    return 0;
+}
+
 LuaDetectorManager::LuaDetectorManager(AppIdConfig& config) :
     config(config)
 {
@@ -145,6 +216,9 @@ LuaDetectorManager::LuaDetectorManager(AppIdConfig& config) :
 
 LuaDetectorManager::~LuaDetectorManager()
 {
+    if ( config.mod_config->debug )
+        list_lua_detector_calls();
+
     for ( auto& detector : allocated_detectors )
     {
         auto L = detector->my_lua_state;
@@ -345,7 +419,7 @@ void LuaDetectorManager::load_detector(char* detector_filename, bool isCustom)
         return;
     }
 
-    if ( luaL_loadfile(L, detector_filename) || lua_pcall(L, 0, 0, 0) )
+    if ( load_detector_chunk(L, detector_filename) || lua_pcall(L, 0, 0, 0) )
     {
         ErrorMessage("Error loading Lua detector: %s : %s\n", detector_filename, lua_tostring(L,
             -1));
@@ -418,6 +492,16 @@ void LuaDetectorManager::activate_lua_detectors()
         if ( lua_pcall(L, 2, 1, 0) )
             ErrorMessage("Could not initialize the %s client app element: %s\n",
                 detector->get_name().c_str(), lua_tostring(L, -1));
+        lua_pop(L, 1);
+
+        // resolve validate once so packets don't look it up by name
+        lua_getglobal(L, detector->package_info.validateFunctionName.c_str());
+        if ( lua_isfunction(L, -1) )
+            detector->validate_fn_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        else
+            lua_pop(L, 1);
+
+        detector->timed = config.mod_config->debug;
 
         ++num_active_lua_detectors;
     }
@@ -456,3 +540,29 @@ void LuaDetectorManager::list_lua_detectors()
     LogMessage("Lua Stats total memory usage %zu kb\n", totalMem);
 }
 
+void LuaDetectorManager::list_lua_detector_calls()
+{
+    uint64_t total_calls = 0;
+    uint64_t total_ticks = 0;
+
+    for ( auto& ld : allocated_detectors )
+    {
+        if ( !ld->validate_calls )
+            continue;
+
+        const char* name;
+        if ( ld->is_client )
+            name = static_cast<LuaClientDetector*>(ld)->get_name().c_str();
+        else
+            name = static_cast<LuaServiceDetector*>(ld)->get_name().c_str();
+
+        LogMessage("\tDetector %s: %" PRIu64 " validate calls, %ld usecs\n", name,
+            ld->validate_calls, clock_usecs(ld->validate_ticks));
+
+        total_calls += ld->validate_calls;
+        total_ticks += ld->validate_ticks;
+    }
+
+    LogMessage("Lua Stats total validate calls: %" PRIu64 ", %ld usecs\n", total_calls,
+        clock_usecs(total_ticks));
+}
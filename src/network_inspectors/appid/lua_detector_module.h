@@ -43,6 +43,7 @@ private:
     void initialize_lua_detectors();
     void activate_lua_detectors();
     void list_lua_detectors();
+    void list_lua_detector_calls();
     void load_detector(char* detectorName, bool isCustom);
     void load_lua_detectors(const char* path, bool isCustom);
 
@@ -56,6 +56,20 @@ public:
     }
 
     void initialize_expected_session(AppIdSession*, AppIdSession*, uint64_t flags);
+
+    // dense index assigned by ServiceDiscovery once all detectors are loaded
+    unsigned get_candidate_id() const
+    {
+        return candidate_id;
+    }
+
+    void set_candidate_id(unsigned id)
+    {
+        candidate_id = id;
+    }
+
+private:
+    unsigned candidate_id = ~0u;
 };
 #endif
 
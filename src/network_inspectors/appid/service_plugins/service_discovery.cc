@@ -26,8 +26,10 @@
 #include "service_discovery.h"
 
 #include <algorithm>
+#include <cassert>
 
 #include "appid_config.h"
+#include "appid_module.h"
 #include "appid_session.h"
 #include "app_info_table.h"
 #include "lua_detector_api.h"
@@ -158,12 +160,135 @@ void ServiceDiscovery::initialize()
         kv.second->initialize();
 }
 
+void ServicePortTable::compile()
+{
+    index.assign(APP_ID_PORT_ARRAY_SIZE, 0);
+    lists.clear();
+    lists.emplace_back();    // slot 0 means no detectors
+
+    for ( auto& kv : ports )
+    {
+        assert(lists.size() < APP_ID_PORT_ARRAY_SIZE);
+        index[kv.first] = lists.size();
+        lists.push_back(kv.second);
+    }
+}
+
+void ServiceDiscovery::assign_candidate_ids()
+{
+    unsigned id = 0;
+
+    for ( auto detectors : { &tcp_detectors, &udp_detectors } )
+    {
+        for ( auto& kv : *detectors )
+        {
+            ServiceDetector* service = static_cast<ServiceDetector*>(kv.second);
+
+            if ( service->get_candidate_id() == ~0u )
+                service->set_candidate_id(id++);
+        }
+    }
+    successes.assign(id, 0);
+}
+
 void ServiceDiscovery::finalize_service_patterns()
 {
     if (tcp_patterns)
         tcp_patterns->prep();
     if (udp_patterns)
         udp_patterns->prep();
+
+    tcp_services.compile();
+    udp_services.compile();
+    udp_reversed_services.compile();
+    assign_candidate_ids();
+
+    tcp_brute_force = std::make_shared<ServiceCandidates>();
+    for ( auto& kv : tcp_detectors )
+        tcp_brute_force->push_back(static_cast<ServiceDetector*>(kv.second));
+
+    udp_brute_force = std::make_shared<ServiceCandidates>();
+    for ( auto& kv : udp_detectors )
+        udp_brute_force->push_back(static_cast<ServiceDetector*>(kv.second));
+}
+
+void ServiceDiscovery::sort_brute_force(std::shared_ptr<ServiceCandidates>& order)
+{
+    // searches in progress hold the current order; sort a copy for new ones
+    if ( order.use_count() > 1 )
+        order = std::make_shared<ServiceCandidates>(*order);
+
+    // stable so detectors that never succeeded keep their name order
+    std::stable_sort(order->begin(), order->end(),
+        [this](const ServiceDetector* a, const ServiceDetector* b)
+        { return successes[a->get_candidate_id()] > successes[b->get_candidate_id()]; });
+}
+
+BruteForceOrder ServiceDiscovery::get_brute_force_order(IpProtocol proto)
+{
+    if ( successes_since_sort >= BRUTE_FORCE_RESORT_INTERVAL )
+    {
+        sort_brute_force(tcp_brute_force);
+        sort_brute_force(udp_brute_force);
+        successes_since_sort = 0;
+    }
+    return proto == IpProtocol::TCP ? tcp_brute_force : udp_brute_force;
+}
+
+void ServiceDiscovery::record_success(ServiceDetector* service)
+{
+    unsigned id = service->get_candidate_id();
+
+    if ( id < successes.size() )
+    {
+        successes[id]++;
+        successes_since_sort++;
+    }
+}
+
+// candidates are kept unique; the bitset covers the common case and the list
+// is searched only for detectors beyond it
+static bool is_candidate(const AppIdSession* asd, const ServiceDetector* service)
+{
+    unsigned id = service->get_candidate_id();
+
+    if ( id < SERVICE_CANDIDATE_IDS )
+        return asd->service_candidate_ids[id];
+
+    return std::find(asd->service_candidates.begin(), asd->service_candidates.end(), service)
+           != asd->service_candidates.end();
+}
+
+static void add_candidate(AppIdSession* asd, ServiceDetector* service)
+{
+    if ( is_candidate(asd, service) )
+    {
+        appid_stats.service_duplicate_candidates++;
+        return;
+    }
+    unsigned id = service->get_candidate_id();
+
+    if ( id < SERVICE_CANDIDATE_IDS )
+        asd->service_candidate_ids.set(id);
+
+    asd->service_candidates.push_back(service);
+}
+
+static void clear_candidates(AppIdSession* asd)
+{
+    asd->service_candidates.clear();
+    asd->service_candidate_ids.reset();
+}
+
+static ServiceCandidates::iterator remove_candidate(AppIdSession* asd,
+    ServiceCandidates::iterator it)
+{
+    unsigned id = (*it)->get_candidate_id();
+
+    if ( id < SERVICE_CANDIDATE_IDS )
+        asd->service_candidate_ids.reset(id);
+
+    return asd->service_candidates.erase(it);
 }
 
 int ServiceDiscovery::add_service_port(AppIdDetector* detector, const ServiceDetectorPort& pp)
@@ -175,14 +300,14 @@ int ServiceDiscovery::add_service_port(AppIdDetector* detector, const ServiceDet
         if (pp.port == 21 && !ftp_service)
             ftp_service = service;
 
-        tcp_services[ pp.port ].push_back(service);
+        tcp_services.add(pp.port, service);
     }
     else if (pp.proto == IpProtocol::UDP)
     {
         if (!pp.reversed_validation)
-            udp_services[ pp.port ].push_back(service);
+            udp_services.add(pp.port, service);
         else
-            udp_reversed_services[ pp.port ].push_back(service);
+            udp_reversed_services.add(pp.port, service);
     }
     else
     {
@@ -267,11 +392,8 @@ void ServiceDiscovery::match_services_by_pattern(AppIdSession* asd, const Packet
             std::sort(smOrderedList.begin(), smOrderedList.end(), AppIdPatternPrecedence);
             for ( auto& sm : smOrderedList )
             {
-                if ( std::find(asd->service_candidates.begin(), asd->service_candidates.end(),
-                    sm->service) == asd->service_candidates.end() )
-                {
-                    asd->service_candidates.push_back(sm->service);
-                }
+                appid_stats.service_pattern_candidates++;
+                add_candidate(asd, sm->service);
                 snort_free(sm);
             }
         }
@@ -305,26 +427,25 @@ static inline uint16_t sslPortRemap(uint16_t port)
 void ServiceDiscovery::get_port_based_services(IpProtocol protocol, uint16_t port,
     AppIdSession* asd)
 {
-    ServiceDiscovery& sd = ServiceDiscovery::get_instance();
+    const ServiceCandidates* services;
 
     if ( asd->is_decrypted() )
     {
         unsigned mapped_port = sslPortRemap(port);
-        if (mapped_port)
-        {
-            if ( sd.tcp_services.find(mapped_port) != sd.tcp_services.end() )
-                asd->service_candidates = sd.tcp_services[mapped_port];
-        }
+        services = mapped_port ? tcp_services.find(mapped_port) : nullptr;
     }
     else if ( protocol == IpProtocol::TCP )
-    {
-        if ( sd.tcp_services.find(port) != sd.tcp_services.end() )
-            asd->service_candidates = sd.tcp_services[port];
-    }
+        services = tcp_services.find(port);
     else
+        services = udp_services.find(port);
+
+    if ( services )
     {
-        if ( sd.udp_services.find(port) != sd.udp_services.end() )
-            asd->service_candidates = sd.udp_services[port];
+        clear_candidates(asd);
+        for ( auto service : *services )
+            add_candidate(asd, service);
+
+        appid_stats.service_port_candidates += services->size();
     }
 }
 
@@ -366,13 +487,14 @@ void ServiceDiscovery::get_next_service(const Packet* p, const int dir,
                 asd->tried_reverse_service = true;
                 ServiceDiscoveryState* rsds = AppIdServiceState::get(p->ptrs.ip_api.get_src(),
                     proto, p->ptrs.sp, asd->is_decrypted());
+                const ServiceCandidates* reversed = udp_reversed_services.find(p->ptrs.sp);
+
                 if ( rsds && rsds->get_service() )
-                    asd->service_candidates.push_back(rsds->get_service());
-                else if ( udp_reversed_services[p->ptrs.sp].size() )
+                    add_candidate(asd, rsds->get_service());
+                else if ( reversed )
                 {
-                    asd->service_candidates.insert(asd->service_candidates.end(),
-                        udp_reversed_services[p->ptrs.sp].begin(),
-                        udp_reversed_services[p->ptrs.sp].end());
+                    for ( auto service : *reversed )
+                        add_candidate(asd, service);
                 }
                 else if ( p->dsize )
                 {
@@ -439,6 +561,8 @@ int ServiceDiscovery::identify_service(AppIdSession* asd, Packet* p, int dir)
             else if ( !asd->service_candidates.size() )
             {
                 asd->service_detector = sds->select_detector_by_brute_force(proto);
+                if ( asd->service_detector )
+                    appid_stats.service_brute_force_tries++;
             }
         }
     }
@@ -447,7 +571,9 @@ int ServiceDiscovery::identify_service(AppIdSession* asd, Packet* p, int dir)
     if ( asd->service_detector )
     {
         ret = asd->service_detector->validate(args);
-        if (ret == APPID_NOT_COMPATIBLE)
+        if (ret == APPID_SUCCESS)
+            record_success(asd->service_detector);
+        else if (ret == APPID_NOT_COMPATIBLE)
             asd->got_incompatible_services = true;
         if (asd->session_logging_enabled)
             LogMessage("AppIdDbg %s %s returned %d\n", asd->session_logging_id,
@@ -482,11 +608,12 @@ int ServiceDiscovery::identify_service(AppIdSession* asd, Packet* p, int dir)
             {
                 ret = APPID_SUCCESS;
                 asd->service_detector = service;
-                asd->service_candidates.empty();
+                record_success(service);
+                clear_candidates(asd);
                 break;    /* done */
             }
             else if (result != APPID_INPROCESS)    /* fail */
-                asd->service_candidates.erase(it);
+                it = remove_candidate(asd, it);
             else
                 ++it;
         }
@@ -24,7 +24,9 @@
 
 #include "appid_discovery.h"
 
+#include <bitset>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "utils/sflsq.h"
@@ -41,6 +43,17 @@ class ServiceDiscoveryState;
 #define STATE_ID_NEEDED_DUPE_DETRACT_COUNT   3
 #define STATE_ID_MAX_VALID_COUNT 5
 
+// detectors with a candidate id below this are de-duplicated with a bitset
+// in the session, the rest by searching the candidate list
+#define SERVICE_CANDIDATE_IDS 1024
+
+// brute force order is re-sorted after this many identifications
+#define BRUTE_FORCE_RESORT_INTERVAL 64
+
+typedef std::vector<ServiceDetector*> ServiceCandidates;
+typedef std::shared_ptr<const ServiceCandidates> BruteForceOrder;
+typedef std::bitset<SERVICE_CANDIDATE_IDS> ServiceCandidateIds;
+
 enum SERVICE_HOST_INFO_CODE
 {
     SERVICE_HOST_INFO_NETBIOS_NAME = 1
@@ -58,6 +71,35 @@ enum SESSION_SERVICE_SEARCH_STATE
     PENDING
 };
 
+/* Detectors registered by port. Ports are collected in a map while detectors
+ * load and compiled into a flat index afterwards so a lookup costs two array
+ * reads and nothing is allocated per flow. */
+class ServicePortTable
+{
+public:
+    void add(uint16_t port, ServiceDetector* service)
+    {
+        ports[port].push_back(service);
+    }
+
+    void compile();
+
+    const ServiceCandidates* find(uint16_t port) const
+    {
+        if ( index.empty() )
+        {
+            auto it = ports.find(port);
+            return it != ports.end() ? &it->second : nullptr;
+        }
+        return index[port] ? &lists[index[port]] : nullptr;
+    }
+
+private:
+    std::map<uint16_t, ServiceCandidates> ports;
+    std::vector<uint16_t> index;        // port to lists slot, 0 if none
+    std::vector<ServiceCandidates> lists;
+};
+
 class ServiceDiscovery : public AppIdDiscovery
 {
 public:
@@ -77,16 +119,28 @@ public:
     int incompatible_data(AppIdSession*, const Packet*, int dir, ServiceDetector*);
     static int add_ftp_service_state(AppIdSession&);
 
+    // detectors for brute force, most often successful first; a re-sort
+    // leaves the order a search is walking untouched
+    BruteForceOrder get_brute_force_order(IpProtocol);
+    void record_success(ServiceDetector*);
+
 private:
     ServiceDiscovery();
     void initialize() override;
     void get_next_service(const Packet*, const int dir, AppIdSession*, ServiceDiscoveryState*);
     void get_port_based_services(IpProtocol, uint16_t port, AppIdSession*);
     void match_services_by_pattern(AppIdSession*, const Packet*, IpProtocol);
+    void assign_candidate_ids();
+    void sort_brute_force(std::shared_ptr<ServiceCandidates>&);
+
+    ServicePortTable tcp_services;
+    ServicePortTable udp_services;
+    ServicePortTable udp_reversed_services;
 
-    std::map<uint16_t, std::vector<ServiceDetector*> > tcp_services;
-    std::map<uint16_t, std::vector<ServiceDetector*> > udp_services;
-    std::map<uint16_t, std::vector<ServiceDetector*> > udp_reversed_services;
+    std::vector<uint64_t> successes;    // by candidate id
+    std::shared_ptr<ServiceCandidates> tcp_brute_force = std::make_shared<ServiceCandidates>();
+    std::shared_ptr<ServiceCandidates> udp_brute_force = std::make_shared<ServiceCandidates>();
+    unsigned successes_since_sort = 0;
 };
 
 #endif
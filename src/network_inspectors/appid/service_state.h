@@ -39,35 +39,34 @@ enum SERVICE_ID_STATE
     VALID
 };
 
+// Brute force walks every detector for the protocol. The order is taken when
+// the search starts, with the detectors that most often identified a service
+// first. A re-sort replaces the order held here instead of changing it, so a
+// search cannot skip or repeat a detector.
 class AppIdDetectorList
 {
 public:
-    AppIdDetectorList(IpProtocol proto)
-    {
-        if (proto == IpProtocol::TCP)
-            detectors = ServiceDiscovery::get_instance().get_tcp_detectors();
-        else
-            detectors = ServiceDiscovery::get_instance().get_udp_detectors();
-        dit = detectors->begin();
-    }
+    AppIdDetectorList(IpProtocol proto) :
+        detectors(ServiceDiscovery::get_instance().get_brute_force_order(proto))
+    { }
 
     ServiceDetector* next()
     {
         ServiceDetector* detector = nullptr;
 
-        if ( dit != detectors->end())
-            detector = (ServiceDetector*)(dit++)->second;
+        if ( index < detectors->size() )
+            detector = (*detectors)[index++];
         return detector;
     }
 
     void reset()
     {
-        dit = detectors->begin();
+        index = 0;
     }
 
 private:
-    AppIdDetectors* detectors;
-    AppIdDetectorsIterator dit;
+    BruteForceOrder detectors;
+    unsigned index = 0;
 };
 
 class ServiceDiscoveryState
@@ -0,0 +1,255 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sf_mlmp_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/appid_utils/sf_mlmp.cc"
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// Brute force stand in for the search engine. Matches are reported in order of end position
+// like Aho-Corasick.
+struct MockPattern
+{
+    std::string pattern;
+    void* context;
+};
+
+static std::map<const SearchTool*, std::vector<MockPattern> > mock_patterns;
+
+SearchTool::SearchTool(const char*)
+{
+    mpse = nullptr;
+    max_len = 0;
+}
+
+SearchTool::~SearchTool()
+{
+    mock_patterns.erase(this);
+}
+
+void SearchTool::add(const char* pattern, unsigned len, void* context, bool)
+{
+    mock_patterns[this].push_back({ std::string(pattern, len), context });
+}
+
+void SearchTool::prep() { }
+
+int SearchTool::find_all(const char* s, unsigned len, MpseMatch match, bool, void* data)
+{
+    for ( unsigned end = 1; end <= len; end++ )
+    {
+        for ( auto& mp : mock_patterns[this] )
+        {
+            unsigned n = mp.pattern.size();
+            if ( n > end )
+                continue;
+
+            unsigned k = 0;
+            while ( k < n and tolower(s[end - n + k]) == tolower(mp.pattern[k]) )
+                k++;
+
+            if ( k == n )
+                match(mp.context, nullptr, end, data, nullptr);
+        }
+    }
+    return 0;
+}
+
+static const uint8_t* copy(const char* s)
+{
+    size_t n = strlen(s) + 1;
+    uint8_t* p = (uint8_t*)snort_alloc(n);
+    memcpy(p, s, n);
+    return p;
+}
+
+// Adds host and path patterns, each may have several parts
+static void add(tMlmpTree* tree, std::vector<const char*> host, std::vector<const char*> path,
+    void* data)
+{
+    tMlmpPattern parts[8];
+    unsigned n = 0;
+
+    for ( auto p : host )
+    {
+        parts[n].pattern = copy(p);
+        parts[n].patternSize = strlen(p);
+        parts[n++].level = 0;
+    }
+    for ( auto p : path )
+    {
+        parts[n].pattern = copy(p);
+        parts[n].patternSize = strlen(p);
+        parts[n++].level = 1;
+    }
+    parts[n].pattern = nullptr;
+    mlmpAddPattern(tree, parts, data);
+}
+
+static void* match_url(tMlmpTree* tree, const char* host, const char* path)
+{
+    tMlmpPattern input[3];
+    input[0].pattern = (const uint8_t*)host;
+    input[0].patternSize = strlen(host);
+    input[1].pattern = (const uint8_t*)path;
+    input[1].patternSize = path ? strlen(path) : 0;
+    input[2].pattern = nullptr;
+    return mlmpMatchPatternUrl(tree, input);
+}
+
+static int A, B, C, D;
+
+TEST_GROUP(sf_mlmp_test)
+{
+};
+
+TEST(sf_mlmp_test, host_domain)
+{
+    tMlmpTree* tree = mlmpCreate();
+    add(tree, { "example.com" }, { }, &A);
+    mlmpProcessPatterns(tree);
+
+    CHECK(match_url(tree, "example.com", "/") == &A);
+    CHECK(match_url(tree, "www.EXAMPLE.com", "/") == &A);
+    CHECK(match_url(tree, "badexample.com", "/") == nullptr);
+    CHECK(match_url(tree, "example.org", "/") == nullptr);
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp_test, longest_host_and_path)
+{
+    tMlmpTree* tree = mlmpCreate();
+    add(tree, { "example.com" }, { }, &A);
+    add(tree, { "video.example.com" }, { }, &B);
+    add(tree, { "example.com" }, { "/watch" }, &C);
+    mlmpProcessPatterns(tree);
+
+    CHECK(match_url(tree, "www.example.com", "/index.html") == &A);
+    CHECK(match_url(tree, "www.example.com", "/watch?v=1") == &C);
+    CHECK(match_url(tree, "video.example.com", "/watch?v=1") == &B);
+    CHECK(match_url(tree, "video.example.com", nullptr) == &B);
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp_test, paths_belong_to_their_host)
+{
+    // the same path part under two hosts is one entry in the level's search tool
+    tMlmpTree* tree = mlmpCreate();
+    add(tree, { "one.com" }, { "/api" }, &A);
+    add(tree, { "two.com" }, { "/api" }, &B);
+    add(tree, { "two.com" }, { "/api/v2" }, &C);
+    mlmpProcessPatterns(tree);
+
+    CHECK(match_url(tree, "one.com", "/api/v2") == &A);
+    CHECK(match_url(tree, "two.com", "/api") == &B);
+    CHECK(match_url(tree, "two.com", "/api/v2") == &C);
+    CHECK(match_url(tree, "three.com", "/api") == nullptr);
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp_test, multipart)
+{
+    tMlmpTree* tree = mlmpCreate();
+    add(tree, { "cdn", ".net" }, { }, &A);
+    add(tree, { "static" }, { }, &D);
+    add(tree, { "video" }, { "/a", "/b" }, &B);
+    mlmpProcessPatterns(tree);
+
+    // multipart host patterns are not held to domain boundaries
+    CHECK(match_url(tree, "mycdn.example.net", "/") == &A);
+    CHECK(match_url(tree, "example.net", "/") == nullptr);
+    CHECK(match_url(tree, "static.cdn.org", "/") == &D);
+
+    // every part must match
+    CHECK(match_url(tree, "video.example.org", "/a/b") == &B);
+    CHECK(match_url(tree, "video.example.org", "/b/only") == nullptr);
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp_test, generic)
+{
+    tMlmpTree* tree = mlmpCreate();
+    add(tree, { "agent" }, { }, &A);
+    add(tree, { "useragent" }, { }, &B);
+    mlmpProcessPatterns(tree);
+
+    tMlmpPattern input[2];
+    input[0].pattern = (const uint8_t*)"MyAgent/1.0";
+    input[0].patternSize = strlen("MyAgent/1.0");
+    input[1].pattern = nullptr;
+    CHECK(mlmpMatchPatternGeneric(tree, input) == &A);
+
+    input[0].pattern = (const uint8_t*)"UserAgent/1.0";
+    input[0].patternSize = strlen("UserAgent/1.0");
+    CHECK(mlmpMatchPatternGeneric(tree, input) == &B);
+    mlmpDestroy(tree);
+}
+
+// Typical host and URL patterns from the built in list in http_url_patterns.cc, scaled up
+IGNORE_TEST(sf_mlmp_test, benchmark)
+{
+    static const char* hosts[] =
+    {
+        "facebook.com", "twitter.com", "youtube.com", "google.com", "yahoo.com", "msn.com",
+        "live.com", "bing.com", "amazon.com", "ebay.com", "netflix.com", "apple.com"
+    };
+    static const char* paths[] = { "/", "/api", "/video", "/login", "/search", "/images" };
+
+    tMlmpTree* tree = mlmpCreate();
+    std::vector<std::string> names;
+    unsigned count = 0;
+
+    for ( unsigned i = 0; i < 200; i++ )
+        for ( auto h : hosts )
+            names.push_back(std::to_string(i) + "." + h);
+
+    for ( auto& name : names )
+    {
+        add(tree, { name.c_str() }, { }, &A);
+        for ( auto p : paths )
+            add(tree, { name.c_str() }, { p }, &B);
+    }
+    mlmpProcessPatterns(tree);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for ( unsigned i = 0; i < 100; i++ )
+        count += match_url(tree, "www.17.youtube.com", "/video/watch?v=abcdef") == &B;
+
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    printf("%zu patterns, %u matches, %ld usecs\n", names.size() * 7, count, (long)usecs);
+    CHECK(count == 100);
+    mlmpDestroy(tree);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
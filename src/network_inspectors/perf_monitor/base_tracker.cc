@@ -38,11 +38,17 @@ BaseTracker::BaseTracker(PerfConfig* perf)
     {
         Module *m = config->modules.at(i);
         IndexVec peg_map = config->mod_peg_idxs.at(i);
+        const CountType* count_types = m->get_count_types();
 
         formatter->register_section(m->get_name());
 
         for (auto const& peg : peg_map)
+        {
             formatter->register_field(m->get_pegs()[peg].name, &(m->get_counts()[peg]));
+
+            if (count_types)
+                formatter->set_count_type(&(m->get_counts()[peg]), count_types[peg]);
+        }
     }
     formatter->finalize_fields();
 }
@@ -454,4 +454,30 @@ TEST_CASE("mixed schema", "[FbsFormatter]")
     free(cooked);
 }
 
+TEST_CASE("mixed count types", "[FbsFormatter]")
+{
+    PegCount sum = 1, now = 2, max = 3;
+    vector<PegCount> idx = { 4, 5 };
+
+    FbsFormatter f("fbs_formatter");
+    f.register_section("mixed");
+    f.register_field("sum", &sum);
+    f.register_field("now", &now);
+    f.set_count_type(&now, CountType::NOW);
+    f.register_field("idx", &idx);
+    f.register_field("max", &max);
+    f.set_count_type(&max, CountType::MAX);
+    f.finalize_fields();
+
+    // the vector is moved ahead of the pegs and the types follow the pegs
+    CHECK( f.get_count_types() == vector<CountType>(
+        { CountType::SUM, CountType::SUM, CountType::SUM, CountType::NOW, CountType::MAX }) );
+
+    vector<PegCount> counts(f.get_count_size(), 0);
+    f.add_counts(counts);
+    f.add_counts(counts);
+
+    CHECK( counts == vector<PegCount>({ 8, 10, 2, 2, 3 }) );
+}
+
 #endif
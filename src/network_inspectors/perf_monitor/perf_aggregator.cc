@@ -0,0 +1,403 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "perf_aggregator.h"
+
+#include <chrono>
+
+#include "log/messages.h"
+
+#include "base_tracker.h"
+#include "cpu_tracker.h"
+#include "flow_tracker.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+using namespace std;
+
+//-------------------------------------------------------------------------
+// snapshot
+//-------------------------------------------------------------------------
+
+PerfSnapshot::PerfSnapshot(unsigned size) : totals(size, 0), shared(size)
+{
+    seq = 0;
+    stamp = 0;
+
+    for ( auto& pc : shared )
+        pc.store(0, memory_order_relaxed);
+}
+
+void PerfSnapshot::publish(PerfFormatter* formatter, time_t timestamp)
+{
+    formatter->add_counts(totals);
+
+    uint32_t s = seq.load(memory_order_relaxed);
+    seq.store(s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for ( unsigned i = 0; i < totals.size(); i++ )
+        shared[i].store(totals[i], memory_order_relaxed);
+
+    stamp.store(timestamp, memory_order_relaxed);
+    seq.store(s + 2, memory_order_release);
+}
+
+uint32_t PerfSnapshot::read(vector<PegCount>& counts, time_t& timestamp)
+{
+    uint32_t before, after;
+
+    do
+    {
+        while ( (before = seq.load(memory_order_acquire)) & 1 )
+            this_thread::yield();
+
+        for ( unsigned i = 0; i < shared.size(); i++ )
+            counts[i] = shared[i].load(memory_order_relaxed);
+
+        timestamp = stamp.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = seq.load(memory_order_relaxed);
+    }
+    while ( before != after );
+
+    return before / 2;
+}
+
+//-------------------------------------------------------------------------
+// aggregator
+//-------------------------------------------------------------------------
+
+PerfAggregator::PerfAggregator(PerfConfig* pc)
+{
+    config = pc;
+    rotate_requested = false;
+
+    vector<PerfTracker*> trackers;
+
+    if ( config->perf_flags & PERF_BASE )
+        trackers.push_back(new BaseTracker(config));
+
+    if ( config->perf_flags & PERF_FLOW )
+        trackers.push_back(new FlowTracker(config));
+
+    if ( config->perf_flags & PERF_CPU )
+        trackers.push_back(new CPUTracker(config));
+
+    for ( auto t : trackers )
+    {
+        t->set_aggregate();
+
+        Series s;
+        s.tracker = t;
+        s.current.assign(t->formatter->get_count_size(), 0);
+        s.totals.assign(s.current.size(), 0);
+        series.push_back(s);
+    }
+}
+
+PerfAggregator::~PerfAggregator()
+{
+    stop();
+
+    for ( auto& s : series )
+    {
+        for ( auto& src : s.sources )
+            delete src.snap;
+
+        s.tracker->close();
+        delete s.tracker;
+    }
+}
+
+void PerfAggregator::add_sources(vector<PerfTracker*>& trackers)
+{
+    lock_guard<mutex> lock(series_mutex);
+
+    for ( auto t : trackers )
+    {
+        for ( auto& s : series )
+        {
+            if ( t->get_name() != s.tracker->get_name() )
+                continue;
+
+            Source src;
+            src.snap = new PerfSnapshot(s.current.size());
+            src.last.assign(s.current.size(), 0);
+            src.gen = 0;
+
+            s.sources.push_back(src);
+            t->set_snapshot(src.snap);
+            break;
+        }
+    }
+
+    if ( running or worker )
+        return;
+
+    for ( auto& s : series )
+    {
+        if ( !s.tracker->open(true) )
+            ErrorMessage("perfmonitor: can't open %s totals\n", s.tracker->get_name().c_str());
+    }
+
+    running = true;
+    worker = new thread(&PerfAggregator::run, this);
+}
+
+void PerfAggregator::stop()
+{
+    {
+        lock_guard<mutex> lock(series_mutex);
+
+        if ( !running )
+            return;
+
+        running = false;
+    }
+    cv.notify_one();
+
+    worker->join();
+    delete worker;
+    worker = nullptr;
+}
+
+void PerfAggregator::run()
+{
+    unique_lock<mutex> lock(series_mutex);
+
+    while ( running )
+    {
+        if ( config->perf_flags & PERF_SUMMARY )
+            cv.wait(lock);
+        else
+            cv.wait_for(lock, chrono::seconds(config->sample_interval));
+
+        if ( !running )
+            break;
+
+        if ( rotate_requested.exchange(false) )
+        {
+            for ( auto& s : series )
+                s.tracker->rotate();
+        }
+
+        if ( !(config->perf_flags & PERF_SUMMARY) )
+            consolidate();
+    }
+
+    // packet threads have published their final counts by now
+    consolidate();
+}
+
+void PerfAggregator::consolidate()
+{
+    for ( auto& s : series )
+        consolidate(s);
+}
+
+// totals are the sum of the changes since the last pass
+static void add_changes(
+    const vector<CountType>& types, const vector<PegCount>& current,
+    vector<PegCount>& last, vector<PegCount>& totals)
+{
+    for ( unsigned i = 0; i < current.size(); i++ )
+    {
+        if ( types[i] == CountType::SUM )
+            totals[i] += current[i] - last[i];
+
+        last[i] = current[i];
+    }
+}
+
+// current values are the sum and maximums the max of the latest from each
+// thread, including threads that haven't published since the last pass
+static void add_latest(
+    const vector<CountType>& types, const vector<PegCount>& last, vector<PegCount>& totals)
+{
+    for ( unsigned i = 0; i < last.size(); i++ )
+    {
+        if ( types[i] == CountType::NOW )
+            totals[i] += last[i];
+
+        else if ( types[i] == CountType::MAX and last[i] > totals[i] )
+            totals[i] = last[i];
+    }
+}
+
+void PerfAggregator::consolidate(Series& s)
+{
+    const vector<CountType>& types = s.tracker->formatter->get_count_types();
+    bool fresh = false;
+    time_t latest = 0;
+
+    std::fill(s.totals.begin(), s.totals.end(), 0);
+
+    for ( auto& src : s.sources )
+    {
+        time_t stamp;
+        uint32_t gen = src.snap->read(s.current, stamp);
+
+        if ( gen != src.gen )
+        {
+            add_changes(types, s.current, src.last, s.totals);
+
+            if ( stamp > latest )
+                latest = stamp;
+
+            src.gen = gen;
+            fresh = true;
+        }
+        add_latest(types, src.last, s.totals);
+    }
+
+    if ( !fresh )
+        return;
+
+    s.tracker->formatter->load_counts(s.totals);
+    s.tracker->update_time(latest);
+    s.tracker->write();
+    s.tracker->auto_rotate();
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("snapshot publish and read", "[PerfAggregator]")
+{
+    PegCount one = 1, two = 2;
+    vector<PegCount> kvp = { 3, 4, 5 };
+
+    MockFormatter f("snapshot");
+    f.register_section("name");
+    f.register_field("one", &one);
+    f.register_field("two", &two);
+    f.register_field("kvp", &kvp);
+    f.finalize_fields();
+
+    REQUIRE(f.get_count_size() == 5);
+
+    PerfSnapshot snap(f.get_count_size());
+    vector<PegCount> counts(f.get_count_size());
+    time_t stamp;
+
+    CHECK(snap.read(counts, stamp) == 0);
+
+    snap.publish(&f, 10);
+    CHECK(snap.read(counts, stamp) == 1);
+    CHECK(stamp == 10);
+    CHECK(counts == vector<PegCount>({ 1, 2, 3, 4, 5 }));
+
+    // publishes are cumulative so none are lost if the reader falls behind
+    snap.publish(&f, 20);
+    snap.publish(&f, 30);
+    CHECK(snap.read(counts, stamp) == 3);
+    CHECK(stamp == 30);
+    CHECK(counts == vector<PegCount>({ 3, 6, 9, 12, 15 }));
+}
+
+TEST_CASE("snapshot count types", "[PerfAggregator]")
+{
+    PegCount total = 1, now = 2, max = 3;
+
+    MockFormatter f("types");
+    f.register_section("name");
+    f.register_field("total", &total);
+    f.register_field("now", &now);
+    f.register_field("max", &max);
+    f.set_count_type(&now, CountType::NOW);
+    f.set_count_type(&max, CountType::MAX);
+    f.finalize_fields();
+
+    PerfSnapshot snap(f.get_count_size());
+    vector<PegCount> counts(f.get_count_size());
+    time_t stamp;
+
+    snap.publish(&f, 10);
+    total = 4;
+    now = 1;
+    max = 5;
+    snap.publish(&f, 20);
+
+    // only totals accumulate
+    CHECK(snap.read(counts, stamp) == 2);
+    CHECK(counts == vector<PegCount>({ 5, 1, 5 }));
+
+    // the types survive rebinding the fields
+    f.own_counts();
+    CHECK(f.get_count_types() ==
+        vector<CountType>({ CountType::SUM, CountType::NOW, CountType::MAX }));
+}
+
+TEST_CASE("consolidate count types", "[PerfAggregator]")
+{
+    const vector<CountType> types = { CountType::SUM, CountType::NOW, CountType::MAX };
+    vector<PegCount> last1(3, 0), last2(3, 0), totals(3, 0);
+
+    // first pass, both threads published
+    add_changes(types, { 10, 3, 5 }, last1, totals);
+    add_changes(types, { 20, 4, 9 }, last2, totals);
+    add_latest(types, last1, totals);
+    add_latest(types, last2, totals);
+
+    CHECK(totals == vector<PegCount>({ 30, 7, 9 }));
+
+    // second pass, only the first thread published
+    std::fill(totals.begin(), totals.end(), 0);
+    add_changes(types, { 11, 2, 6 }, last1, totals);
+    add_latest(types, last1, totals);
+    add_latest(types, last2, totals);
+
+    CHECK(totals == vector<PegCount>({ 1, 6, 9 }));
+}
+
+TEST_CASE("owned counts", "[PerfAggregator]")
+{
+    PegCount one = 1;
+    vector<PegCount> kvp = { 2, 3 };
+
+    MockFormatter f("owned");
+    f.register_section("name");
+    f.register_field("one", &one);
+    f.register_field("kvp", &kvp);
+    f.finalize_fields();
+    f.own_counts();
+
+    f.load_counts(vector<PegCount>({ 7, 8, 9 }));
+    f.write(nullptr, 0);
+
+    CHECK(*f.public_values["name.one"].pc == 7);
+    CHECK(f.public_values["name.kvp"].ipc->at(0) == 8);
+    CHECK(f.public_values["name.kvp"].ipc->at(1) == 9);
+
+    // the registered locations are left alone
+    CHECK(one == 1);
+    CHECK(kvp[0] == 2);
+}
+
+#endif
+
@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef PERF_AGGREGATOR_H
+#define PERF_AGGREGATOR_H
+
+//
+// With perf_monitor.aggregate set, packet threads don't format or write
+// their own stats. Instead each PerfTracker publishes a running total of its
+// counts into a PerfSnapshot. A PerfSnapshot is a single writer seqlock:
+// the packet thread never blocks and the reader retries if it raced with an
+// update.
+//
+// The PerfAggregator runs a single thread that wakes every sample interval,
+// sums the change in each snapshot since the last pass, and writes one
+// consolidated record per tracker using the configured formatter. Counts
+// that are current values or maximums (see CountType) are instead combined
+// from the latest value of each thread as Module::sum_stats() does. File
+// rotation is handled there too. Trackers with string fields (flow_ip)
+// can't be summed and continue to write per thread files.
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "framework/counts.h"
+
+#include "perf_module.h"
+
+class PerfFormatter;
+class PerfTracker;
+
+class PerfSnapshot
+{
+public:
+    PerfSnapshot(unsigned size);
+
+    // packet thread
+    void publish(PerfFormatter*, time_t);
+
+    // aggregator thread; returns the number of publishes so far
+    uint32_t read(std::vector<PegCount>&, time_t&);
+
+private:
+    std::atomic<uint32_t> seq;
+    std::atomic<uint64_t> stamp;
+
+    std::vector<PegCount> totals;  // private to the packet thread
+    std::vector<std::atomic<PegCount>> shared;
+};
+
+class PerfAggregator
+{
+public:
+    PerfAggregator(PerfConfig*);
+    ~PerfAggregator();
+
+    // called from each packet thread with its trackers; those that can be
+    // aggregated are switched to publishing and the thread is started
+    // with the first call
+    void add_sources(std::vector<PerfTracker*>&);
+
+    void rotate()
+    { rotate_requested = true; }
+
+    // write the final totals and join the aggregator thread
+    void stop();
+
+    void consolidate();
+
+private:
+    struct Source
+    {
+        PerfSnapshot* snap;
+        std::vector<PegCount> last;
+        uint32_t gen;
+    };
+
+    struct Series
+    {
+        PerfTracker* tracker;
+        std::vector<Source> sources;
+        std::vector<PegCount> current;
+        std::vector<PegCount> totals;
+    };
+
+    PerfConfig* config;
+    std::vector<Series> series;
+
+    std::mutex series_mutex;
+    std::condition_variable cv;
+    std::thread* worker = nullptr;
+    bool running = false;
+    std::atomic<bool> rotate_requested;
+
+    void run();
+    void consolidate(Series&);
+};
+
+#endif
+
@@ -70,3 +70,138 @@ void PerfFormatter::register_field(string name, vector<PegCount>* val)
     field_names[last_section].push_back(name);
 }
 
+// fields are identified by location since some formatters reorder them
+void PerfFormatter::set_count_type(const PegCount* pc, CountType ct)
+{
+    peg_types[pc] = ct;
+    count_types.clear();
+}
+
+// in count order; must be called before own_counts rebinds the fields
+const vector<CountType>& PerfFormatter::get_count_types()
+{
+    if ( !count_types.empty() )
+        return count_types;
+
+    for( unsigned i = 0; i < values.size(); i++ )
+    {
+        for( unsigned j = 0; j < values[i].size(); j++ )
+        {
+            if( types[i][j] == FT_PEG_COUNT )
+            {
+                auto t = peg_types.find(values[i][j].pc);
+                count_types.push_back(t == peg_types.end() ? CountType::SUM : t->second);
+            }
+            else if( types[i][j] == FT_IDX_PEG_COUNT )
+                count_types.insert(count_types.end(), values[i][j].ipc->size(), CountType::SUM);
+        }
+    }
+    return count_types;
+}
+
+unsigned PerfFormatter::get_count_size()
+{
+    unsigned n = 0;
+
+    for( unsigned i = 0; i < values.size(); i++ )
+    {
+        for( unsigned j = 0; j < values[i].size(); j++ )
+        {
+            if( types[i][j] == FT_PEG_COUNT )
+                n++;
+
+            else if( types[i][j] == FT_IDX_PEG_COUNT )
+                n += values[i][j].ipc->size();
+        }
+    }
+    return n;
+}
+
+// counts must be sized by get_count_size; current values and maximums
+// replace what is there since they aren't reset each interval
+void PerfFormatter::add_counts(vector<PegCount>& counts)
+{
+    const vector<CountType>& ct = get_count_types();
+    unsigned n = 0;
+
+    for( unsigned i = 0; i < values.size(); i++ )
+    {
+        for( unsigned j = 0; j < values[i].size(); j++ )
+        {
+            if( types[i][j] == FT_PEG_COUNT )
+            {
+                if( ct[n] == CountType::SUM )
+                    counts[n++] += *values[i][j].pc;
+                else
+                    counts[n++] = *values[i][j].pc;
+            }
+
+            else if( types[i][j] == FT_IDX_PEG_COUNT )
+            {
+                for( PegCount pc : *values[i][j].ipc )
+                    counts[n++] += pc;
+            }
+        }
+    }
+}
+
+void PerfFormatter::load_counts(const vector<PegCount>& counts)
+{
+    unsigned n = 0;
+
+    for( unsigned i = 0; i < values.size(); i++ )
+    {
+        for( unsigned j = 0; j < values[i].size(); j++ )
+        {
+            if( types[i][j] == FT_PEG_COUNT )
+                *values[i][j].pc = counts[n++];
+
+            else if( types[i][j] == FT_IDX_PEG_COUNT )
+            {
+                for( PegCount& pc : *values[i][j].ipc )
+                    pc = counts[n++];
+            }
+        }
+    }
+}
+
+// the registered locations are not read here; only the sizes of the
+// indexed counts are needed
+void PerfFormatter::own_counts()
+{
+    // the types are found by location so get them first
+    get_count_types();
+
+    unsigned pegs = 0, idx_pegs = 0;
+
+    for( auto& section : types )
+    {
+        for( auto type : section )
+        {
+            if( type == FT_PEG_COUNT )
+                pegs++;
+
+            else if( type == FT_IDX_PEG_COUNT )
+                idx_pegs++;
+        }
+    }
+
+    own_pegs.assign(pegs, 0);
+    own_idx_pegs.resize(idx_pegs);
+    pegs = idx_pegs = 0;
+
+    for( unsigned i = 0; i < values.size(); i++ )
+    {
+        for( unsigned j = 0; j < values[i].size(); j++ )
+        {
+            if( types[i][j] == FT_PEG_COUNT )
+                values[i][j].pc = &own_pegs[pegs++];
+
+            else if( types[i][j] == FT_IDX_PEG_COUNT )
+            {
+                own_idx_pegs[idx_pegs].assign(values[i][j].ipc->size(), 0);
+                values[i][j].ipc = &own_idx_pegs[idx_pegs++];
+            }
+        }
+    }
+}
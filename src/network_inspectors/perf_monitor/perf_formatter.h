@@ -42,8 +42,15 @@
 // init_output should be implemented where metadata needs to be written on
 // ouput open.
 //
+// The count fields can also be flattened into a vector of PegCounts in field
+// order (strings are skipped) so they can be handed to another thread. The
+// receiving formatter calls own_counts to bind its fields to private storage
+// and load_counts to fill that storage prior to writing. Counts are totals
+// unless set_count_type says they are a current value or a maximum.
+//
 
 #include <ctime>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -87,6 +94,14 @@ public:
     virtual void init_output(FILE*) {}
     virtual void write(FILE*, time_t) = 0;
 
+    virtual void set_count_type(const PegCount*, CountType) final;
+    virtual const std::vector<CountType>& get_count_types() final;
+
+    virtual unsigned get_count_size() final;
+    virtual void add_counts(std::vector<PegCount>&) final;
+    virtual void load_counts(const std::vector<PegCount>&) final;
+    virtual void own_counts() final;
+
 protected:
     std::vector<std::vector<FormatterType>> types;
     std::vector<std::vector<FormatterValue>> values;
@@ -98,11 +113,15 @@ protected:
 
 private:
     std::string tracker_name;
+
+    std::map<const PegCount*, CountType> peg_types;
+    std::vector<CountType> count_types;
+
+    std::vector<PegCount> own_pegs;
+    std::vector<std::vector<PegCount>> own_idx_pegs;
 };
 
 #ifdef UNIT_TEST
-#include <map>
-
 class MockFormatter : public PerfFormatter
 {
 public:
@@ -88,6 +88,12 @@ static const Parameter s_params[] =
     { "summary", Parameter::PT_BOOL, nullptr, "false",
       "output summary at shutdown" },
 
+    { "aggregate", Parameter::PT_BOOL, nullptr, "false",
+      "output totals across packet threads from a single aggregator thread" },
+
+    { "flow_cpu", Parameter::PT_BOOL, nullptr, "false",
+      "log the most expensive flows each interval (requires latency.flow.top)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -169,6 +175,16 @@ bool PerfMonModule::set(const char*, Value& v, SnortConfig*)
         if ( v.get_bool() )
             config.perf_flags |= PERF_SUMMARY;
     }
+    else if ( v.is("aggregate") )
+    {
+        if ( v.get_bool() )
+            config.perf_flags |= PERF_AGGREGATE;
+    }
+    else if ( v.is("flow_cpu") )
+    {
+        if ( v.get_bool() )
+            config.perf_flags |= PERF_FLOW_CPU;
+    }
     else if ( v.is("modules") )
     {
         return true;
@@ -34,6 +34,8 @@
 #define PERF_BASE_MAX   0x00000010
 #define PERF_FLOWIP     0x00000020
 #define PERF_SUMMARY    0x00000040
+#define PERF_AGGREGATE  0x00000080
+#define PERF_FLOW_CPU   0x00000100
 
 #define ROLLOVER_THRESH     512
 #define MAX_PERF_FILE_SIZE  UINT64_MAX
@@ -30,6 +30,7 @@
 
 #include "perf_monitor.h"
 
+#include "latency/flow_cpu.h"
 #include "log/messages.h"
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
@@ -38,6 +39,7 @@
 #include "cpu_tracker.h"
 #include "flow_ip_tracker.h"
 #include "flow_tracker.h"
+#include "perf_aggregator.h"
 
 #ifdef UNIT_TEST
 #include "catch/catch.hpp"
@@ -50,6 +52,7 @@ THREAD_LOCAL bool perfmon_rotate_perf_file = false;
 static PerfConfig config;
 PerfConfig* perfmon_config = &config;   // FIXIT-M remove this after flowip can be decoupled.
 THREAD_LOCAL std::vector<PerfTracker*>* trackers;
+static PerfAggregator* aggregator = nullptr;
 
 static bool ready_to_process(Packet* p);
 
@@ -106,6 +109,10 @@ void PerfMonitor::show(SnortConfig*)
     }
     LogMessage("  CPU Stats:    %s\n",
         config.perf_flags & PERF_CPU ? "ACTIVE" : "INACTIVE");
+    LogMessage("  Aggregate:    %s\n",
+        config.perf_flags & PERF_AGGREGATE ? "ACTIVE" : "INACTIVE");
+    LogMessage("  Flow CPU:     %s\n",
+        config.perf_flags & PERF_FLOW_CPU ? "ACTIVE" : "INACTIVE");
     switch(config.output)
     {
         case PERF_CONSOLE:
@@ -147,6 +154,9 @@ static void disable_tracker(size_t i)
 
 bool PerfMonitor::configure(SnortConfig*)
 {
+    if ( (config.perf_flags & PERF_AGGREGATE) && !aggregator )
+        aggregator = new PerfAggregator(&config);
+
     return true;
 }
 
@@ -166,6 +176,9 @@ void PerfMonitor::tinit()
     if (config.perf_flags & PERF_CPU )
         trackers->push_back(new CPUTracker(&config));
 
+    if ( aggregator )
+        aggregator->add_sources(*trackers);
+
     for (unsigned i = 0; i < trackers->size(); i++)
     {
         if (!(*trackers)[i]->open(true))
@@ -195,6 +208,11 @@ void PerfMonitor::tterm()
         }
         delete trackers;
     }
+
+    const unsigned summary_cpu = PERF_SUMMARY | PERF_FLOW_CPU;
+
+    if ( (config.perf_flags & summary_cpu) == summary_cpu )
+        FlowCpu::dump();
 }
 
 void PerfMonitor::eval(Packet* p)
@@ -203,6 +221,9 @@ void PerfMonitor::eval(Packet* p)
 
     if (IsSetRotatePerfFileFlag())
     {
+        if ( aggregator )
+            aggregator->rotate();
+
         for (unsigned i = 0; i < trackers->size(); i++)
         {
             if (!(*trackers)[i]->rotate())
@@ -231,6 +252,8 @@ void PerfMonitor::eval(Packet* p)
                 if (!(*trackers)[i]->auto_rotate())
                     disable_tracker(i--);
             }
+            if ( config.perf_flags & PERF_FLOW_CPU )
+                FlowCpu::dump();
         }
     }
 
@@ -295,6 +318,12 @@ static Inspector* pm_ctor(Module* m)
 static void pm_dtor(Inspector* p)
 { delete p; }
 
+static void pm_term()
+{
+    delete aggregator;
+    aggregator = nullptr;
+}
+
 static const InspectApi pm_api =
 {
     {
@@ -314,7 +343,7 @@ static const InspectApi pm_api =
     nullptr, // buffers
     nullptr, // service
     nullptr, // pinit
-    nullptr, // pterm
+    pm_term, // pterm
     nullptr, // tinit
     nullptr, // tterm
     pm_ctor,
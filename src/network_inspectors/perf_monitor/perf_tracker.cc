@@ -37,6 +37,7 @@
 #endif
 
 #include "csv_formatter.h"
+#include "perf_aggregator.h"
 #include "text_formatter.h"
 
 using namespace std;
@@ -92,6 +93,9 @@ PerfTracker::~PerfTracker()
 
 bool PerfTracker::open(bool append)
 {
+    if (snapshot)
+        return true;
+
     if (fname.length())
     {
         // FIXIT-L this should be deleted; was added as 1-time workaround to
@@ -364,5 +368,22 @@ bool PerfTracker::auto_rotate()
 
 void PerfTracker::write()
 {
-    formatter->write(fh, cur_time);
+    if (snapshot)
+        snapshot->publish(formatter, cur_time);
+    else
+        formatter->write(fh, cur_time);
+}
+
+// the aggregator's trackers never see packets; their fields are loaded
+// with the totals across threads and written to a single file
+void PerfTracker::set_aggregate()
+{
+    formatter->own_counts();
+
+    if (fname.length())
+    {
+        string tracker_fname = tracker_name;
+        tracker_fname += formatter->get_extension();
+        get_main_file(fname, tracker_fname.c_str());
+    }
 }
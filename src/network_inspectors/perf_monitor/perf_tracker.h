@@ -35,6 +35,7 @@
 // reporting thresholds have been reached.
 //
 // write() - tell the configured PerfFormatter to output the current stats
+// or publish them to the PerfAggregator if one is in use
 //
 
 #include <cstdio>
@@ -43,8 +44,12 @@
 #include "perf_formatter.h"
 #include "perf_monitor.h"
 
+class PerfSnapshot;
+
 class PerfTracker
 {
+friend class PerfAggregator;
+
 public:
     virtual void reset() {}
 
@@ -59,6 +64,10 @@ public:
     virtual bool rotate() final;
     virtual bool auto_rotate() final;
 
+    // packet thread trackers publish here instead of writing
+    virtual void set_snapshot(PerfSnapshot* ps) final
+    { snapshot = ps; }
+
     virtual ~PerfTracker();
 
 protected:
@@ -73,6 +82,9 @@ private:
     std::string tracker_name;
     FILE* fh = nullptr;
     time_t cur_time;
+    PerfSnapshot* snapshot = nullptr;
+
+    void set_aggregate();
 };
 #endif
 
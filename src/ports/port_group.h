@@ -57,6 +57,9 @@ struct PortGroup
     // pattern matchers
     class Mpse* mpse[PM_TYPE_MAX];
 
+    // longest pattern in each, for splitting searches across threads
+    unsigned max_len[PM_TYPE_MAX];
+
     // detection option tree
     void* nfp_tree;
 
@@ -72,12 +72,15 @@ void Profiler::register_module(const char* n, const char* pn, get_profile_stats_
 void Profiler::consolidate_stats()
 {
     s_profiler_nodes.accumulate_nodes();
+    consolidate_time_profiler_stats();
+    consolidate_rule_histograms();
     MemoryProfiler::consolidate_fallthrough_stats();
 }
 
 void Profiler::reset_stats()
 {
     s_profiler_nodes.reset_nodes();
+    reset_time_profiler_stats();
     reset_rule_profiler_stats();
 }
 
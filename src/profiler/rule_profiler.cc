@@ -36,11 +36,15 @@
 //     The computed value will also be garbage (duration& operator+=(const duration& __d))
 #include "detection/detection_options.h"  // ... FIXIT-W
 
+#include <mutex>
+
 #include "detection/treenodes.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
 #include "main/thread_config.h"
 #include "parser/parser.h"
 #include "target_based/snort_protocols.h"
+#include "utils/util.h"
 
 #include "profiler_printer.h"
 #include "profiler_stats_table.h"
@@ -51,6 +55,10 @@
 #endif
 
 #define s_rule_table_title "rule profile"
+#define s_rule_hist_title "rule histogram"
+
+// guards OptTreeNode::hist, which packet threads merge into as they exit
+static std::mutex hist_mutex;
 
 static inline OtnState& operator+=(OtnState& lhs, const OtnState& rhs)
 {
@@ -80,6 +88,22 @@ static const StatsTable::Field fields[] =
     { "avg/non-match", 14, '\0', 1, std::ios_base::fmtflags() },
     { "timeouts", 9, '\0', 0, std::ios_base::fmtflags() },
     { "suspends", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "p50 (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "p99 (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "max (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
+static const StatsTable::Field hist_fields[] =
+{
+    { "#", 5, '\0', 0, std::ios_base::left },
+    { "gid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "sid", 6, '\0', 0, std::ios_base::fmtflags() },
+    { "rev", 4, '\0', 0, std::ios_base::fmtflags() },
+    { "evals", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "p50 (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "p99 (us)", 9, '\0', 0, std::ios_base::fmtflags() },
+    { "max (us)", 9, '\0', 0, std::ios_base::fmtflags() },
     { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
 };
 
@@ -87,6 +111,7 @@ struct View
 {
     OtnState state;
     SigInfo sig_info;
+    RuleHistogram hist = { };
 
     hr_duration elapsed() const
     { return state.elapsed; }
@@ -132,6 +157,21 @@ struct View
     hr_duration avg_check() const
     { return time_per(elapsed(), checks()); }
 
+    // the histogram has one sample per evaluation that reaches the rule:
+    // the time spent in all options on its path, so a single slow option
+    // (eg pcre) shows up in p99 and max
+    uint64_t evals() const
+    { return hist.total(); }
+
+    hr_duration p50() const
+    { return hist.percentile(50); }
+
+    hr_duration p99() const
+    { return hist.percentile(99); }
+
+    hr_duration max() const
+    { return hist.maximum(); }
+
     View(const OtnState& otn_state, const SigInfo* si = nullptr) :
         state(otn_state)
     {
@@ -178,6 +218,16 @@ static const ProfilerSorter<View> sorters[] =
         "avg_no_match",
         [](const View& lhs, const View& rhs)
         { return lhs.avg_no_match() >= rhs.avg_no_match(); }
+    },
+    {
+        "p99",
+        [](const View& lhs, const View& rhs)
+        { return lhs.p99() >= rhs.p99(); }
+    },
+    {
+        "max",
+        [](const View& lhs, const View& rhs)
+        { return lhs.max() >= rhs.max(); }
     }
 };
 
@@ -187,6 +237,20 @@ static void consolidate_otn_states(OtnState* states)
         states[0] += states[i];
 }
 
+static RuleHistogram merge_otn_histograms(const OptTreeNode* otn)
+{
+    RuleHistogram hist = { };
+
+    if ( otn->hist )
+        hist = *otn->hist;
+
+    // samples of threads that haven't been consolidated
+    for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+        hist += otn->state[i].hist;
+
+    return hist;
+}
+
 static std::vector<View> build_entries()
 {
     assert(snort_conf);
@@ -202,6 +266,7 @@ static std::vector<View> build_entries()
         assert(otn);
 
         auto* states = otn->state;
+        auto hist = merge_otn_histograms(otn);
 
         consolidate_otn_states(states);
         auto& state = states[0];
@@ -211,11 +276,48 @@ static std::vector<View> build_entries()
 
         // FIXIT-L should we assert(otn->sigInfo)?
         entries.emplace_back(state, &otn->sigInfo);
+        entries.back().hist = hist;
+    }
+
+    return entries;
+}
+
+// unlike build_entries() this only reads the histograms merged by exited
+// packet threads so it can be used while the others are running
+static std::vector<View> build_hist_entries()
+{
+    assert(snort_conf);
+
+    auto* otn_map = snort_conf->otn_map;
+    std::vector<View> entries;
+
+    std::lock_guard<std::mutex> lock(hist_mutex);
+
+    for ( auto* h = sfghash_findfirst(otn_map); h; h = sfghash_findnext(otn_map) )
+    {
+        auto* otn = static_cast<OptTreeNode*>(h->data);
+        assert(otn);
+
+        if ( !otn->hist or !otn->hist->total() )
+            continue;
+
+        const RuleHistogram& hist = *otn->hist;
+
+        entries.emplace_back(OtnState(), &otn->sigInfo);
+        entries.back().hist = hist;
     }
 
     return entries;
 }
 
+static inline long usecs(hr_duration d)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    return clock_usecs(duration_cast<microseconds>(d).count());
+}
+
 // FIXIT-L logic duplicated from ProfilerPrinter
 static void print_single_entry(const View& v, unsigned n)
 {
@@ -246,22 +348,54 @@ static void print_single_entry(const View& v, unsigned n)
 
         table << v.timeouts();
         table << v.suspends();
+
+        table << usecs(v.p50());
+        table << usecs(v.p99());
+        table << usecs(v.max());
+    }
+
+    LogMessage("%s", ss.str().c_str());
+}
+
+static void print_hist_entry(const View& v, unsigned n)
+{
+    std::ostringstream ss;
+
+    {
+        StatsTable table(hist_fields, ss);
+
+        table << StatsTable::ROW;
+
+        table << n; // #
+
+        table << v.sig_info.gid;
+        table << v.sig_info.sid;
+        table << v.sig_info.rev;
+
+        table << v.evals();
+
+        table << usecs(v.p50());
+        table << usecs(v.p99());
+        table << usecs(v.max());
     }
 
     LogMessage("%s", ss.str().c_str());
 }
 
 // FIXIT-L logic duplicated from ProfilerPrinter
-static void print_entries(std::vector<View>& entries, ProfilerSorter<View> sort, unsigned count)
+static void print_entries(
+    std::vector<View>& entries, ProfilerSorter<View> sort, unsigned count,
+    const StatsTable::Field* cols = fields, const char* title = s_rule_table_title,
+    void (*print)(const View&, unsigned) = print_single_entry)
 {
     std::ostringstream ss;
 
     {
-        StatsTable table(fields, ss);
+        StatsTable table(cols, ss);
 
         table << StatsTable::SEP;
 
-        table << s_rule_table_title;
+        table << title;
         if ( count )
             table << " (worst " << count;
         else
@@ -284,7 +418,7 @@ static void print_entries(std::vector<View>& entries, ProfilerSorter<View> sort,
         std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), sort);
 
     for ( unsigned i = 0; i < count; ++i )
-        print_single_entry(entries[i], i + 1);
+        print(entries[i], i + 1);
 }
 
 }
@@ -306,11 +440,54 @@ void show_rule_profiler_stats(const RuleProfilerConfig& config)
     print_entries(entries, sort, config.count);
 }
 
+void show_rule_histograms(unsigned count)
+{
+    auto entries = rule_stats::build_hist_entries();
+
+    if ( entries.empty() )
+        return;
+
+    auto sort = rule_stats::sorters[RuleProfilerConfig::SORT_P99];
+
+    print_entries(entries, sort, count, rule_stats::hist_fields,
+        s_rule_hist_title, rule_stats::print_hist_entry);
+}
+
+void consolidate_rule_histograms()
+{
+    if ( !snort_conf or !snort_conf->otn_map )
+        return;
+
+    auto* otn_map = snort_conf->otn_map;
+    unsigned id = get_instance_id();
+
+    std::lock_guard<std::mutex> lock(hist_mutex);
+
+    for ( auto* h = sfghash_findfirst(otn_map); h; h = sfghash_findnext(otn_map) )
+    {
+        auto* otn = static_cast<OptTreeNode*>(h->data);
+        assert(otn);
+
+        auto& hist = otn->state[id].hist;
+
+        if ( !hist.total() )
+            continue;
+
+        if ( !otn->hist )
+            otn->hist = (RuleHistogram*)snort_calloc(sizeof(*otn->hist));
+
+        *otn->hist += hist;
+        hist.reset();
+    }
+}
+
 void reset_rule_profiler_stats()
 {
     assert(snort_conf);
     auto* otn_map = snort_conf->otn_map;
 
+    std::lock_guard<std::mutex> lock(hist_mutex);
+
     for ( auto* h = sfghash_findfirst(otn_map); h; h = sfghash_findnext(otn_map) )
     {
         auto* otn = static_cast<OptTreeNode*>(h->data);
@@ -326,6 +503,9 @@ void reset_rule_profiler_stats()
             auto& state = otn->state[i];
             state = OtnState();
         }
+
+        if ( otn->hist )
+            otn->hist->reset();
     }
 }
 
@@ -538,6 +718,63 @@ TEST_CASE( "rule entry", "[profiler][rule_profiler]" )
     }
 }
 
+TEST_CASE( "tick histogram", "[profiler][rule_profiler]" )
+{
+    ThreadHistogram node = { };
+
+    SECTION( "buckets" )
+    {
+        CHECK( ThreadHistogram::bucket(0) == 0 );
+        CHECK( ThreadHistogram::bucket(1) == 1 );
+        CHECK( ThreadHistogram::bucket(2) == 2 );
+        CHECK( ThreadHistogram::bucket(3) == 2 );
+        CHECK( ThreadHistogram::bucket(4) == 3 );
+        CHECK( ThreadHistogram::bucket(~uint64_t(0)) == TICK_HIST_BUCKETS - 1 );
+    }
+
+    SECTION( "percentiles" )
+    {
+        CHECK( (node.percentile(99) == 0_ticks) );
+
+        for ( int i = 0; i < 98; ++i )
+            node.update(10_ticks);
+
+        node.update(100_ticks);
+        node.update(5000_ticks);
+
+        CHECK( node.total() == 100 );
+        CHECK( (node.percentile(50) == 15_ticks) );
+        CHECK( (node.percentile(99) == 127_ticks) );
+        CHECK( (node.percentile(100) == 5000_ticks) );
+        CHECK( (node.maximum() == 5000_ticks) );
+    }
+
+    SECTION( "saturation" )
+    {
+        node.counts[1] = ~uint32_t(0);
+        node.counts[2] = 4;
+        node.update(1_ticks);
+
+        CHECK( node.counts[1] == (~uint32_t(0) >> 1) + 1 );
+        CHECK( node.counts[2] == 2 );
+    }
+
+    SECTION( "merge" )
+    {
+        ThreadHistogram other = { };
+        node.update(10_ticks);
+        other.update(1000_ticks);
+        other.counts[4] = ~uint32_t(0);
+
+        RuleHistogram rule = { };
+        rule += node;
+        rule += other;
+
+        CHECK( rule.total() == uint64_t(~uint32_t(0)) + 2 );
+        CHECK( (rule.maximum() == 1000_ticks) );
+    }
+}
+
 TEST_CASE( "rule profiler sorting", "[profiler][rule_profiler]" )
 {
     using Sort = RuleProfilerConfig::Sort;
@@ -674,6 +911,26 @@ TEST_CASE( "rule profiler sorting", "[profiler][rule_profiler]" )
         std::partial_sort(entries.begin(), entries.end(), entries.end(), sorter);
         CHECK( entries == expected );
     }
+
+    SECTION( "p99" )
+    {
+        RuleEntryVector entries {
+            make_rule_entry(0_ticks, 0_ticks, 1, 0),
+            make_rule_entry(0_ticks, 0_ticks, 2, 0),
+            make_rule_entry(0_ticks, 0_ticks, 3, 0)
+        };
+
+        entries[0].hist.update(10_ticks);
+        entries[1].hist.update(1000_ticks);
+        entries[2].hist.update(100_ticks);
+
+        const auto& sorter = rule_stats::sorters[Sort::SORT_P99];
+        std::partial_sort(entries.begin(), entries.end(), entries.end(), sorter);
+
+        CHECK( entries[0].checks() == 2 );
+        CHECK( entries[1].checks() == 3 );
+        CHECK( entries[2].checks() == 1 );
+    }
 }
 
 TEST_CASE( "rule profiler time context", "[profiler][rule_profiler]" )
@@ -26,4 +26,11 @@ struct RuleProfilerConfig;
 void show_rule_profiler_stats(const RuleProfilerConfig&);
 void reset_rule_profiler_stats();
 
+// move this thread's rule histograms where show_rule_histograms() can read them
+void consolidate_rule_histograms();
+
+// print the worst count rules by p99 (0 = all) from the histograms of
+// packet threads that have exited; safe to call while running
+void show_rule_histograms(unsigned count);
+
 #endif
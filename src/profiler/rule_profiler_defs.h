@@ -37,7 +37,9 @@ struct RuleProfilerConfig
         SORT_MATCHES,
         SORT_NO_MATCHES,
         SORT_AVG_MATCH,
-        SORT_AVG_NO_MATCH
+        SORT_AVG_NO_MATCH,
+        SORT_P99,
+        SORT_MAX
     } sort = SORT_TOTAL_TIME;
 
     bool show = false;
@@ -62,6 +64,9 @@ public:
 
     void stop(bool = false);
 
+    hr_duration get() const
+    { return sw.get(); }
+
     bool active() const
     { return sw.active(); }
 
@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef TICK_HISTOGRAM_H
+#define TICK_HISTOGRAM_H
+
+// log2 bucketed histogram of clock ticks.  bucket 0 counts zero tick
+// samples and bucket i counts [2^(i-1), 2^i) ticks.  the last bucket is
+// open ended; the exact max is kept separately.  all zeros (calloc) is a
+// valid empty histogram.
+//
+// packet threads record into the 32 bit version (see OtnState).
+// if a count would wrap all buckets are halved, which keeps percentiles
+// intact.  merging across threads uses the 64 bit version.
+
+#include <cstdint>
+
+#include "time/clock_defs.h"
+
+#define TICK_HIST_BUCKETS 32
+
+template<typename Count>
+struct TickHistogram
+{
+    Count counts[TICK_HIST_BUCKETS];
+    uint64_t max;
+
+    static unsigned bucket(uint64_t ticks)
+    {
+        unsigned b = ticks ? 64 - __builtin_clzll(ticks) : 0;
+        return b < TICK_HIST_BUCKETS ? b : TICK_HIST_BUCKETS - 1;
+    }
+
+    // largest value that falls in bucket b
+    static uint64_t limit(unsigned b)
+    {
+        if ( b == TICK_HIST_BUCKETS - 1 )
+            return ~uint64_t(0);
+
+        return b ? (uint64_t(1) << b) - 1 : 0;
+    }
+
+    void update(hr_duration delta)
+    {
+        uint64_t ticks = delta.count();
+        unsigned b = bucket(ticks);
+
+        if ( counts[b] == Count(~0) )
+        {
+            for ( auto& c : counts )
+                c >>= 1;
+        }
+
+        ++counts[b];
+
+        if ( ticks > max )
+            max = ticks;
+    }
+
+    template<typename Other>
+    TickHistogram& operator+=(const TickHistogram<Other>& rhs)
+    {
+        for ( unsigned i = 0; i < TICK_HIST_BUCKETS; ++i )
+            counts[i] += rhs.counts[i];
+
+        if ( rhs.max > max )
+            max = rhs.max;
+
+        return *this;
+    }
+
+    uint64_t total() const
+    {
+        uint64_t sum = 0;
+
+        for ( auto c : counts )
+            sum += c;
+
+        return sum;
+    }
+
+    // upper bound of the bucket holding the given percentile, capped by max
+    hr_duration percentile(unsigned pct) const
+    {
+        uint64_t rank = (total() * pct + 99) / 100;
+
+        if ( !rank )
+            return 0_ticks;
+
+        uint64_t seen = 0;
+
+        for ( unsigned i = 0; i < TICK_HIST_BUCKETS; ++i )
+        {
+            seen += counts[i];
+
+            if ( seen >= rank )
+                return hr_duration(limit(i) < max ? limit(i) : max);
+        }
+        return hr_duration(max);
+    }
+
+    hr_duration maximum() const
+    { return hr_duration(max); }
+
+    void reset()
+    {
+        for ( auto& c : counts )
+            c = 0;
+
+        max = 0;
+    }
+};
+
+using ThreadHistogram = TickHistogram<uint32_t>;
+using RuleHistogram = TickHistogram<uint64_t>;
+
+#endif
+
@@ -24,6 +24,9 @@
 
 #include "time_profiler.h"
 
+#include <cmath>
+#include <mutex>
+
 #include "profiler_nodes.h"
 #include "profiler_tree_builder.h"
 #include "profiler_printer.h"
@@ -36,6 +39,16 @@
 
 #define s_time_table_title "module profile"
 
+THREAD_LOCAL bool TimeProfilerSample::timing = true;
+THREAD_LOCAL bool TimeProfilerSample::sampling = false;
+THREAD_LOCAL unsigned TimeProfilerSample::phase = 0;
+THREAD_LOCAL uint64_t TimeProfilerSample::packets = 0;
+THREAD_LOCAL uint64_t TimeProfilerSample::sampled = 0;
+
+static std::mutex s_sample_mutex;
+static uint64_t s_packets = 0;
+static uint64_t s_sampled = 0;
+
 namespace time_stats
 {
 
@@ -52,6 +65,20 @@ static const StatsTable::Field fields[] =
     { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
 };
 
+static const StatsTable::Field sampled_fields[] =
+{
+    { "#", 5, ' ', 0, std::ios_base::left },
+    { "module", 24, ' ', 0, std::ios_base::fmtflags() },
+    { "layer", 6, ' ', 0, std::ios_base::fmtflags() },
+    { "checks", 10, ' ', 0, std::ios_base::fmtflags() },
+    { "time(us)", 11, ' ', 0, std::ios_base::fmtflags() },
+    { "avg/check", 11, ' ', 1, std::ios_base::fmtflags() },
+    { "+/-95%", 8, ' ', 1, std::ios_base::fmtflags() },
+    { "%/caller", 10, ' ', 2, std::ios_base::fmtflags() },
+    { "%/total", 9, ' ', 2, std::ios_base::fmtflags() },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
 struct View
 {
     std::string name;
@@ -78,6 +105,23 @@ struct View
     double pct_caller() const
     { return pct_of(caller_stats); }
 
+    // with 1 in scale sampling of packets the scaled total is a
+    // Horvitz-Thompson estimate; its variance is estimated by
+    // scale * (scale - 1) * sum(x^2) where x is the time of each sampled
+    // packet.  that assumes independent sampling so with every Nth packet
+    // it is approximate.  returns the 95% confidence half width as a
+    // percent of the estimate.
+    double pct_error(double scale) const
+    {
+        if ( scale <= 1.0 || elapsed() <= 0_ticks )
+            return 0.0;
+
+        double var = scale * (scale - 1.0) * stats.get_elapsed_sq();
+        double est = scale * double(elapsed().count());
+
+        return 1.96 * std::sqrt(var) / est * 100.0;
+    }
+
     bool operator==(const View& rhs) const
     { return name == rhs.name; }
 
@@ -133,8 +177,36 @@ static void print_fn(StatsTable& t, const View& v)
     t << clock_usecs(duration_cast<microseconds>(v.avg_check()).count());
 }
 
+static void print_sampled_fn(StatsTable& t, const View& v, double scale)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    // estimated checks and total time
+    t << uint64_t(v.checks() * scale);
+    t << long(clock_usecs(duration_cast<microseconds>(v.elapsed()).count()) * scale);
+
+    // avg/check is unbiased as is
+    t << clock_usecs(duration_cast<microseconds>(v.avg_check()).count());
+
+    t << v.pct_error(scale);
+}
+
 } // namespace time_stats
 
+void consolidate_time_profiler_stats()
+{
+    std::lock_guard<std::mutex> lock(s_sample_mutex);
+    s_packets += TimeProfilerSample::packets;
+    s_sampled += TimeProfilerSample::sampled;
+}
+
+void reset_time_profiler_stats()
+{
+    std::lock_guard<std::mutex> lock(s_sample_mutex);
+    s_packets = s_sampled = 0;
+}
+
 void show_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig& config)
 {
     if ( !config.show )
@@ -148,8 +220,24 @@ void show_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig&
 
     const auto& sorter = time_stats::sorters[config.sort];
 
-    ProfilerPrinter<time_stats::View> printer(time_stats::fields, time_stats::print_fn, sorter);
-    printer.print_table(s_time_table_title, root, config.count, config.max_depth);
+    if ( config.sample <= 1 or !s_sampled )
+    {
+        ProfilerPrinter<time_stats::View> printer(
+            time_stats::fields, time_stats::print_fn, sorter);
+        printer.print_table(s_time_table_title, root, config.count, config.max_depth);
+        return;
+    }
+
+    double scale = double(s_packets) / double(s_sampled);
+
+    ProfilerPrinter<time_stats::View> printer(time_stats::sampled_fields,
+        [scale](StatsTable& t, const time_stats::View& v)
+        { time_stats::print_sampled_fn(t, v, scale); }, sorter);
+
+    std::string title = s_time_table_title " (sampled ";
+    title += std::to_string(s_sampled) + " of " + std::to_string(s_packets) + " packets)";
+
+    printer.print_table(title, root, config.count, config.max_depth);
 }
 
 #ifdef UNIT_TEST
@@ -534,4 +622,100 @@ TEST_CASE( "time context exclude", "[profiler][time_profiler]" )
     CHECK( stats.elapsed < hr_duration::max() );
 }
 
+TEST_CASE( "time profiler sampling", "[profiler][time_profiler]" )
+{
+    TimeProfilerSample::phase = 0;
+    TimeProfilerSample::packets = 0;
+    TimeProfilerSample::sampled = 0;
+
+    SECTION( "every packet" )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            TimeProfilerSample::next(0);
+            CHECK( TimeProfilerSample::timing );
+        }
+        CHECK( TimeProfilerSample::sampled == 3 );
+    }
+
+    SECTION( "1 in 4" )
+    {
+        unsigned timed = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            TimeProfilerSample::next(4);
+            timed += TimeProfilerSample::timing;
+            CHECK( TimeProfilerSample::timing == ((i % 4) == 3) );
+        }
+
+        CHECK( timed == 4 );
+        CHECK( TimeProfilerSample::packets == 16 );
+        CHECK( TimeProfilerSample::sampled == 4 );
+    }
+
+    SECTION( "unsampled context" )
+    {
+        TimeProfilerStats stats;
+        TimeProfilerSample::next(2);
+        REQUIRE_FALSE( TimeProfilerSample::timing );
+
+        {
+            TimeContext ctx(stats);
+            CHECK( stats.ref_count == 0 );
+            avoid_optimization();
+
+            // flipping mid scope doesn't unbalance the context
+            TimeProfilerSample::timing = true;
+        }
+
+        CHECK( stats.ref_count == 0 );
+        CHECK_FALSE( stats );
+    }
+
+    SECTION( "error bounds" )
+    {
+        ProfileStats ps;
+        ps.time = { 100_ticks, 4 };
+        ps.time.elapsed_sq = 2500.0;
+
+        ProfilerNode node("foo");
+        node.set_stats(ps);
+        time_stats::View view(node);
+
+        CHECK( view.pct_error(1.0) == 0.0 );
+
+        // 1.96 * sqrt(2 * 1 * 2500) / (2 * 100) * 100
+        CHECK( view.pct_error(2.0) == Approx(1.96 * std::sqrt(5000.0) / 2.0) );
+    }
+
+    SECTION( "squared per packet" )
+    {
+        TimeProfilerStats stats;
+
+        TimeProfilerSample::next(0);
+        stats.update(3_ticks);
+        CHECK( stats.get_elapsed_sq() == 0.0 );
+
+        // scopes timed more than once per packet are squared as one
+        TimeProfilerSample::next(1);
+        TimeProfilerSample::next(2);
+        TimeProfilerSample::next(2);
+        stats.update(3_ticks);
+        stats.update(4_ticks);
+        CHECK( stats.get_elapsed_sq() == 49.0 );
+
+        TimeProfilerSample::next(2);
+        TimeProfilerSample::next(2);
+        stats.update(5_ticks);
+        CHECK( stats.get_elapsed_sq() == 74.0 );
+
+        TimeProfilerStats total;
+        total += stats;
+        CHECK( total.get_elapsed_sq() == 74.0 );
+    }
+
+    TimeProfilerSample::timing = true;
+}
+
 #endif
@@ -26,4 +26,8 @@ struct TimeProfilerConfig;
 
 void show_time_profiler_stats(ProfilerNodeMap&, const TimeProfilerConfig&);
 
+// call from packet threads at exit to total the sampled packet counts
+void consolidate_time_profiler_stats();
+void reset_time_profiler_stats();
+
 #endif
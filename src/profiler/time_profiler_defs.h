@@ -22,6 +22,7 @@
 #define TIME_PROFILER_DEFS_H
 
 #include "main/snort_types.h"
+#include "main/thread.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
@@ -38,19 +39,76 @@ struct TimeProfilerConfig
     bool show = false;
     unsigned count = 0;
     int max_depth = -1;
+    unsigned sample = 0;
+};
+
+// with profiler.modules.sample = N only every Nth packet is timed.  the
+// decision is made once per packet by next() and the contexts just check
+// the flag so unsampled packets skip the clock reads and stats updates.
+struct SO_PUBLIC TimeProfilerSample
+{
+    static THREAD_LOCAL bool timing;
+    static THREAD_LOCAL bool sampling;
+    static THREAD_LOCAL unsigned phase;
+    static THREAD_LOCAL uint64_t packets;
+    static THREAD_LOCAL uint64_t sampled;
+
+    // 0 or 1 times every packet
+    static void next(unsigned rate)
+    {
+        ++packets;
+        timing = ( ++phase >= rate );
+        phase *= !timing;
+        sampled += timing;
+        sampling = ( rate > 1 );
+    }
 };
 
 struct SO_PUBLIC TimeProfilerStats
 {
     hr_duration elapsed;
     uint64_t checks;
+
+    // the sampling unit is the packet so the error bounds need the sum of
+    // squared per packet times.  a packet's time is folded into elapsed_sq
+    // when the scope is first timed on a later sampled packet.
+    double elapsed_sq;
+    hr_duration packet_elapsed;
+    uint64_t packet;
+
     mutable unsigned int ref_count;
 
     void update(hr_duration delta)
-    { elapsed += delta; ++checks; }
+    {
+        elapsed += delta;
+        ++checks;
+
+        if ( TimeProfilerSample::sampling )
+            update_packet(delta);
+    }
+
+    void update_packet(hr_duration delta)
+    {
+        if ( packet != TimeProfilerSample::sampled )
+        {
+            elapsed_sq += squared(packet_elapsed);
+            packet_elapsed = 0_ticks;
+            packet = TimeProfilerSample::sampled;
+        }
+        packet_elapsed += delta;
+    }
+
+    double get_elapsed_sq() const
+    { return elapsed_sq + squared(packet_elapsed); }
+
+    static double squared(hr_duration d)
+    { return double(d.count()) * double(d.count()); }
 
     void reset()
-    { elapsed = 0_ticks; checks = 0; }
+    {
+        elapsed = 0_ticks; checks = 0;
+        elapsed_sq = 0.0; packet_elapsed = 0_ticks; packet = 0;
+    }
 
     operator bool() const
     { return ( elapsed > 0_ticks ) || checks; }
@@ -66,7 +124,8 @@ struct SO_PUBLIC TimeProfilerStats
         TimeProfilerStats(elapsed, checks, 0) { }
 
     constexpr TimeProfilerStats(hr_duration elapsed, uint64_t checks, unsigned int ref_count) :
-        elapsed(elapsed), checks(checks), ref_count(ref_count) { }
+        elapsed(elapsed), checks(checks), elapsed_sq(0.0), packet_elapsed(0_ticks), packet(0),
+        ref_count(ref_count) { }
 };
 
 inline bool operator==(const TimeProfilerStats& lhs, const TimeProfilerStats& rhs)
@@ -79,6 +138,7 @@ inline TimeProfilerStats& operator+=(TimeProfilerStats& lhs, const TimeProfilerS
 {
     lhs.elapsed += rhs.elapsed;
     lhs.checks += rhs.checks;
+    lhs.elapsed_sq += rhs.get_elapsed_sq();
     return lhs;
 }
 
@@ -86,9 +146,9 @@ class TimeContext
 {
 public:
     TimeContext(TimeProfilerStats& stats) :
-        stats(stats)
+        stats(stats), timing(TimeProfilerSample::timing)
     {
-        if ( stats.enter() )
+        if ( timing && stats.enter() )
             sw.start();
     }
 
@@ -104,7 +164,7 @@ public:
         stopped_once = true;
 
         // don't bother updating time if context is reentrant
-        if ( stats.exit() )
+        if ( timing && stats.exit() )
             stats.update(sw.get());
     }
 
@@ -114,6 +174,7 @@ public:
 private:
     TimeProfilerStats& stats;
     Stopwatch<SnortClock> sw;
+    bool timing;  // fixed at construction in case the packet changes
     bool stopped_once = false;
 };
 
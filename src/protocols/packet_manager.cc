@@ -40,6 +40,12 @@
 #include "icmp4.h"
 #include "icmp6.h"
 
+#ifdef UNIT_TEST
+#include <vector>
+
+#include "catch/catch.hpp"
+#endif
+
 THREAD_LOCAL ProfileStats decodePerfStats;
 
 // Decoding statistics
@@ -126,6 +132,139 @@ RawData::RawData(const DAQ_PktHdr_t* h, const uint8_t* p)
 //-------------------------------------------------------------------------
 // Encode/Decode functions
 //-------------------------------------------------------------------------
+
+// record the layer just decoded and move on to the next one
+inline void PacketManager::next_layer(
+    Packet* p, RawData& raw, CodecData& codec_data,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    // internal statistics and record keeping
+    s_stats[mapped_prot + stat_offset]++; // add correct decode for previous layer
+    mapped_prot = CodecManager::s_proto_map[to_utype(codec_data.next_prot_id)];
+    prev_prot_id = codec_data.next_prot_id;
+
+    // set for next call
+    const uint16_t curr_lyr_len = codec_data.lyr_len + codec_data.invalid_bytes;
+    assert(curr_lyr_len <= raw.len);
+    raw.len -= curr_lyr_len;
+    raw.data += curr_lyr_len;
+    p->proto_bits |= codec_data.proto_bits;
+    codec_data.next_prot_id = ProtocolId::FINISHED_DECODE;
+    codec_data.lyr_len = 0;
+    codec_data.invalid_bytes = 0;
+    codec_data.proto_bits = 0;
+}
+
+// returns false if decoding must stop at this layer
+bool PacketManager::decode_layer(
+    Packet* p, RawData& raw, CodecData& codec_data, DecodeData& unsure_encap_ptrs,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    DebugFormat(DEBUG_DECODE, "Codec %s (protocol_id: %hu:"
+        "ip header starts at: %p, length is %d\n",
+        CodecManager::s_protocols[mapped_prot]->get_name(),
+        static_cast<uint16_t>(codec_data.next_prot_id), p->pkt, codec_data.lyr_len);
+
+    if ( codec_data.codec_flags & CODEC_ETHER_NEXT )
+    {
+        if ( codec_data.next_prot_id < ProtocolId::ETHERTYPE_MINIMUM )
+        {
+            SnortEventqAdd(GID_DECODE, DECODE_BAD_ETHER_TYPE);
+            return false;
+        }
+        codec_data.codec_flags &= ~CODEC_ETHER_NEXT;
+    }
+
+    /*
+     * We only want the layer immediately following SAVE_LAYER to have the
+     * UNSURE_ENCAP flag set.  So, if this is a SAVE_LAYER, zero out the
+     * bit and the next time around, when this is no longer SAVE_LAYER,
+     * we will zero out the UNSURE_ENCAP flag.
+     */
+    if (codec_data.codec_flags & CODEC_SAVE_LAYER)
+    {
+        codec_data.codec_flags &= ~CODEC_SAVE_LAYER;
+        unsure_encap_ptrs = p->ptrs;
+    }
+    else
+    {
+        codec_data.codec_flags &= ~CODEC_UNSURE_ENCAP;
+    }
+
+    if (codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT))
+    {
+        // FIXIT-M refactor when ip_proto's become an array
+        if ( p->is_fragment() )
+        {
+            if ( prev_prot_id == ProtocolId::FRAGMENT )
+            {
+                const ip::IP6Frag* const fragh =
+                    reinterpret_cast<const ip::IP6Frag*>(raw.data);
+                p->ip_proto_next = fragh->next();
+            }
+            else
+            {
+                p->ip_proto_next = p->ptrs.ip_api.get_ip4h()->proto();
+            }
+        }
+        else
+        {
+            if(codec_data.next_prot_id != ProtocolId::FINISHED_DECODE)
+                p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
+        }
+    }
+
+    // If we have reached the MAX_LAYERS, we keep decoding
+    // but no longer keep track of the layers.
+    if ( p->num_layers == CodecManager::max_layers )
+        SnortEventqAdd(GID_DECODE, DECODE_TOO_MANY_LAYERS);
+    else
+        push_layer(p, prev_prot_id, raw.data, codec_data.lyr_len);
+
+    next_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+    return true;
+}
+
+// Most traffic is eth [vlan] ip4 | ip6 tcp | udp.  Those layers are decoded
+// here with only the record keeping they can need: the codecs are the same
+// and a layer that sets SAVE_LAYER or ETHER_NEXT, is a fragment, or exceeds
+// the layer limit goes through decode_layer().  The default codec is not
+// called once the last layer is done since it would only return false.
+// Returns true if the generic loop must take over at mapped_prot.
+bool PacketManager::decode_fast(
+    Packet* p, RawData& raw, CodecData& codec_data, DecodeData& unsure_encap_ptrs,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    while ( CodecManager::fast_codecs[mapped_prot] )
+    {
+        if ( !CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs) )
+            return false;
+
+        if ( (codec_data.codec_flags & (CODEC_SAVE_LAYER | CODEC_ETHER_NEXT)) or
+            p->is_fragment() or p->num_layers == CodecManager::max_layers )
+        {
+            if ( !decode_layer(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id) )
+                return false;
+            continue;
+        }
+
+        codec_data.codec_flags &= ~CODEC_UNSURE_ENCAP;
+
+        if ( (codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT)) and
+            codec_data.next_prot_id != ProtocolId::FINISHED_DECODE )
+        {
+            p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
+        }
+
+        push_layer(p, prev_prot_id, raw.data, codec_data.lyr_len);
+        next_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+        if ( prev_prot_id == ProtocolId::FINISHED_DECODE )
+            return false;
+    }
+    return true;
+}
+
 void PacketManager::decode(
     Packet* p, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt, bool cooked)
 {
@@ -151,84 +290,13 @@ void PacketManager::decode(
     s_stats[total_processed]++;
 
     // loop until the protocol id is no longer valid
-    while (CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
+    if ( decode_fast(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id) )
     {
-        DebugFormat(DEBUG_DECODE, "Codec %s (protocol_id: %hu:"
-            "ip header starts at: %p, length is %d\n",
-            CodecManager::s_protocols[mapped_prot]->get_name(),
-            static_cast<uint16_t>(codec_data.next_prot_id), pkt, codec_data.lyr_len);
-
-        if ( codec_data.codec_flags & CODEC_ETHER_NEXT )
+        while ( CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs) )
         {
-            if ( codec_data.next_prot_id < ProtocolId::ETHERTYPE_MINIMUM )
-            {
-                SnortEventqAdd(GID_DECODE, DECODE_BAD_ETHER_TYPE);
+            if ( !decode_layer(p, raw, codec_data, unsure_encap_ptrs, mapped_prot, prev_prot_id) )
                 break;
-            }
-            codec_data.codec_flags &= ~CODEC_ETHER_NEXT;
-        }
-                
-        /*
-         * We only want the layer immediately following SAVE_LAYER to have the
-         * UNSURE_ENCAP flag set.  So, if this is a SAVE_LAYER, zero out the
-         * bit and the next time around, when this is no longer SAVE_LAYER,
-         * we will zero out the UNSURE_ENCAP flag.
-         */
-        if (codec_data.codec_flags & CODEC_SAVE_LAYER)
-        {
-            codec_data.codec_flags &= ~CODEC_SAVE_LAYER;
-            unsure_encap_ptrs = p->ptrs;
-        }
-        else
-        {
-            codec_data.codec_flags &= ~CODEC_UNSURE_ENCAP;
         }
-
-        if (codec_data.proto_bits & (PROTO_BIT__IP | PROTO_BIT__IP6_EXT))
-        {
-            // FIXIT-M refactor when ip_proto's become an array
-            if ( p->is_fragment() )
-            {
-                if ( prev_prot_id == ProtocolId::FRAGMENT )
-                {
-                    const ip::IP6Frag* const fragh =
-                        reinterpret_cast<const ip::IP6Frag*>(raw.data);
-                    p->ip_proto_next = fragh->next();
-                }
-                else
-                {
-                    p->ip_proto_next = p->ptrs.ip_api.get_ip4h()->proto();
-                }
-            }
-            else
-            {
-                if(codec_data.next_prot_id != ProtocolId::FINISHED_DECODE)
-                    p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
-            }
-        }
-
-        // If we have reached the MAX_LAYERS, we keep decoding
-        // but no longer keep track of the layers.
-        if ( p->num_layers == CodecManager::max_layers )
-            SnortEventqAdd(GID_DECODE, DECODE_TOO_MANY_LAYERS);
-        else
-            push_layer(p, prev_prot_id, raw.data, codec_data.lyr_len);
-
-        // internal statistics and record keeping
-        s_stats[mapped_prot + stat_offset]++; // add correct decode for previous layer
-        mapped_prot = CodecManager::s_proto_map[to_utype(codec_data.next_prot_id)];
-        prev_prot_id = codec_data.next_prot_id;
-
-        // set for next call
-        const uint16_t curr_lyr_len = codec_data.lyr_len + codec_data.invalid_bytes;
-        assert(curr_lyr_len <= raw.len);
-        raw.len -= curr_lyr_len;
-        raw.data += curr_lyr_len;
-        p->proto_bits |= codec_data.proto_bits;
-        codec_data.next_prot_id = ProtocolId::FINISHED_DECODE;
-        codec_data.lyr_len = 0;
-        codec_data.invalid_bytes = 0;
-        codec_data.proto_bits = 0;
     }
 
     DebugFormat(DEBUG_DECODE, "Codec %s (protocol_id: %hu: ip header"
@@ -911,3 +979,269 @@ void PacketManager::log_protocols(TextLog* const text_log,
     }
 }
 
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+typedef std::vector<uint8_t> Bytes;
+
+static void put16(Bytes& b, unsigned v)
+{
+    b.push_back((v >> 8) & 0xff);
+    b.push_back(v & 0xff);
+}
+
+static void set16(Bytes& b, unsigned off, unsigned v)
+{
+    b[off] = (v >> 8) & 0xff;
+    b[off + 1] = v & 0xff;
+}
+
+static uint32_t add_sum(const uint8_t* d, unsigned n, uint32_t sum = 0)
+{
+    for ( unsigned i = 0; i < n; i += 2 )
+        sum += (d[i] << 8) | ((i + 1 < n) ? d[i + 1] : 0);
+
+    return sum;
+}
+
+static uint16_t fold(uint32_t sum)
+{
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return ~sum & 0xffff;
+}
+
+static const uint8_t ip4_src[] = { 10, 1, 1, 1 };
+static const uint8_t ip4_dst[] = { 10, 1, 1, 2 };
+static const uint8_t ip6_src[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+static const uint8_t ip6_dst[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2 };
+
+// transport header and payload with a zero checksum
+static Bytes make_l4(IpProtocol proto, const char* data)
+{
+    Bytes b;
+
+    switch ( proto )
+    {
+    case IpProtocol::TCP:
+        put16(b, 40000); put16(b, 80);
+        put16(b, 0); put16(b, 1);         // seq
+        put16(b, 0); put16(b, 1);         // ack
+        b.push_back(5 << 4); b.push_back(0x18);
+        put16(b, 8192); put16(b, 0); put16(b, 0);
+        break;
+
+    case IpProtocol::UDP:
+        put16(b, 40000); put16(b, 53);
+        put16(b, 8 + strlen(data)); put16(b, 0);
+        break;
+
+    default:  // icmp echo
+        b.push_back(8); b.push_back(0);
+        put16(b, 0); put16(b, 1); put16(b, 1);
+        break;
+    }
+    b.insert(b.end(), data, data + strlen(data));
+    return b;
+}
+
+static unsigned checksum_offset(IpProtocol proto)
+{
+    return (proto == IpProtocol::TCP) ? 16 : (proto == IpProtocol::UDP) ? 6 : 2;
+}
+
+static Bytes make_ip4(IpProtocol proto, Bytes l4, unsigned frag = 0)
+{
+    if ( proto == IpProtocol::ICMPV4 )
+        set16(l4, 2, fold(add_sum(l4.data(), l4.size())));
+
+    else if ( (proto == IpProtocol::TCP or proto == IpProtocol::UDP) and
+        l4.size() > checksum_offset(proto) + 1 )
+    {
+        uint32_t sum = add_sum(ip4_src, 4);
+        sum = add_sum(ip4_dst, 4, sum);
+        sum += to_utype(proto) + l4.size();
+        set16(l4, checksum_offset(proto), fold(add_sum(l4.data(), l4.size(), sum)));
+    }
+
+    Bytes b = { 0x45, 0 };
+    put16(b, 20 + l4.size());
+    put16(b, 0x1234); put16(b, frag);
+    b.push_back(64); b.push_back(to_utype(proto));
+    put16(b, 0);
+    b.insert(b.end(), ip4_src, ip4_src + 4);
+    b.insert(b.end(), ip4_dst, ip4_dst + 4);
+    set16(b, 10, fold(add_sum(b.data(), b.size())));
+
+    b.insert(b.end(), l4.begin(), l4.end());
+    return b;
+}
+
+static Bytes make_ip6(IpProtocol proto, Bytes l4, bool hop_opts = false)
+{
+    uint32_t sum = add_sum(ip6_src, 16);
+    sum = add_sum(ip6_dst, 16, sum);
+    sum += to_utype(proto) + l4.size();
+    set16(l4, checksum_offset(proto), fold(add_sum(l4.data(), l4.size(), sum)));
+
+    Bytes ext;
+
+    if ( hop_opts )
+        ext = { (uint8_t)to_utype(proto), 0, 1, 4, 0, 0, 0, 0 };  // padn
+
+    Bytes b = { 0x60, 0, 0, 0 };
+    put16(b, ext.size() + l4.size());
+    b.push_back(hop_opts ? 0 : to_utype(proto));
+    b.push_back(64);
+    b.insert(b.end(), ip6_src, ip6_src + 16);
+    b.insert(b.end(), ip6_dst, ip6_dst + 16);
+
+    b.insert(b.end(), ext.begin(), ext.end());
+    b.insert(b.end(), l4.begin(), l4.end());
+    return b;
+}
+
+static Bytes make_gre(const Bytes& ip)
+{
+    Bytes b;
+    put16(b, 0);
+    put16(b, to_utype(ProtocolId::ETHERTYPE_IPV4));
+    b.insert(b.end(), ip.begin(), ip.end());
+    return b;
+}
+
+static Bytes make_eth(ProtocolId type, const Bytes& payload, unsigned vlans = 0)
+{
+    Bytes b = { 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 6 };
+
+    for ( unsigned i = 0; i < vlans; ++i )
+    {
+        put16(b, to_utype(ProtocolId::ETHERTYPE_8021Q));
+        put16(b, 100 + i);
+    }
+    put16(b, to_utype(type));
+
+    b.insert(b.end(), payload.begin(), payload.end());
+    return b;
+}
+
+class DecodeTest
+{
+public:
+    // decode as if the daq were ethernet
+    DecodeTest()
+    {
+        grinder = CodecManager::grinder;
+        grinder_id = CodecManager::grinder_id;
+        fast_codecs = CodecManager::fast_codecs;
+
+        CodecManager::grinder = PacketManager::proto_idx(ProtocolId::ETHERNET_802_3);
+        CodecManager::grinder_id = ProtocolId::ETHERNET_802_3;
+    }
+
+    ~DecodeTest()
+    {
+        CodecManager::grinder = grinder;
+        CodecManager::grinder_id = grinder_id;
+        CodecManager::fast_codecs = fast_codecs;
+    }
+
+    // everything decode() produces in a comparable form
+    std::vector<uint64_t> decode(const Bytes& frame, bool fast)
+    {
+        DAQ_PktHdr_t pkth;
+        memset(&pkth, 0, sizeof(pkth));
+        pkth.caplen = pkth.pktlen = frame.size();
+
+        Packet p(false);
+        auto stats = PacketManager::s_stats;
+
+        CodecManager::set_fast_decode(fast);
+        PacketManager::decode(&p, &pkth, frame.data());
+
+        std::vector<uint64_t> v;
+
+        for ( unsigned i = 0; i < PacketManager::s_stats.size(); ++i )
+            v.push_back(PacketManager::s_stats[i] - stats[i]);
+
+        v.push_back(p.num_layers);
+
+        for ( unsigned i = 0; i < p.num_layers; ++i )
+        {
+            v.push_back(to_utype(p.layers[i].prot_id));
+            v.push_back(p.layers[i].start - frame.data());
+            v.push_back(p.layers[i].length);
+        }
+
+        v.push_back(p.proto_bits);
+        v.push_back(p.packet_flags);
+        v.push_back(to_utype(p.ip_proto_next));
+        v.push_back((uint64_t)p.data);
+        v.push_back(p.dsize);
+
+        v.push_back((uint64_t)p.ptrs.tcph);
+        v.push_back((uint64_t)p.ptrs.udph);
+        v.push_back((uint64_t)p.ptrs.icmph);
+        v.push_back(p.ptrs.sp);
+        v.push_back(p.ptrs.dp);
+        v.push_back(p.ptrs.decode_flags);
+        v.push_back(to_utype(p.ptrs.type));
+        v.push_back((uint64_t)p.ptrs.ip_api.get_ip4h());
+        v.push_back((uint64_t)p.ptrs.ip_api.get_ip6h());
+
+        return v;
+    }
+
+private:
+    ProtocolIndex grinder;
+    ProtocolId grinder_id;
+    std::array<bool, UINT8_MAX> fast_codecs;
+};
+
+TEST_CASE("fast decode matches generic decode", "[PacketManager]")
+{
+    const Bytes tcp = make_l4(IpProtocol::TCP, "GET / HTTP/1.1\r\n\r\n");
+    const Bytes udp = make_l4(IpProtocol::UDP, "query");
+    const Bytes icmp = make_l4(IpProtocol::ICMPV4, "ping");
+
+    const Bytes frames[] =
+    {
+        // all fast
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::TCP, tcp)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::UDP, udp)),
+        make_eth(ProtocolId::ETHERTYPE_IPV6, make_ip6(IpProtocol::TCP, tcp)),
+        make_eth(ProtocolId::ETHERTYPE_IPV6, make_ip6(IpProtocol::UDP, udp)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::TCP, tcp), 1),
+        make_eth(ProtocolId::ETHERTYPE_IPV6, make_ip6(IpProtocol::UDP, udp), 2),
+
+        // handed to decode_layer() or back to the generic loop
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::UDP, udp, 0x2000)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::UDP, udp, 0x0001)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::ICMPV4, icmp)),
+        make_eth(ProtocolId::ETHERTYPE_IPV6, make_ip6(IpProtocol::UDP, udp, true)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4,
+            make_ip4(IpProtocol::GRE, make_gre(make_ip4(IpProtocol::TCP, tcp)))),
+        make_eth(ProtocolId::ETHERTYPE_ARP, Bytes(28, 0)),
+
+        // failures at each layer
+        make_eth(ProtocolId::ETHERTYPE_IPV4, Bytes(10, 0x45)),
+        make_eth(ProtocolId::ETHERTYPE_IPV4, make_ip4(IpProtocol::TCP, Bytes(12, 0))),
+        Bytes(8, 0),
+    };
+
+    DecodeTest test;
+    unsigned n = 0;
+
+    for ( const auto& frame : frames )
+    {
+        INFO("frame " << n++);
+        CHECK(test.decode(frame, false) == test.decode(frame, true));
+    }
+}
+
+#endif
@@ -143,9 +143,18 @@ public:
 private:
     // The only time we should accumulate is when CodecManager tells us too
     friend void CodecManager::thread_term();
+#ifdef UNIT_TEST
+    friend class DecodeTest;
+#endif
     static void accumulate();
     static void pop_teredo(Packet*, RawData&);
 
+    static bool decode_fast(
+        Packet*, RawData&, CodecData&, DecodeData&, ProtocolIndex&, ProtocolId&);
+    static bool decode_layer(
+        Packet*, RawData&, CodecData&, DecodeData&, ProtocolIndex&, ProtocolId&);
+    static void next_layer(Packet*, RawData&, CodecData&, ProtocolIndex&, ProtocolId&);
+
     static bool encode(const Packet*, EncodeFlags,
         uint8_t lyr_start, IpProtocol next_prot, Buffer& buf);
 
@@ -23,12 +23,34 @@
 
 #include "search_tool.h"
 
+#include <cstring>
+
 #include "managers/mpse_manager.h"
 #include "main/snort_config.h"
 #include "detection/fp_config.h"
 
+#include "small_search.h"
+
+static void add_patterns(Mpse* mpse, const std::vector<SmallPattern>& pats)
+{
+    for ( const auto& p : pats )
+    {
+        Mpse::PatternDescriptor desc(p.no_case, false, true);
+        mpse->add_pattern(nullptr, (const uint8_t*)p.bytes.data(), p.bytes.size(), desc, p.id);
+    }
+}
+
+// SmallSearch reports what ac_bnfa does so it only stands in for that
 SearchTool::SearchTool() : SearchTool("ac_bnfa")
 {
+    FastPatternConfig* fp = snort_conf->fast_pattern_config;
+    const MpseApi* api = fp ? fp->get_search_api() : nullptr;
+
+    if ( !api or !strcmp(api->base.name, "ac_bnfa") )
+    {
+        pending = new std::vector<SmallPattern>;
+        opt = fp and fp->get_search_opt();
+    }
 }
 
 SearchTool::SearchTool(const char* method)
@@ -47,7 +69,13 @@ SearchTool::SearchTool(const char* method)
 
 SearchTool::~SearchTool()
 {
-    MpseManager::delete_search_engine(mpse);
+    if ( small )
+        SmallSearch::release(small);
+
+    delete pending;
+
+    if ( mpse )
+        MpseManager::delete_search_engine(mpse);
 }
 
 void SearchTool::add(const char* pat, unsigned len, int id, bool no_case)
@@ -69,7 +97,20 @@ void SearchTool::add(const uint8_t* pat, unsigned len, void* id, bool no_case)
 {
     Mpse::PatternDescriptor desc(no_case, false, true);
 
-    if ( mpse )
+    if ( pending and pending->size() == SmallSearch::max_patterns )
+    {
+        // too many for a small search
+        if ( mpse )
+            add_patterns(mpse, *pending);
+
+        delete pending;
+        pending = nullptr;
+    }
+
+    if ( pending )
+        pending->push_back({ std::string((const char*)pat, len), no_case, id });
+
+    else if ( mpse )
         mpse->add_pattern(nullptr,  pat, len, desc, id);
 
     if ( len > max_len )
@@ -78,6 +119,22 @@ void SearchTool::add(const uint8_t* pat, unsigned len, void* id, bool no_case)
 
 void SearchTool::prep()
 {
+    if ( pending )
+    {
+        small = SmallSearch::acquire(*pending, opt);
+
+        if ( !small and mpse )
+            add_patterns(mpse, *pending);
+
+        delete pending;
+        pending = nullptr;
+
+        if ( small and mpse )
+        {
+            MpseManager::delete_search_engine(mpse);
+            mpse = nullptr;
+        }
+    }
     if ( mpse )
         mpse->prep_patterns(nullptr);
 }
@@ -98,6 +155,12 @@ int SearchTool::find(
     if ( !user_data )
         user_data = (void*)str;
 
+    if ( small )
+    {
+        state = 0;
+        return small->search((const uint8_t*)str, len, mf, user_data);
+    }
+
     int num = mpse->search((const uint8_t*)str, len, mf, user_data, &state);
 
     return num;
@@ -129,6 +192,9 @@ int SearchTool::find_all(
     if ( !user_data )
         user_data = (void*)str;
 
+    if ( small )
+        return small->search((const uint8_t*)str, len, mf, user_data);
+
     int state = 0;
 
     int num = mpse->search_all((const uint8_t*)str, len, mf, user_data, &state);
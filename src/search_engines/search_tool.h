@@ -20,8 +20,17 @@
 #ifndef SEARCH_TOOL_H
 #define SEARCH_TOOL_H
 
+#include <vector>
+
 #include "framework/mpse.h"
 
+class SmallSearch;
+struct SmallPattern;
+
+// Tools made with the default constructor when the configured engine is
+// ac_bnfa and that end up with no more than 64 patterns use a shared
+// SmallSearch instead of an mpse.  It reports the same matches.
+
 class SO_PUBLIC SearchTool
 {
 public:
@@ -49,6 +58,10 @@ public:
 private:
     class Mpse* mpse;
     unsigned max_len;
+
+    SmallSearch* small = nullptr;
+    std::vector<SmallPattern>* pending = nullptr;  // patterns held until prep
+    bool opt = false;                              // search_optimize
 };
 
 #endif
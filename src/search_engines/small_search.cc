@@ -0,0 +1,251 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// small_search.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "small_search.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+
+static vector<SmallSearch*> s_sets;
+static mutex s_sets_mutex;
+
+static bool same(const vector<SmallPattern>& a, const vector<SmallPattern>& b)
+{
+    if ( a.size() != b.size() )
+        return false;
+
+    for ( unsigned i = 0; i < a.size(); ++i )
+    {
+        if ( a[i].bytes != b[i].bytes or a[i].no_case != b[i].no_case or a[i].id != b[i].id )
+            return false;
+    }
+    return true;
+}
+
+static inline uint8_t upper(uint8_t c)
+{ return (c >= 'a' and c <= 'z') ? c - ('a' - 'A') : c; }
+
+SmallSearch::SmallSearch(const vector<SmallPattern>& v, bool o) : pats(v), opt(o)
+{
+    assert(pats.size() <= max_patterns);
+}
+
+// builds the automaton the way bnfa does so the same pattern is reported.
+// states are numbered as bnfa numbers them, taking the patterns last added
+// first.  a state's own patterns are listed in the order added and the list
+// of its failure state is prepended to them one entry at a time.  with opt,
+// a failure state whose transitions are all also transitions of the state
+// is skipped, as is any failure state of a state with no transitions.
+bool SmallSearch::compile()
+{
+    uint8_t classes[256] = { };
+
+    for ( const auto& p : pats )
+    {
+        for ( uint8_t c : p.bytes )
+        {
+            if ( !classes[upper(c)] )
+                classes[upper(c)] = num_classes++;
+        }
+    }
+    for ( unsigned c = 0; c < 256; ++c )
+        xlat[c] = classes[upper(c)];
+
+    const unsigned nc = num_classes;
+    vector<int> go(nc, -1);
+    vector<vector<int>> own(1);
+
+    for ( int i = (int)pats.size() - 1; i >= 0; --i )
+    {
+        unsigned state = 0;
+
+        for ( uint8_t c : pats[i].bytes )
+        {
+            const unsigned at = state * nc + xlat[c];
+
+            if ( go[at] < 0 )
+            {
+                go[at] = own.size();
+                own.emplace_back();
+                go.resize(go.size() + nc, -1);
+            }
+            state = go[at];
+        }
+        own[state].insert(own[state].begin(), i);
+    }
+
+    const unsigned num_states = own.size();
+
+    if ( num_states * nc > 0x10000 )
+        return false;
+
+    vector<unsigned> fail(num_states, 0);
+    vector<vector<int>> list(num_states);
+    vector<unsigned> queue;
+
+    for ( unsigned k = 0; k < nc; ++k )
+    {
+        if ( go[k] > 0 )
+        {
+            list[go[k]] = own[go[k]];
+            queue.push_back(go[k]);
+        }
+    }
+
+    for ( unsigned i = 0; i < queue.size(); ++i )
+    {
+        const unsigned r = queue[i];
+
+        for ( unsigned k = 0; k < nc; ++k )
+        {
+            const int s = go[r * nc + k];
+
+            if ( s < 0 )
+                continue;
+
+            unsigned f = fail[r];
+
+            while ( f and go[f * nc + k] < 0 )
+                f = fail[f];
+
+            fail[s] = (go[f * nc + k] > 0) ? go[f * nc + k] : 0;
+
+            list[s].assign(list[fail[s]].rbegin(), list[fail[s]].rend());
+            list[s].insert(list[s].end(), own[s].begin(), own[s].end());
+            queue.push_back(s);
+        }
+    }
+
+    if ( opt )
+    {
+        auto contains = [&go, nc](unsigned k, unsigned j)
+        {
+            if ( std::all_of(&go[k * nc], &go[k * nc] + nc, [](int s) { return s < 0; }) )
+                return true;
+
+            for ( unsigned c = 0; c < nc; ++c )
+            {
+                if ( go[j * nc + c] >= 0 and go[k * nc + c] < 0 )
+                    return false;
+            }
+            return true;
+        };
+
+        for ( unsigned k = 2; k < num_states; ++k )
+        {
+            while ( fail[k] and contains(k, fail[k]) )
+                fail[k] = fail[fail[k]];
+        }
+    }
+
+    // failure states are shallower so the dfa rows they need are done first
+    next.assign(num_states * nc, 0);
+    head.assign(num_states, -1);
+
+    for ( unsigned k = 0; k < nc; ++k )
+        next[k] = (go[k] > 0) ? go[k] : 0;
+
+    for ( unsigned s : queue )
+    {
+        for ( unsigned k = 0; k < nc; ++k )
+        {
+            const int to = go[s * nc + k];
+            next[s * nc + k] = (to >= 0) ? to : next[fail[s] * nc + k];
+        }
+        if ( !list[s].empty() )
+            head[s] = list[s].front();
+    }
+    return true;
+}
+
+SmallSearch* SmallSearch::acquire(const vector<SmallPattern>& v, bool opt)
+{
+    lock_guard<mutex> lock(s_sets_mutex);
+
+    for ( auto ss : s_sets )
+    {
+        if ( ss->opt == opt and same(ss->pats, v) )
+        {
+            ++ss->refs;
+            return ss;
+        }
+    }
+
+    SmallSearch* ss = new SmallSearch(v, opt);
+
+    if ( !ss->compile() )
+    {
+        delete ss;
+        return nullptr;
+    }
+    s_sets.push_back(ss);
+    return ss;
+}
+
+void SmallSearch::release(SmallSearch* ss)
+{
+    lock_guard<mutex> lock(s_sets_mutex);
+
+    if ( --ss->refs )
+        return;
+
+    s_sets.erase(find(s_sets.begin(), s_sets.end(), ss));
+    delete ss;
+}
+
+// a callback returning > 0 stops the search and one returning < 0 lets the
+// same state be reported again, as with ac_bnfa
+int SmallSearch::search(const uint8_t* s, unsigned len, MpseMatch match, void* user_data) const
+{
+    const uint16_t* dfa = next.data();
+    const unsigned nc = num_classes;
+    unsigned state = 0;
+    unsigned last = ~0u, saved;
+    int found = 0;
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        state = dfa[state * nc + xlat[s[i]]];
+
+        if ( head[state] < 0 or state == last )
+            continue;
+
+        saved = last;
+        last = state;
+        ++found;
+
+        int res = match(pats[head[state]].id, nullptr, i + 1, user_data, nullptr);
+
+        if ( res > 0 )
+            return found;
+
+        if ( res < 0 )
+            last = saved;
+    }
+    return found;
+}
+
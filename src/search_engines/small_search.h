@@ -0,0 +1,72 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// small_search.h
+
+#ifndef SMALL_SEARCH_H
+#define SMALL_SEARCH_H
+
+// Searches a set of up to 64 patterns such as protocol commands, the kind of
+// table SearchTool is mostly used for. The patterns are compiled into a
+// small Aho-Corasick dfa over the classes of bytes they use, so the tables
+// are a few KB instead of a full automaton. Matches are reported exactly as
+// ac_bnfa reports them: case is folded, only the head of a state's match
+// list is reported, and a state is not reported again until another one
+// has matched. Identical sets built for different policies share one
+// instance.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "framework/mpse.h"
+
+struct SmallPattern
+{
+    std::string bytes;
+    bool no_case;
+    void* id;
+};
+
+class SmallSearch
+{
+public:
+    static const unsigned max_patterns = 64;
+
+    // returns a shared instance for the given patterns or nullptr if they
+    // need more states than fit in the tables; opt follows search_optimize
+    // as bnfaSetOpt() does; release when done
+    static SmallSearch* acquire(const std::vector<SmallPattern>&, bool opt);
+    static void release(SmallSearch*);
+
+    int search(const uint8_t* s, unsigned len, MpseMatch, void* user_data) const;
+
+private:
+    SmallSearch(const std::vector<SmallPattern>&, bool opt);
+    bool compile();
+
+    std::vector<SmallPattern> pats;   // in the order added
+    bool opt;
+    uint8_t xlat[256];                // case folded byte class
+    unsigned num_classes = 1;         // class 0 is bytes in no pattern
+    std::vector<uint16_t> next;       // state * num_classes + class
+    std::vector<int8_t> head;         // pattern reported in a state or -1
+    unsigned refs = 1;
+};
+
+#endif
+
@@ -27,8 +27,12 @@
 #include "search_engines/search_tool.h"
 #undef private
 
+#include <stdio.h>
 #include <string.h>
 
+#include <utility>
+#include <vector>
+
 #include "framework/base_api.h"
 #include "framework/mpse.h"
 #include "managers/mpse_manager.h"
@@ -140,9 +144,9 @@ Mpse* MpseManager::get_search_engine(
     return MpseManager::get_search_engine("ac_bnfa");
 }
 
-void MpseManager::delete_search_engine(Mpse*)
+void MpseManager::delete_search_engine(Mpse* mpse)
 {
-    mpse_api->dtor(acf);
+    mpse_api->dtor(mpse);
 }
 
 Mpse::Mpse(const char*, bool) { }
@@ -240,6 +244,162 @@ TEST(search_tool_tests, search_all_ac_bnfa)
     delete stool;
 }
 
+struct SmallMatch
+{
+    int id;
+    int index;
+};
+
+static int small_match(void* id, void*, int index, void* context, void*)
+{
+    SmallMatch* sm = (SmallMatch*)context;
+    sm->id = (int)(long)id;
+    sm->index = index;
+    return 1;
+}
+
+static SearchTool* smtp_commands()
+{
+    SearchTool* stool = new SearchTool;
+    stool->add("HELO", 4, 1);
+    stool->add("EHLO", 4, 2);
+    stool->add("MAIL FROM", 9, 3);
+    stool->add("RCPT TO", 7, 4);
+    stool->add("TO", 2, 5);
+    stool->add("DATA", 4, 6);
+    stool->prep();
+    return stool;
+}
+
+TEST(search_tool_tests, small)
+{
+    SearchTool* stool = smtp_commands();
+    CHECK(stool->small);
+    CHECK(!stool->mpse);
+
+    SmallMatch sm = { 0, 0 };
+    const char* datastr = "ehlo mail.example.com";
+    CHECK(stool->find(datastr, strlen(datastr), small_match, false, &sm) == 1);
+    CHECK(sm.id == 2);
+    CHECK(sm.index == 4);
+
+    // as with ac_bnfa, a suffix that is also a pattern is reported instead
+    datastr = "rcpt to:<user@example.com>";
+    CHECK(stool->find(datastr, strlen(datastr), small_match, false, &sm) == 1);
+    CHECK(sm.id == 5);
+    CHECK(sm.index == 7);
+
+    datastr = "NOOP";
+    CHECK(stool->find(datastr, strlen(datastr), small_match, false, &sm) == 0);
+
+    // all matches when the callback doesn't stop the search
+    datastr = "helo, data to";
+    CHECK(stool->find_all(datastr, strlen(datastr), Test_SearchStrFound) == 3);
+
+    // confined to the length of the longest pattern
+    datastr = "0123456789DATA";
+    CHECK(stool->find(datastr, strlen(datastr), small_match, true, &sm) == 0);
+    delete stool;
+}
+
+TEST(search_tool_tests, small_shared)
+{
+    SearchTool* one = smtp_commands();
+    SearchTool* two = smtp_commands();
+    CHECK(one->small == two->small);
+
+    SearchTool* other = new SearchTool;
+    other->add("USER", 4, 1);
+    other->prep();
+    CHECK(other->small != one->small);
+
+    delete one;
+    delete other;
+
+    SmallMatch sm = { 0, 0 };
+    const char* datastr = "MAIL FROM:<>";
+    CHECK(two->find(datastr, strlen(datastr), small_match, false, &sm) == 1);
+    CHECK(sm.id == 3);
+    delete two;
+}
+
+typedef std::vector<std::pair<int, int>> Matches;
+
+static int all_matches(void* id, void*, int index, void* context, void*)
+{
+    ((Matches*)context)->push_back({ (int)(long)id, index });
+    return 0;
+}
+
+static void check_same(SearchTool* bnfa, SearchTool* small, const char* s)
+{
+    Matches expected, got;
+    int n = bnfa->find_all(s, strlen(s), all_matches, false, &expected);
+    CHECK(small->find_all(s, strlen(s), all_matches, false, &got) == n);
+    CHECK(got == expected);
+}
+
+static void small_vs_bnfa(bool opt)
+{
+    static const char* pats[] =
+    { "AUTH", "XAUTH", "SELECT", "UNSELECT", "A", "TO", "RCPT TO", "data", "ATA", "AA" };
+
+    SearchTool* small = new SearchTool;
+    small->opt = opt;
+
+    SearchTool* bnfa = new SearchTool("ac_bnfa");
+    bnfa->mpse->set_opt(opt);
+
+    for ( unsigned i = 0; i < sizeof(pats) / sizeof(pats[0]); ++i )
+    {
+        small->add(pats[i], strlen(pats[i]), i + 1, i & 1);
+        bnfa->add(pats[i], strlen(pats[i]), i + 1, i & 1);
+    }
+    small->prep();
+    bnfa->prep();
+    CHECK(small->small);
+
+    check_same(bnfa, small, "XAUTH PLAIN");
+    check_same(bnfa, small, "a1 UNSELECT");
+    check_same(bnfa, small, "aaa");
+    check_same(bnfa, small, "a a a");
+    check_same(bnfa, small, "rcpt to:<a@b> DATA data DaTa");
+    check_same(bnfa, small, "xauthunselectaata");
+    check_same(bnfa, small, "");
+
+    delete small;
+    delete bnfa;
+}
+
+TEST(search_tool_tests, small_matches_bnfa)
+{
+    small_vs_bnfa(false);
+}
+
+TEST(search_tool_tests, small_matches_bnfa_opt)
+{
+    small_vs_bnfa(true);
+}
+
+TEST(search_tool_tests, small_too_many)
+{
+    SearchTool* stool = new SearchTool;
+    char pat[8];
+
+    for ( int i = 0; i < 65; ++i )
+    {
+        snprintf(pat, sizeof(pat), "P%03d", i);
+        stool->add(pat, 4, i);
+    }
+    stool->prep();
+    CHECK(stool->mpse);
+    CHECK(!stool->small);
+
+    const char* datastr = "p000 p064";
+    CHECK(stool->find(datastr, strlen(datastr), Test_SearchStrFound) == 2);
+    delete stool;
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
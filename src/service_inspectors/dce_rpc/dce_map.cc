@@ -0,0 +1,633 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// dce_map.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "dce_map.h"
+
+#include "utils/util.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+#define DCE2_MAP_MIN_TABLE 16
+#define DCE2_SLAB_ALIGN 16
+
+static inline uint32_t DCE2_MapHash(const DCE2_Map* map, uint32_t key)
+{
+    return (key * 2654435769u) >> map->shift;
+}
+
+static inline bool DCE2_MapIsInline(const DCE2_Map* map)
+{
+    return map->nodes == map->inline_nodes;
+}
+
+static void DCE2_MapResetInline(DCE2_Map* map)
+{
+    memset(map->inline_nodes, 0, sizeof(map->inline_nodes));
+    map->nodes = map->inline_nodes;
+    map->size = DCE2_MAP_INLINE;
+    map->used = 0;
+    map->shift = 0;
+    map->num_nodes = 0;
+    map->current = -1;
+}
+
+static DCE2_MapNode* DCE2_MapLookup(DCE2_Map* map, uint32_t key)
+{
+    if (DCE2_MapIsInline(map))
+    {
+        for (uint32_t i = 0; i < DCE2_MAP_INLINE; i++)
+        {
+            DCE2_MapNode* n = &map->nodes[i];
+
+            if ((n->state == DCE2_MAP_STATE__USED) && (n->key == key))
+                return n;
+        }
+        return nullptr;
+    }
+
+    const uint32_t mask = map->size - 1;
+
+    for (uint32_t i = DCE2_MapHash(map, key); ; i = (i + 1) & mask)
+    {
+        DCE2_MapNode* n = &map->nodes[i];
+
+        if (n->state == DCE2_MAP_STATE__EMPTY)
+            return nullptr;
+
+        if ((n->state == DCE2_MAP_STATE__USED) && (n->key == key))
+            return n;
+    }
+}
+
+// key must not be in the map and there must be an empty slot
+static void DCE2_MapPut(DCE2_Map* map, uint32_t key, void* data)
+{
+    DCE2_MapNode* n = nullptr;
+
+    if (DCE2_MapIsInline(map))
+    {
+        for (uint32_t i = 0; i < DCE2_MAP_INLINE; i++)
+        {
+            if (map->nodes[i].state != DCE2_MAP_STATE__USED)
+            {
+                n = &map->nodes[i];
+                break;
+            }
+        }
+    }
+    else
+    {
+        const uint32_t mask = map->size - 1;
+        uint32_t i = DCE2_MapHash(map, key);
+
+        while (map->nodes[i].state == DCE2_MAP_STATE__USED)
+            i = (i + 1) & mask;
+
+        n = &map->nodes[i];
+
+        if (n->state == DCE2_MAP_STATE__EMPTY)
+            map->used++;
+    }
+
+    n->key = key;
+    n->data = data;
+    n->state = DCE2_MAP_STATE__USED;
+    map->num_nodes++;
+}
+
+// moves the entries to a table with room for at least num more
+static void DCE2_MapGrow(DCE2_Map* map, uint32_t num)
+{
+    uint32_t size = DCE2_MAP_MIN_TABLE;
+    uint32_t shift = 28;
+
+    // keep the load below 3/4
+    while ((num * 4) > (size * 3))
+    {
+        size *= 2;
+        shift--;
+    }
+
+    DCE2_MapNode* old = map->nodes;
+    uint32_t old_size = map->size;
+    bool was_inline = DCE2_MapIsInline(map);
+
+    map->nodes = (DCE2_MapNode*)snort_calloc(size, sizeof(DCE2_MapNode));
+    map->size = size;
+    map->shift = shift;
+    map->used = 0;
+    map->num_nodes = 0;
+
+    for (uint32_t i = 0; i < old_size; i++)
+    {
+        if (old[i].state == DCE2_MAP_STATE__USED)
+            DCE2_MapPut(map, old[i].key, old[i].data);
+    }
+
+    if (!was_inline)
+        snort_free((void*)old);
+}
+
+/********************************************************************
+ * Function: DCE2_MapNew()
+ *
+ * Creates and returns a new map object.
+ *
+ * Arguments:
+ *  DCE2_MapDataFree
+ *      An optional function to call to free data in the map.
+ *      If NULL is passed in, the user will have to manually free
+ *      the data.
+ *
+ * Returns:
+ *  DCE2_Map *
+ *      Pointer to a valid map object.
+ *
+ ********************************************************************/
+DCE2_Map* DCE2_MapNew(DCE2_MapDataFree df)
+{
+    DCE2_Map* map = (DCE2_Map*)snort_calloc(sizeof(DCE2_Map));
+
+    map->data_free = df;
+    DCE2_MapResetInline(map);
+
+    return map;
+}
+
+/********************************************************************
+ * Function: DCE2_MapInsert()
+ *
+ * Adds data to the map under key unless the key is already in the
+ * map.
+ *
+ * Returns:
+ *  DCE2_Ret
+ *      DCE2_RET__ERROR if a NULL map object was passed in
+ *      DCE2_RET__DUPLICATE if the key is already in the map
+ *      DCE2_RET__SUCCESS if the data was added
+ *
+ ********************************************************************/
+DCE2_Ret DCE2_MapInsert(DCE2_Map* map, uint32_t key, void* data)
+{
+    if (map == nullptr)
+        return DCE2_RET__ERROR;
+
+    if (DCE2_MapLookup(map, key) != nullptr)
+        return DCE2_RET__DUPLICATE;
+
+    if (DCE2_MapIsInline(map))
+    {
+        if (map->num_nodes == DCE2_MAP_INLINE)
+            DCE2_MapGrow(map, map->num_nodes + 1);
+    }
+    else if (((map->used + 1) * 4) > (map->size * 3))
+    {
+        // rehashing also drops the deleted slots
+        DCE2_MapGrow(map, map->num_nodes * 2 + 1);
+    }
+
+    DCE2_MapPut(map, key, data);
+    return DCE2_RET__SUCCESS;
+}
+
+/********************************************************************
+ * Function: DCE2_MapFind()
+ *
+ * Returns the data stored under key or NULL if the key is not in
+ * the map or the map is NULL.
+ *
+ ********************************************************************/
+void* DCE2_MapFind(DCE2_Map* map, uint32_t key)
+{
+    if (map == nullptr)
+        return nullptr;
+
+    DCE2_MapNode* n = DCE2_MapLookup(map, key);
+
+    return n ? n->data : nullptr;
+}
+
+/********************************************************************
+ * Function: DCE2_MapFindKey()
+ *
+ * Determines if key is in the map.  Use this instead of
+ * DCE2_MapFind() when the data stored may be NULL.
+ *
+ * Returns:
+ *  DCE2_Ret
+ *      DCE2_RET__SUCCESS if the key is in the map
+ *      DCE2_RET__ERROR if not or the map is NULL
+ *
+ ********************************************************************/
+DCE2_Ret DCE2_MapFindKey(DCE2_Map* map, uint32_t key)
+{
+    if ((map == nullptr) || (DCE2_MapLookup(map, key) == nullptr))
+        return DCE2_RET__ERROR;
+
+    return DCE2_RET__SUCCESS;
+}
+
+static void DCE2_MapRemoveNode(DCE2_Map* map, DCE2_MapNode* n)
+{
+    if (map->data_free != nullptr)
+        map->data_free(n->data);
+
+    // inline nodes are never probed past so they can just be emptied
+    n->state = DCE2_MapIsInline(map) ? DCE2_MAP_STATE__EMPTY : DCE2_MAP_STATE__DELETED;
+    n->data = nullptr;
+    map->num_nodes--;
+}
+
+/********************************************************************
+ * Function: DCE2_MapRemove()
+ *
+ * Removes the entry for key, calling the data free function on its
+ * data.
+ *
+ * Returns:
+ *  DCE2_Ret
+ *      DCE2_RET__SUCCESS if the entry was removed
+ *      DCE2_RET__ERROR if the key is not in the map or the map is NULL
+ *
+ ********************************************************************/
+DCE2_Ret DCE2_MapRemove(DCE2_Map* map, uint32_t key)
+{
+    if (map == nullptr)
+        return DCE2_RET__ERROR;
+
+    DCE2_MapNode* n = DCE2_MapLookup(map, key);
+
+    if (n == nullptr)
+        return DCE2_RET__ERROR;
+
+    DCE2_MapRemoveNode(map, n);
+    return DCE2_RET__SUCCESS;
+}
+
+static void* DCE2_MapScan(DCE2_Map* map, uint32_t from)
+{
+    for (uint32_t i = from; i < map->size; i++)
+    {
+        if (map->nodes[i].state == DCE2_MAP_STATE__USED)
+        {
+            map->current = (int)i;
+            return map->nodes[i].data;
+        }
+    }
+
+    map->current = (int)map->size;
+    return nullptr;
+}
+
+/********************************************************************
+ * Function: DCE2_MapFirst()
+ * Function: DCE2_MapNext()
+ *
+ * Iterate over the data in the map in no particular order.  The
+ * current entry may be removed with DCE2_MapRemoveCurrent() but the
+ * map must not be otherwise changed while iterating.
+ *
+ ********************************************************************/
+void* DCE2_MapFirst(DCE2_Map* map)
+{
+    if (map == nullptr)
+        return nullptr;
+
+    return DCE2_MapScan(map, 0);
+}
+
+void* DCE2_MapNext(DCE2_Map* map)
+{
+    if ((map == nullptr) || (map->current < 0))
+        return nullptr;
+
+    return DCE2_MapScan(map, (uint32_t)map->current + 1);
+}
+
+/********************************************************************
+ * Function: DCE2_MapRemoveCurrent()
+ *
+ * Removes the entry last returned by DCE2_MapFirst() or
+ * DCE2_MapNext(), calling the data free function on its data.
+ *
+ ********************************************************************/
+void DCE2_MapRemoveCurrent(DCE2_Map* map)
+{
+    if ((map == nullptr) || (map->current < 0) || ((uint32_t)map->current >= map->size))
+        return;
+
+    DCE2_MapNode* n = &map->nodes[map->current];
+
+    if (n->state == DCE2_MAP_STATE__USED)
+        DCE2_MapRemoveNode(map, n);
+}
+
+/********************************************************************
+ * Function: DCE2_MapEmpty()
+ *
+ * Removes all of the entries in a map, calling the data free
+ * function on their data.  Does not delete the map object itself.
+ *
+ ********************************************************************/
+void DCE2_MapEmpty(DCE2_Map* map)
+{
+    if (map == nullptr)
+        return;
+
+    if (map->data_free != nullptr)
+    {
+        for (uint32_t i = 0; i < map->size; i++)
+        {
+            if (map->nodes[i].state == DCE2_MAP_STATE__USED)
+                map->data_free(map->nodes[i].data);
+        }
+    }
+
+    if (!DCE2_MapIsInline(map))
+        snort_free((void*)map->nodes);
+
+    DCE2_MapResetInline(map);
+}
+
+/********************************************************************
+ * Function: DCE2_MapDestroy()
+ *
+ * Destroys the map object and all of the data associated with it.
+ *
+ ********************************************************************/
+void DCE2_MapDestroy(DCE2_Map* map)
+{
+    if (map == nullptr)
+        return;
+
+    DCE2_MapEmpty(map);
+    snort_free(map);
+}
+
+//--------------------------------------------------------------------------
+// slab
+//--------------------------------------------------------------------------
+
+// chunks are linked through their first slot
+static inline uint32_t DCE2_SlabObjSize(const DCE2_Slab* slab)
+{
+    return (slab->obj_size + DCE2_SLAB_ALIGN - 1) & ~(DCE2_SLAB_ALIGN - 1);
+}
+
+static void DCE2_SlabFreeChunks(DCE2_Slab* slab)
+{
+    while (slab->chunks != nullptr)
+    {
+        void* next = *(void**)slab->chunks;
+        snort_free(slab->chunks);
+        slab->chunks = next;
+    }
+
+    slab->free_list = nullptr;
+    slab->num_chunks = 0;
+}
+
+void* DCE2_SlabAlloc(DCE2_Slab* slab)
+{
+    const uint32_t size = DCE2_SlabObjSize(slab);
+
+    if (slab->free_list == nullptr)
+    {
+        uint8_t* chunk = (uint8_t*)snort_calloc(DCE2_SLAB_ALIGN + size * slab->objs_per_chunk);
+
+        *(void**)chunk = slab->chunks;
+        slab->chunks = chunk;
+        slab->num_chunks++;
+
+        for (uint32_t i = slab->objs_per_chunk; i > 0; i--)
+        {
+            void* obj = chunk + DCE2_SLAB_ALIGN + (i - 1) * size;
+            *(void**)obj = slab->free_list;
+            slab->free_list = obj;
+        }
+    }
+
+    void* obj = slab->free_list;
+    slab->free_list = *(void**)obj;
+    slab->live++;
+    slab->released = false;
+
+    memset(obj, 0, slab->obj_size);
+    return obj;
+}
+
+void DCE2_SlabFree(DCE2_Slab* slab, void* obj)
+{
+    if (obj == nullptr)
+        return;
+
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+
+    if ((--slab->live == 0) && slab->released)
+        DCE2_SlabFreeChunks(slab);
+}
+
+// objects may still be held by flows that outlive the inspector so the
+// chunks are freed when the last one is returned
+void DCE2_SlabRelease(DCE2_Slab* slab)
+{
+    slab->released = true;
+
+    if (slab->live == 0)
+        DCE2_SlabFreeChunks(slab);
+}
+
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static unsigned map_frees = 0;
+
+static void map_data_free(void*)
+{
+    map_frees++;
+}
+
+static void* map_data(uint32_t key)
+{
+    return (void*)(uintptr_t)(key + 1);
+}
+
+TEST_CASE("DCE2_Map - inline entries move to a table", "[dce_map]")
+{
+    DCE2_Map* map = DCE2_MapNew(map_data_free);
+    map_frees = 0;
+
+    for (uint32_t key = 0; key < DCE2_MAP_INLINE; key++)
+        REQUIRE(DCE2_MapInsert(map, key, map_data(key)) == DCE2_RET__SUCCESS);
+
+    CHECK(DCE2_MapIsInline(map));
+    CHECK(DCE2_MapInsert(map, 0, map_data(0)) == DCE2_RET__DUPLICATE);
+
+    REQUIRE(DCE2_MapInsert(map, DCE2_MAP_INLINE, map_data(DCE2_MAP_INLINE)) ==
+        DCE2_RET__SUCCESS);
+
+    CHECK(!DCE2_MapIsInline(map));
+    CHECK(DCE2_MapCount(map) == DCE2_MAP_INLINE + 1);
+
+    for (uint32_t key = 0; key <= DCE2_MAP_INLINE; key++)
+        CHECK(DCE2_MapFind(map, key) == map_data(key));
+
+    CHECK(DCE2_MapFind(map, DCE2_MAP_INLINE + 1) == nullptr);
+    CHECK(DCE2_MapFindKey(map, DCE2_MAP_INLINE + 1) == DCE2_RET__ERROR);
+    CHECK(map_frees == 0);
+
+    DCE2_MapDestroy(map);
+    CHECK(map_frees == DCE2_MAP_INLINE + 1);
+}
+
+TEST_CASE("DCE2_Map - deleted slots keep probe chains intact", "[dce_map]")
+{
+    DCE2_Map* map = DCE2_MapNew(map_data_free);
+    map_frees = 0;
+
+    for (uint32_t key = 0; key <= DCE2_MAP_INLINE; key++)
+        DCE2_MapInsert(map, key, map_data(key));
+
+    REQUIRE(!DCE2_MapIsInline(map));
+
+    // two more keys with the same free home slot so the second one is probed for
+    uint32_t first = 100;
+
+    while (map->nodes[DCE2_MapHash(map, first)].state != DCE2_MAP_STATE__EMPTY)
+        first++;
+
+    uint32_t second = first + 1;
+
+    while (DCE2_MapHash(map, second) != DCE2_MapHash(map, first))
+        second++;
+
+    REQUIRE(DCE2_MapInsert(map, first, map_data(first)) == DCE2_RET__SUCCESS);
+    REQUIRE(DCE2_MapInsert(map, second, map_data(second)) == DCE2_RET__SUCCESS);
+    const uint32_t used = map->used;
+
+    REQUIRE(DCE2_MapRemove(map, first) == DCE2_RET__SUCCESS);
+    CHECK(map_frees == 1);
+    CHECK(map->nodes[DCE2_MapHash(map, first)].state == DCE2_MAP_STATE__DELETED);
+
+    CHECK(DCE2_MapFind(map, first) == nullptr);
+    CHECK(DCE2_MapFind(map, second) == map_data(second));
+    CHECK(DCE2_MapRemove(map, first) == DCE2_RET__ERROR);
+
+    // a duplicate past the deleted slot is still found
+    CHECK(DCE2_MapInsert(map, second, map_data(second)) == DCE2_RET__DUPLICATE);
+
+    // the deleted slot is reused
+    REQUIRE(DCE2_MapInsert(map, first, map_data(first)) == DCE2_RET__SUCCESS);
+    CHECK(map->used == used);
+    CHECK(map->nodes[DCE2_MapHash(map, first)].state == DCE2_MAP_STATE__USED);
+    CHECK(DCE2_MapFind(map, first) == map_data(first));
+    CHECK(DCE2_MapCount(map) == DCE2_MAP_INLINE + 3);
+
+    DCE2_MapDestroy(map);
+}
+
+TEST_CASE("DCE2_Map - churn does not fill the table with deleted slots", "[dce_map]")
+{
+    DCE2_Map* map = DCE2_MapNew(map_data_free);
+    map_frees = 0;
+
+    for (uint32_t key = 0; key < 8; key++)
+        DCE2_MapInsert(map, key, map_data(key));
+
+    const uint32_t size = map->size;
+
+    // files opened and closed over a long session
+    for (uint32_t key = 8; key < 1000; key++)
+    {
+        REQUIRE(DCE2_MapInsert(map, key, map_data(key)) == DCE2_RET__SUCCESS);
+        REQUIRE(DCE2_MapRemove(map, key - 8) == DCE2_RET__SUCCESS);
+        CHECK(map->used * 4 <= map->size * 3);
+    }
+
+    CHECK(DCE2_MapCount(map) == 8);
+    CHECK(map->size <= size * 2);
+    CHECK(map_frees == 992);
+
+    for (uint32_t key = 0; key < 1000; key++)
+        CHECK(DCE2_MapFind(map, key) == ((key < 992) ? nullptr : map_data(key)));
+
+    DCE2_MapDestroy(map);
+}
+
+TEST_CASE("DCE2_Map - remove while iterating", "[dce_map]")
+{
+    DCE2_Map* map = DCE2_MapNew(map_data_free);
+
+    for (uint32_t num : { 3u, 50u })
+    {
+        map_frees = 0;
+
+        for (uint32_t key = 0; key < num; key++)
+            DCE2_MapInsert(map, key, map_data(key));
+
+        CHECK(DCE2_MapIsInline(map) == (num <= DCE2_MAP_INLINE));
+
+        uint64_t seen = 0;
+        unsigned visits = 0;
+
+        for (void* data = DCE2_MapFirst(map); data != nullptr; data = DCE2_MapNext(map))
+        {
+            const uint32_t key = (uint32_t)(uintptr_t)data - 1;
+            CHECK(!(seen & (1ull << key)));
+            seen |= 1ull << key;
+            visits++;
+
+            if (!(key & 1))
+            {
+                DCE2_MapRemoveCurrent(map);
+
+                // a second remove of the same entry does nothing
+                DCE2_MapRemoveCurrent(map);
+            }
+        }
+
+        CHECK(visits == num);
+        CHECK(map_frees == (num + 1) / 2);
+        CHECK(DCE2_MapCount(map) == num / 2);
+
+        for (uint32_t key = 0; key < num; key++)
+            CHECK(DCE2_MapFind(map, key) == ((key & 1) ? map_data(key) : nullptr));
+
+        DCE2_MapEmpty(map);
+        CHECK(map_frees == num);
+        CHECK(DCE2_MapCount(map) == 0);
+        CHECK(DCE2_MapFirst(map) == nullptr);
+    }
+
+    DCE2_MapDestroy(map);
+}
+
+#endif
@@ -0,0 +1,110 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// dce_map.h
+
+/****************************************************************************
+* Provides a map keyed by SMB ids (uid, tid, fid) and a slab allocator for
+* the trackers kept in it.
+*
+* Sessions usually have only a few of each id so the first entries are
+* stored in the map object itself and searched linearly.  Beyond that the
+* entries move to an open addressed table with linear probing, which keeps
+* lookups constant for file servers with hundreds of open files.
+****************************************************************************/
+
+#ifndef DCE_MAP_H
+#define DCE_MAP_H
+
+#include "dce_utils.h"
+
+#include "main/snort_types.h"
+
+#define DCE2_MAP_INLINE 4
+
+typedef void (* DCE2_MapDataFree)(void*);
+
+enum DCE2_MapState : uint8_t
+{
+    DCE2_MAP_STATE__EMPTY = 0,
+    DCE2_MAP_STATE__USED,
+    DCE2_MAP_STATE__DELETED
+};
+
+struct DCE2_MapNode
+{
+    void* data;
+    uint32_t key;
+    DCE2_MapState state;
+};
+
+struct DCE2_Map
+{
+    uint32_t num_nodes;
+    DCE2_MapDataFree data_free;
+
+    // nodes is either inline_nodes or an allocated table
+    DCE2_MapNode* nodes;
+    uint32_t size;       // slots in nodes
+    uint32_t used;       // slots used or deleted in a table
+    uint32_t shift;      // hash to slot of a table
+    int current;         // slot returned by DCE2_MapFirst() / DCE2_MapNext()
+
+    DCE2_MapNode inline_nodes[DCE2_MAP_INLINE];
+};
+
+DCE2_Map* DCE2_MapNew(DCE2_MapDataFree);
+DCE2_Ret DCE2_MapInsert(DCE2_Map*, uint32_t key, void* data);
+void* DCE2_MapFind(DCE2_Map*, uint32_t key);
+DCE2_Ret DCE2_MapFindKey(DCE2_Map*, uint32_t key);
+DCE2_Ret DCE2_MapRemove(DCE2_Map*, uint32_t key);
+void* DCE2_MapFirst(DCE2_Map*);
+void* DCE2_MapNext(DCE2_Map*);
+void DCE2_MapRemoveCurrent(DCE2_Map*);
+void DCE2_MapEmpty(DCE2_Map*);
+void DCE2_MapDestroy(DCE2_Map*);
+
+inline uint32_t DCE2_MapCount(DCE2_Map* map)
+{
+    return map ? map->num_nodes : 0;
+}
+
+/****************************************************************************
+* Objects of one size are carved out of chunks and freed objects are kept
+* on a free list for reuse.  Chunks are only released when the slab is
+* released and no objects are outstanding, so a slab must be used by one
+* thread only.
+****************************************************************************/
+
+struct DCE2_Slab
+{
+    uint32_t obj_size;
+    uint32_t objs_per_chunk;
+    void* free_list;
+    void* chunks;
+    uint32_t num_chunks;
+    uint32_t live;
+    bool released;
+};
+
+void* DCE2_SlabAlloc(DCE2_Slab*);   // zeroed
+void DCE2_SlabFree(DCE2_Slab*, void*);
+void DCE2_SlabRelease(DCE2_Slab*);
+
+#endif
+
@@ -497,6 +497,7 @@ static void dce2_smb_thread_term()
                 dce2_smb_rpkt[i] = nullptr;
             }
         }
+        DCE2_SmbReleaseTrackers();
     }
     if (dce2_inspector_instances == 0)
     {
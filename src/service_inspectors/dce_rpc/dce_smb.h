@@ -27,6 +27,7 @@
 #include "profiler/profiler_defs.h"
 
 #include "dce_co.h"
+#include "dce_map.h"
 #include "smb_common.h"
 #include "smb_message.h"
 
@@ -187,6 +188,10 @@ struct dce2SmbStats
     PegCount smb2_tree_connect;
     PegCount smb2_tree_disconnect;
     PegCount smb2_close;
+    PegCount smb_uid_trackers;
+    PegCount smb_tid_trackers;
+    PegCount smb_file_trackers;
+    PegCount smb_max_file_trackers;
 };
 
 extern THREAD_LOCAL dce2SmbStats dce2_smb_stats;
@@ -417,12 +422,12 @@ struct DCE2_SmbSsnData
 
     int uid;   // A signed integer so it can be set to sentinel
     int tid;   // A signed integer so it can be set to sentinel
-    DCE2_List* uids;
-    DCE2_List* tids;
+    DCE2_Map* uids;
+    DCE2_Map* tids;
 
     // For tracking files and named pipes
     DCE2_SmbFileTracker ftracker;
-    DCE2_List* ftrackers;  // List of DCE2_SmbFileTracker
+    DCE2_Map* ftrackers;  // Map of fid to DCE2_SmbFileTracker
 
     // For tracking requests / responses
     DCE2_SmbRequestTracker rtracker;
@@ -91,18 +91,6 @@ static inline uint32_t Smb2Tid(const Smb2Hdr* hdr)
     return alignedNtohl(&(((Smb2SyncHdr*)hdr)->tree_id));
 }
 
-static int DCE2_Smb2TidCompare(const void* a, const void* b)
-{
-    uint32_t x = (uint32_t)(uintptr_t)a;
-    uint32_t y = (uint32_t)(uintptr_t)b;
-
-    if (x == y)
-        return 0;
-
-    /* Only care about equality for finding */
-    return -1;
-}
-
 static inline void DCE2_Smb2InsertTid(DCE2_SmbSsnData* ssd, const uint32_t tid,
     const uint8_t share_type)
 {
@@ -128,17 +116,10 @@ static inline void DCE2_Smb2InsertTid(DCE2_SmbSsnData* ssd, const uint32_t tid,
     DebugFormat(DEBUG_DCE_SMB, "Inserting Tid: %u\n", tid);
 
     if (ssd->tids == nullptr)
-    {
-        ssd->tids = DCE2_ListNew(DCE2_LIST_TYPE__SPLAYED, DCE2_Smb2TidCompare,
-            nullptr, nullptr, DCE2_LIST_FLAG__NO_DUPS);
-
-        if (ssd->tids == nullptr)
-        {
-            return;
-        }
-    }
+        ssd->tids = DCE2_MapNew(nullptr);
 
-    DCE2_ListInsert(ssd->tids, (void*)(uintptr_t)tid, (void*)(uintptr_t)share_type);
+    if (DCE2_MapInsert(ssd->tids, tid, (void*)(uintptr_t)share_type) == DCE2_RET__SUCCESS)
+        dce2_smb_stats.smb_tid_trackers++;
 }
 
 static DCE2_Ret DCE2_Smb2FindTid(DCE2_SmbSsnData* ssd, const Smb2Hdr* smb_hdr)
@@ -147,12 +128,12 @@ static DCE2_Ret DCE2_Smb2FindTid(DCE2_SmbSsnData* ssd, const Smb2Hdr* smb_hdr)
     if (alignedNtohl(&(smb_hdr->flags)) & SMB2_FLAGS_ASYNC_COMMAND)
         return DCE2_RET__SUCCESS;
 
-    return DCE2_ListFindKey(ssd->tids, (void*)(uintptr_t)Smb2Tid(smb_hdr));
+    return DCE2_MapFindKey(ssd->tids, Smb2Tid(smb_hdr));
 }
 
 static inline void DCE2_Smb2RemoveTid(DCE2_SmbSsnData* ssd, const uint32_t tid)
 {
-    DCE2_ListRemove(ssd->tids, (void*)(uintptr_t)tid);
+    DCE2_MapRemove(ssd->tids, tid);
 }
 
 static inline void DCE2_Smb2StoreRequest(DCE2_SmbSsnData* ssd,
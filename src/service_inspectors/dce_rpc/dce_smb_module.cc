@@ -24,6 +24,9 @@
 
 #include "dce_smb_module.h"
 
+#include <cassert>
+#include <cstddef>
+
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "utils/util.h"
@@ -76,6 +79,10 @@ static const PegInfo dce2_smb_pegs[] =
     { "smbv2_tree_connect", "total number of SMBv2 tree connect packets seen" },
     { "smbv2_tree_disconnect", "total number of SMBv2 tree disconnect packets seen" },
     { "smbv2_close", "total number of SMBv2 close packets seen" },
+    { "uid_trackers", "total smb uids tracked beyond the first in a session" },
+    { "tid_trackers", "total smb tids tracked beyond the first in a session" },
+    { "file_trackers", "total smb file trackers allocated" },
+    { "max_file_trackers", "maximum smb file trackers in one session" },
     { nullptr, nullptr }
 };
 
@@ -202,6 +209,18 @@ PegCount* Dce2SmbModule::get_counts() const
     return (PegCount*)&dce2_smb_stats;
 }
 
+// all pegs are totals except the high water mark which must not be summed
+const CountType* Dce2SmbModule::get_count_types() const
+{
+    static const unsigned num_pegs = sizeof(dce2SmbStats) / sizeof(PegCount);
+    static CountType count_types[num_pegs] = { };
+
+    assert(num_pegs == sizeof(dce2_smb_pegs) / sizeof(dce2_smb_pegs[0]) - 1);
+    count_types[offsetof(dce2SmbStats, smb_max_file_trackers) / sizeof(PegCount)] = CountType::MAX;
+
+    return count_types;
+}
+
 ProfileStats* Dce2SmbModule::get_profile(
     unsigned index, const char*& name, const char*& parent) const
 {
@@ -82,6 +82,7 @@ public:
     const RuleMap* get_rules() const override;
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
+    const CountType* get_count_types() const override;
     ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
     void get_data(dce2SmbProtoConf&);
 
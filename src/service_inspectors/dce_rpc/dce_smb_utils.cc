@@ -87,7 +87,7 @@ bool DCE2_SmbIsTidIPC(DCE2_SmbSsnData* ssd, const uint16_t tid)
     }
     else
     {
-        int check_tid = (int)(uintptr_t)DCE2_ListFind(ssd->tids, (void*)(uintptr_t)tid);
+        int check_tid = (int)(uintptr_t)DCE2_MapFind(ssd->tids, tid);
         if (((check_tid & 0x0000ffff) == (int)tid) && ((check_tid >> 16) == 0))
             return true;
     }
@@ -158,16 +158,45 @@ char* DCE2_SmbGetString(const uint8_t* data,
     return str;
 }
 
-int DCE2_SmbUidTidFidCompare(const void* a, const void* b)
+// Tracker objects come from per thread slabs since sessions allocate and
+// free them as files are opened and closed.
+static THREAD_LOCAL DCE2_Slab ftracker_slab =
+{ sizeof(DCE2_SmbFileTracker), 32, nullptr, nullptr, 0, 0, false };
+
+static THREAD_LOCAL DCE2_Slab rtracker_slab =
+{ sizeof(DCE2_SmbRequestTracker), 16, nullptr, nullptr, 0, 0, false };
+
+static DCE2_SmbFileTracker* DCE2_SmbAllocFileTracker()
 {
-    int x = (int)(uintptr_t)a;
-    int y = (int)(uintptr_t)b;
+    dce2_smb_stats.smb_file_trackers++;
+    return (DCE2_SmbFileTracker*)DCE2_SlabAlloc(&ftracker_slab);
+}
 
-    if (x == y)
-        return 0;
+static void DCE2_SmbFreeFileTracker(DCE2_SmbFileTracker* ftracker)
+{
+    DCE2_SlabFree(&ftracker_slab, ftracker);
+}
+
+// Inserts into the file tracker map, creating it if needed
+static DCE2_Ret DCE2_SmbInsertFileTracker(DCE2_SmbSsnData* ssd,
+    const uint16_t fid, DCE2_SmbFileTracker* ftracker)
+{
+    if (ssd->ftrackers == nullptr)
+        ssd->ftrackers = DCE2_MapNew(DCE2_SmbFileTrackerDataFree);
 
-    /* Only care about equality for finding */
-    return -1;
+    DCE2_Ret status = DCE2_MapInsert(ssd->ftrackers, fid, (void*)ftracker);
+
+    // the session's own file tracker is counted too
+    if (DCE2_MapCount(ssd->ftrackers) + 1 > dce2_smb_stats.smb_max_file_trackers)
+        dce2_smb_stats.smb_max_file_trackers = DCE2_MapCount(ssd->ftrackers) + 1;
+
+    return status;
+}
+
+void DCE2_SmbReleaseTrackers()
+{
+    DCE2_SlabRelease(&ftracker_slab);
+    DCE2_SlabRelease(&rtracker_slab);
 }
 
 DCE2_Ret DCE2_SmbFindUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
@@ -179,7 +208,7 @@ DCE2_Ret DCE2_SmbFindUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
     if ((ssd->uid != DCE2_SENTINEL) && (ssd->uid == (int)uid))
         status = DCE2_RET__SUCCESS;
     else
-        status = DCE2_ListFindKey(ssd->uids, (void*)(uintptr_t)uid);
+        status = DCE2_MapFindKey(ssd->uids, uid);
 
     return status;
 }
@@ -197,17 +226,10 @@ void DCE2_SmbInsertUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
     else
     {
         if (ssd->uids == nullptr)
-        {
-            ssd->uids = DCE2_ListNew(DCE2_LIST_TYPE__SPLAYED, DCE2_SmbUidTidFidCompare,
-                nullptr, nullptr, DCE2_LIST_FLAG__NO_DUPS);
+            ssd->uids = DCE2_MapNew(nullptr);
 
-            if (ssd->uids == nullptr)
-            {
-                return;
-            }
-        }
-
-        DCE2_ListInsert(ssd->uids, (void*)(uintptr_t)uid, (void*)(uintptr_t)uid);
+        if (DCE2_MapInsert(ssd->uids, uid, (void*)(uintptr_t)uid) == DCE2_RET__SUCCESS)
+            dce2_smb_stats.smb_uid_trackers++;
     }
 }
 
@@ -222,7 +244,7 @@ void DCE2_SmbRemoveUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
     if ((ssd->uid != DCE2_SENTINEL) && (ssd->uid == (int)uid))
         ssd->uid = DCE2_SENTINEL;
     else
-        DCE2_ListRemove(ssd->uids, (void*)(uintptr_t)uid);
+        DCE2_MapRemove(ssd->uids, uid);
 
     switch (policy)
     {
@@ -245,9 +267,9 @@ void DCE2_SmbRemoveUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
         {
             DCE2_SmbFileTracker* ftracker;
 
-            for (ftracker = (DCE2_SmbFileTracker*)DCE2_ListFirst(ssd->ftrackers);
+            for (ftracker = (DCE2_SmbFileTracker*)DCE2_MapFirst(ssd->ftrackers);
                 ftracker != nullptr;
-                ftracker = (DCE2_SmbFileTracker*)DCE2_ListNext(ssd->ftrackers))
+                ftracker = (DCE2_SmbFileTracker*)DCE2_MapNext(ssd->ftrackers))
             {
                 if (ftracker->uid_v1 == uid)
                 {
@@ -257,7 +279,7 @@ void DCE2_SmbRemoveUid(DCE2_SmbSsnData* ssd, const uint16_t uid)
                     if (ssd->fb_ftracker == ftracker)
                         DCE2_SmbFinishFileBlockVerdict(ssd);
 
-                    DCE2_ListRemoveCurrent(ssd->ftrackers);
+                    DCE2_MapRemoveCurrent(ssd->ftrackers);
                     DCE2_SmbRemoveFileTrackerFromRequestTrackers(ssd, ftracker);
                 }
             }
@@ -332,15 +354,11 @@ DCE2_SmbRequestTracker* DCE2_SmbNewRequestTracker(DCE2_SmbSsnData* ssd,
             }
         }
 
-        rtracker = (DCE2_SmbRequestTracker*)snort_calloc(sizeof(DCE2_SmbRequestTracker));
-        if (rtracker == nullptr)
-        {
-            return nullptr;
-        }
+        rtracker = (DCE2_SmbRequestTracker*)DCE2_SlabAlloc(&rtracker_slab);
 
         if (DCE2_QueueEnqueue(ssd->rtrackers, (void*)rtracker) != DCE2_RET__SUCCESS)
         {
-            snort_free((void*)rtracker);
+            DCE2_SlabFree(&rtracker_slab, rtracker);
             return nullptr;
         }
     }
@@ -395,36 +413,17 @@ DCE2_SmbFileTracker* DCE2_SmbNewFileTracker(DCE2_SmbSsnData* ssd,
     }
     else
     {
-        ftracker = (DCE2_SmbFileTracker*)snort_calloc(sizeof(DCE2_SmbFileTracker));
-
-        if (ftracker == nullptr)
-        {
-            return nullptr;
-        }
+        ftracker = DCE2_SmbAllocFileTracker();
 
         if (DCE2_SmbInitFileTracker(ssd, ftracker, is_ipc, uid, tid, (int)fid) !=
             DCE2_RET__SUCCESS)
         {
             DCE2_SmbCleanFileTracker(ftracker);
-            snort_free((void*)ftracker);
+            DCE2_SmbFreeFileTracker(ftracker);
             return nullptr;
         }
 
-        if (ssd->ftrackers == nullptr)
-        {
-            ssd->ftrackers = DCE2_ListNew(DCE2_LIST_TYPE__SPLAYED,
-                DCE2_SmbUidTidFidCompare, DCE2_SmbFileTrackerDataFree, nullptr,
-                DCE2_LIST_FLAG__NO_DUPS);
-
-            if (ssd->ftrackers == nullptr)
-            {
-                DCE2_SmbCleanSessionFileTracker(ssd, ftracker);
-                return nullptr;
-            }
-        }
-
-        if (DCE2_ListInsert(ssd->ftrackers, (void*)(uintptr_t)fid,
-            (void*)ftracker) != DCE2_RET__SUCCESS)
+        if (DCE2_SmbInsertFileTracker(ssd, fid, ftracker) != DCE2_RET__SUCCESS)
         {
             DCE2_SmbCleanSessionFileTracker(ssd, ftracker);
             return nullptr;
@@ -493,8 +492,7 @@ DCE2_SmbFileTracker* DCE2_SmbFindFileTracker(DCE2_SmbSsnData* ssd,
     }
     else
     {
-        ftracker = (DCE2_SmbFileTracker*)
-            DCE2_ListFind(ssd->ftrackers, (void*)(uintptr_t)fid);
+        ftracker = (DCE2_SmbFileTracker*)DCE2_MapFind(ssd->ftrackers, fid);
     }
 
     if (ftracker == nullptr)
@@ -611,7 +609,7 @@ void DCE2_SmbRemoveFileTracker(DCE2_SmbSsnData* ssd, DCE2_SmbFileTracker* ftrack
     if (ftracker == &ssd->ftracker)
         DCE2_SmbCleanFileTracker(&ssd->ftracker);
     else if (ssd->ftrackers != nullptr)
-        DCE2_ListRemove(ssd->ftrackers, (void*)(uintptr_t)ftracker->fid_v1);
+        DCE2_MapRemove(ssd->ftrackers, (uint32_t)ftracker->fid_v1);
 
     DCE2_SmbRemoveFileTrackerFromRequestTrackers(ssd, ftracker);
 }
@@ -678,7 +676,7 @@ void DCE2_SmbFileTrackerDataFree(void* data)
         ftracker->uid_v1, ftracker->tid_v1, ftracker->fid_v1);
 
     DCE2_SmbCleanFileTracker(ftracker);
-    snort_free((void*)ftracker);
+    DCE2_SmbFreeFileTracker(ftracker);
 }
 
 /********************************************************************
@@ -689,7 +687,7 @@ void DCE2_SmbFileTrackerDataFree(void* data)
 void DCE2_SmbCleanSessionFileTracker(DCE2_SmbSsnData* ssd, DCE2_SmbFileTracker* ftracker)
 {
     DCE2_SmbCleanFileTracker(ftracker);
-    snort_free((void*)ftracker);
+    DCE2_SmbFreeFileTracker(ftracker);
     if (ssd->fapi_ftracker == ftracker)
         ssd->fapi_ftracker = nullptr;
 }
@@ -822,28 +820,14 @@ DCE2_SmbFileTracker* DCE2_SmbDequeueTmpFileTracker(DCE2_SmbSsnData* ssd,
     if (ssd->ftracker.fid_v1 == DCE2_SENTINEL)
     {
         memcpy(&ssd->ftracker, ftracker, sizeof(DCE2_SmbFileTracker));
-        snort_free((void*)ftracker);
+        DCE2_SmbFreeFileTracker(ftracker);
         if (ssd->fapi_ftracker == ftracker)
             ssd->fapi_ftracker = &ssd->ftracker;
         ftracker = &ssd->ftracker;
     }
     else
     {
-        if (ssd->ftrackers == nullptr)
-        {
-            ssd->ftrackers = DCE2_ListNew(DCE2_LIST_TYPE__SPLAYED,
-                DCE2_SmbUidTidFidCompare, DCE2_SmbFileTrackerDataFree, nullptr,
-                DCE2_LIST_FLAG__NO_DUPS);
-
-            if (ssd->ftrackers == nullptr)
-            {
-                DCE2_SmbCleanSessionFileTracker(ssd, ftracker);
-                return nullptr;
-            }
-        }
-
-        if (DCE2_ListInsert(ssd->ftrackers, (void*)(uintptr_t)fid,
-            (void*)ftracker) != DCE2_RET__SUCCESS)
+        if (DCE2_SmbInsertFileTracker(ssd, fid, ftracker) != DCE2_RET__SUCCESS)
         {
             DCE2_SmbCleanSessionFileTracker(ssd, ftracker);
             return nullptr;
@@ -868,7 +852,7 @@ void DCE2_SmbRequestTrackerDataFree(void* data)
         rtracker->uid, rtracker->tid, rtracker->pid, rtracker->mid);
 
     DCE2_SmbCleanRequestTracker(rtracker);
-    snort_free((void*)rtracker);
+    DCE2_SlabFree(&rtracker_slab, rtracker);
 }
 
 DCE2_Ret DCE2_SmbFindTid(DCE2_SmbSsnData* ssd, const uint16_t tid)
@@ -880,7 +864,7 @@ DCE2_Ret DCE2_SmbFindTid(DCE2_SmbSsnData* ssd, const uint16_t tid)
     if ((ssd->tid != DCE2_SENTINEL) && ((ssd->tid & 0x0000ffff) == (int)tid))
         status = DCE2_RET__SUCCESS;
     else
-        status = DCE2_ListFindKey(ssd->tids, (void*)(uintptr_t)tid);
+        status = DCE2_MapFindKey(ssd->tids, tid);
 
     return status;
 }
@@ -894,7 +878,7 @@ void DCE2_SmbRemoveTid(DCE2_SmbSsnData* ssd, const uint16_t tid)
     if ((ssd->tid != DCE2_SENTINEL) && ((ssd->tid & 0x0000ffff) == (int)tid))
         ssd->tid = DCE2_SENTINEL;
     else
-        DCE2_ListRemove(ssd->tids, (void*)(uintptr_t)tid);
+        DCE2_MapRemove(ssd->tids, tid);
 
     // Removing Tid invalidates files created with it
     if ((ssd->ftracker.fid_v1 != DCE2_SENTINEL)
@@ -907,9 +891,9 @@ void DCE2_SmbRemoveTid(DCE2_SmbSsnData* ssd, const uint16_t tid)
     {
         DCE2_SmbFileTracker* ftracker;
 
-        for (ftracker = (DCE2_SmbFileTracker*)DCE2_ListFirst(ssd->ftrackers);
+        for (ftracker = (DCE2_SmbFileTracker*)DCE2_MapFirst(ssd->ftrackers);
             ftracker != nullptr;
-            ftracker = (DCE2_SmbFileTracker*)DCE2_ListNext(ssd->ftrackers))
+            ftracker = (DCE2_SmbFileTracker*)DCE2_MapNext(ssd->ftrackers))
         {
             if (ftracker->tid_v1 == (int)tid)
             {
@@ -919,7 +903,7 @@ void DCE2_SmbRemoveTid(DCE2_SmbSsnData* ssd, const uint16_t tid)
                 if (ssd->fb_ftracker == ftracker)
                     DCE2_SmbFinishFileBlockVerdict(ssd);
 
-                DCE2_ListRemoveCurrent(ssd->ftrackers);
+                DCE2_MapRemoveCurrent(ssd->ftrackers);
                 DCE2_SmbRemoveFileTrackerFromRequestTrackers(ssd, ftracker);
             }
         }
@@ -962,17 +946,10 @@ void DCE2_SmbInsertTid(DCE2_SmbSsnData* ssd,
     else
     {
         if (ssd->tids == nullptr)
-        {
-            ssd->tids = DCE2_ListNew(DCE2_LIST_TYPE__SPLAYED, DCE2_SmbUidTidFidCompare,
-                nullptr, nullptr, DCE2_LIST_FLAG__NO_DUPS);
+            ssd->tids = DCE2_MapNew(nullptr);
 
-            if (ssd->tids == nullptr)
-            {
-                return;
-            }
-        }
-
-        DCE2_ListInsert(ssd->tids, (void*)(uintptr_t)tid, (void*)(uintptr_t)insert_tid);
+        if (DCE2_MapInsert(ssd->tids, tid, (void*)(uintptr_t)insert_tid) == DCE2_RET__SUCCESS)
+            dce2_smb_stats.smb_tid_trackers++;
     }
 }
 
@@ -1051,20 +1028,14 @@ void DCE2_SmbQueueTmpFileTracker(DCE2_SmbSsnData* ssd,
     DebugFormat(DEBUG_DCE_SMB, "Queuing file tracker "
         "with Uid: %hu, Tid: %hu\n", uid, tid);
 
-    DCE2_SmbFileTracker* ftracker = (DCE2_SmbFileTracker*)
-        snort_calloc(sizeof(DCE2_SmbFileTracker));
-
-    if (ftracker == nullptr)
-    {
-        return;
-    }
+    DCE2_SmbFileTracker* ftracker = DCE2_SmbAllocFileTracker();
 
     bool is_ipc = DCE2_SmbIsTidIPC(ssd, tid);
     if (DCE2_SmbInitFileTracker(ssd, ftracker, is_ipc, uid, tid, DCE2_SENTINEL) !=
         DCE2_RET__SUCCESS)
     {
         DCE2_SmbCleanFileTracker(ftracker);
-        snort_free((void*)ftracker);
+        DCE2_SmbFreeFileTracker(ftracker);
         return;
     }
 
@@ -2035,9 +2006,9 @@ static void DCE2_SmbSetNewFileAPIFileTracker(DCE2_SmbSsnData* ssd)
         }
 
         if (ftracker == &ssd->ftracker)
-            ftracker = (DCE2_SmbFileTracker*)DCE2_ListFirst(ssd->ftrackers);
+            ftracker = (DCE2_SmbFileTracker*)DCE2_MapFirst(ssd->ftrackers);
         else
-            ftracker = (DCE2_SmbFileTracker*)DCE2_ListNext(ssd->ftrackers);
+            ftracker = (DCE2_SmbFileTracker*)DCE2_MapNext(ssd->ftrackers);
     }
     ssd->fapi_ftracker = ftracker;
 }
@@ -126,7 +126,6 @@ inline bool DCE2_ComInfoCanProcessCommand(const DCE2_SmbComInfo* com_info)
  ********************************************************************/
 bool DCE2_SmbIsTidIPC(DCE2_SmbSsnData*, const uint16_t);
 char* DCE2_SmbGetString(const uint8_t*, uint32_t, bool, bool);
-int DCE2_SmbUidTidFidCompare(const void*, const void*);
 DCE2_Ret DCE2_SmbFindUid(DCE2_SmbSsnData*, const uint16_t);
 void DCE2_SmbInsertUid(DCE2_SmbSsnData*, const uint16_t);
 void DCE2_SmbRemoveUid(DCE2_SmbSsnData*, const uint16_t);
@@ -158,6 +157,7 @@ DCE2_Ret DCE2_SmbInitFileTracker(DCE2_SmbSsnData*,
     DCE2_SmbFileTracker*, const bool, const uint16_t,
     const uint16_t, const int);
 void DCE2_SmbRequestTrackerDataFree(void*);
+void DCE2_SmbReleaseTrackers();
 DCE2_SmbFileTracker* DCE2_SmbFindFileTracker(DCE2_SmbSsnData*,
     const uint16_t, const uint16_t, const uint16_t);
 DCE2_Ret DCE2_SmbProcessRequestData(DCE2_SmbSsnData*, const uint16_t,
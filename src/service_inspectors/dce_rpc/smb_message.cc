@@ -1267,20 +1267,20 @@ static void DCE2_SmbDataFree(DCE2_SmbSsnData* ssd)
 
     if (ssd->uids != nullptr)
     {
-        DCE2_ListDestroy(ssd->uids);
+        DCE2_MapDestroy(ssd->uids);
         ssd->uids = nullptr;
     }
 
     if (ssd->tids != nullptr)
     {
-        DCE2_ListDestroy(ssd->tids);
+        DCE2_MapDestroy(ssd->tids);
         ssd->tids = nullptr;
     }
 
     DCE2_SmbCleanFileTracker(&ssd->ftracker);
     if (ssd->ftrackers != nullptr)
     {
-        DCE2_ListDestroy(ssd->ftrackers);
+        DCE2_MapDestroy(ssd->ftrackers);
         ssd->ftrackers = nullptr;
     }
 
@@ -24,10 +24,29 @@
 #include "http_api.h"
 
 #include "http_inspect.h"
+#include "http_msg_head_shared.h"
+#include "http_msg_request.h"
+#include "http_str_to_code.h"
 
 const char* HttpApi::http_my_name = HTTP_NAME;
 const char* HttpApi::http_help = "the new HTTP inspector!";
 
+void HttpApi::http_init()
+{
+    HttpFlowData::init();
+
+    str_to_code_index(HttpMsgRequest::method_list);
+    str_to_code_index(HttpMsgHeadShared::header_list);
+    str_to_code_index(HttpMsgHeadShared::trans_code_list);
+    str_to_code_index(HttpMsgHeadShared::content_code_list);
+    str_to_code_index(HttpMsgHeadShared::charset_code_list);
+}
+
+void HttpApi::http_term()
+{
+    str_to_code_clear();
+}
+
 Inspector* HttpApi::http_ctor(Module* mod)
 {
     HttpModule* const http_mod = (HttpModule*)mod;
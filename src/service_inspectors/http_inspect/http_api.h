@@ -23,6 +23,7 @@
 #include "framework/inspector.h"
 #include "framework/module.h"
 
+#include "http_arena.h"
 #include "http_flow_data.h"
 #include "http_module.h"
 
@@ -38,12 +39,12 @@ private:
     static void http_mod_dtor(Module* m) { delete m; }
     static const char* http_my_name;
     static const char* http_help;
-    static void http_init() { HttpFlowData::init(); }
-    static void http_term() { }
+    static void http_init();
+    static void http_term();
     static Inspector* http_ctor(Module* mod);
     static void http_dtor(Inspector* p) { delete p; }
-    static void http_tinit() { }
-    static void http_tterm() { }
+    static void http_tinit() { HttpArena::tinit(); }
+    static void http_tterm() { HttpArena::tterm(); }
 };
 
 #endif
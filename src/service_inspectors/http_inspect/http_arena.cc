@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_arena.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "http_arena.h"
+
+#include "http_enum.h"
+#include "http_module.h"
+
+using namespace HttpEnums;
+
+THREAD_LOCAL HttpArena::Chunk* HttpArena::free_chunks = nullptr;
+THREAD_LOCAL uint32_t HttpArena::num_free_chunks = 0;
+THREAD_LOCAL uint8_t* HttpArena::free_buffers[MAX_FREE_BUFFERS];
+THREAD_LOCAL uint32_t HttpArena::num_free_buffers = 0;
+THREAD_LOCAL HttpArena::ObjectList HttpArena::free_objects[MAX_OBJECT_SIZES];
+THREAD_LOCAL bool HttpArena::closed = false;
+
+static const uint32_t ALIGN = alignof(std::max_align_t);
+
+static inline uint32_t round_up(uint32_t size)
+{
+    return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+HttpArena::Chunk* HttpArena::new_chunk(uint32_t size)
+{
+    const uint32_t HEADER_SIZE = round_up(sizeof(Chunk));
+    Chunk* chunk;
+
+    // Standard size chunks come from the cache. Oversize requests get a chunk of their own that
+    // is freed when the arena is reset.
+    if ((size <= CHUNK_SIZE - HEADER_SIZE) && (free_chunks != nullptr))
+    {
+        chunk = free_chunks;
+        free_chunks = chunk->next;
+        num_free_chunks--;
+    }
+    else
+    {
+        const uint32_t chunk_size = (size <= CHUNK_SIZE - HEADER_SIZE) ? CHUNK_SIZE :
+            HEADER_SIZE + size;
+        chunk = reinterpret_cast<Chunk*>(new uint8_t[chunk_size]);
+        chunk->size = chunk_size;
+        HttpModule::increment_peg_counts(PEG_ARENA_CHUNKS);
+    }
+    chunk->offset = HEADER_SIZE;
+    chunk->next = chunks;
+    chunks = chunk;
+    return chunk;
+}
+
+void* HttpArena::alloc(uint32_t size)
+{
+    size = round_up(size);
+    Chunk* chunk = chunks;
+
+    if ((chunk == nullptr) || (chunk->offset + size > chunk->size))
+        chunk = new_chunk(size);
+
+    void* const mem = reinterpret_cast<uint8_t*>(chunk) + chunk->offset;
+    chunk->offset += size;
+    used += size;
+    return mem;
+}
+
+void HttpArena::add_cleanup(void (*destroy_)(void*, uint32_t), void* obj, uint32_t num)
+{
+    Cleanup* const cleanup = static_cast<Cleanup*>(alloc(sizeof(Cleanup)));
+    cleanup->destroy = destroy_;
+    cleanup->obj = obj;
+    cleanup->num = num;
+    cleanup->next = cleanups;
+    cleanups = cleanup;
+}
+
+void HttpArena::reset()
+{
+    // Destructors run newest first and may not allocate from the arena being reset
+    for (Cleanup* cleanup = cleanups; cleanup != nullptr; cleanup = cleanup->next)
+        cleanup->destroy(cleanup->obj, cleanup->num);
+    cleanups = nullptr;
+
+    while (chunks != nullptr)
+    {
+        Chunk* const chunk = chunks;
+        chunks = chunk->next;
+
+        if ((chunk->size == CHUNK_SIZE) && (num_free_chunks < MAX_FREE_CHUNKS) && !closed)
+        {
+            chunk->next = free_chunks;
+            free_chunks = chunk;
+            num_free_chunks++;
+        }
+        else
+            delete[] reinterpret_cast<uint8_t*>(chunk);
+    }
+
+    HttpModule::update_peg_max(PEG_ARENA_MAX, used);
+    used = 0;
+}
+
+uint8_t* HttpArena::get_body_buffer()
+{
+    if (num_free_buffers > 0)
+    {
+        HttpModule::increment_peg_counts(PEG_BUFFER_REUSE);
+        return free_buffers[--num_free_buffers];
+    }
+    return new uint8_t[MAX_OCTETS];
+}
+
+void HttpArena::put_body_buffer(uint8_t* buffer)
+{
+    if ((num_free_buffers < MAX_FREE_BUFFERS) && !closed)
+        free_buffers[num_free_buffers++] = buffer;
+    else
+        delete[] buffer;
+}
+
+void* HttpArena::get_object(size_t size)
+{
+    for (uint32_t k=0; (k < MAX_OBJECT_SIZES) && (free_objects[k].size != 0); k++)
+    {
+        ObjectList& list = free_objects[k];
+        if ((list.size == size) && (list.head != nullptr))
+        {
+            void* const obj = list.head;
+            list.head = *static_cast<void**>(obj);
+            list.count--;
+            HttpModule::increment_peg_counts(PEG_SECTION_REUSE);
+            return obj;
+        }
+    }
+    return ::operator new(size);
+}
+
+void HttpArena::put_object(void* obj, size_t size)
+{
+    for (uint32_t k=0; (k < MAX_OBJECT_SIZES) && !closed; k++)
+    {
+        ObjectList& list = free_objects[k];
+        if (list.size == 0)
+            list.size = size;
+        if (list.size == size)
+        {
+            if (list.count >= MAX_FREE_OBJECTS)
+                break;
+            *static_cast<void**>(obj) = list.head;
+            list.head = obj;
+            list.count++;
+            return;
+        }
+    }
+    ::operator delete(obj);
+}
+
+void HttpArena::tterm()
+{
+    for (uint32_t k=0; k < MAX_OBJECT_SIZES; k++)
+    {
+        ObjectList& list = free_objects[k];
+        while (list.head != nullptr)
+        {
+            void* const obj = list.head;
+            list.head = *static_cast<void**>(obj);
+            ::operator delete(obj);
+        }
+        list.count = 0;
+    }
+
+    while (free_chunks != nullptr)
+    {
+        Chunk* const chunk = free_chunks;
+        free_chunks = chunk->next;
+        delete[] reinterpret_cast<uint8_t*>(chunk);
+    }
+    num_free_chunks = 0;
+
+    while (num_free_buffers > 0)
+        delete[] free_buffers[--num_free_buffers];
+
+    closed = true;
+}
+
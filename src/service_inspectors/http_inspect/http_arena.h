@@ -0,0 +1,141 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_arena.h
+
+#ifndef HTTP_ARENA_H
+#define HTTP_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "main/thread.h"
+
+//-------------------------------------------------------------------------
+// HttpArena class
+// Bump allocator owned by a message section. Everything the section allocates while it is
+// analyzed and inspected comes from here and is released at once when the section is deleted.
+// Chunks are recycled through a per-thread cache so steady state traffic does not touch the heap.
+// Objects with destructors are destroyed in reverse order of creation when the arena is reset.
+//-------------------------------------------------------------------------
+
+class HttpArena
+{
+public:
+    HttpArena() = default;
+    ~HttpArena() { reset(); }
+
+    // Uninitialized memory suitably aligned for any type
+    void* alloc(uint32_t size);
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        T* const obj = new(alloc(sizeof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value)
+            add_cleanup(&destroy<T>, obj, 1);
+        return obj;
+    }
+
+    template<typename T>
+    T* make_array(uint32_t num)
+    {
+        T* const array = static_cast<T*>(alloc(num * sizeof(T)));
+        for (uint32_t k=0; k < num; k++)
+            new(array + k) T;
+        if (!std::is_trivially_destructible<T>::value)
+            add_cleanup(&destroy<T>, array, num);
+        return array;
+    }
+
+    void reset();
+    uint32_t get_used() const { return used; }
+
+    // MAX_OCTETS buffers for reassembling message bodies. Buffers are allocated with new[] so a
+    // buffer that is never given back may simply be deleted.
+    static uint8_t* get_body_buffer();
+    static void put_body_buffer(uint8_t* buffer);
+
+    // Memory for message section objects. Freed objects are kept in per-thread lists by size
+    // since a handful of section classes account for all of them.
+    static void* get_object(size_t size);
+    static void put_object(void* obj, size_t size);
+
+    // Free the calling thread's caches. Anything given back afterward is freed directly until
+    // tinit() is called again.
+    static void tinit() { closed = false; }
+    static void tterm();
+
+    static const uint32_t CHUNK_SIZE = 8192;
+    static const uint32_t MAX_FREE_CHUNKS = 64;
+    static const uint32_t MAX_FREE_BUFFERS = 8;
+    static const uint32_t MAX_OBJECT_SIZES = 8;
+    static const uint32_t MAX_FREE_OBJECTS = 16;
+
+private:
+    HttpArena(const HttpArena&) = delete;
+    HttpArena& operator=(const HttpArena&) = delete;
+
+    struct Chunk
+    {
+        Chunk* next;
+        uint32_t size;
+        uint32_t offset;
+    };
+
+    struct Cleanup
+    {
+        void (*destroy)(void*, uint32_t);
+        void* obj;
+        uint32_t num;
+        Cleanup* next;
+    };
+
+    struct ObjectList
+    {
+        size_t size;
+        uint32_t count;
+        void* head;
+    };
+
+    template<typename T>
+    static void destroy(void* obj, uint32_t num)
+    {
+        for (uint32_t k=0; k < num; k++)
+            (static_cast<T*>(obj) + k)->~T();
+    }
+
+    void add_cleanup(void (*destroy)(void*, uint32_t), void* obj, uint32_t num);
+    Chunk* new_chunk(uint32_t size);
+
+    Chunk* chunks = nullptr;
+    Cleanup* cleanups = nullptr;
+    uint32_t used = 0;
+
+    static THREAD_LOCAL Chunk* free_chunks;
+    static THREAD_LOCAL uint32_t num_free_chunks;
+    static THREAD_LOCAL uint8_t* free_buffers[MAX_FREE_BUFFERS];
+    static THREAD_LOCAL uint32_t num_free_buffers;
+    static THREAD_LOCAL ObjectList free_objects[MAX_OBJECT_SIZES];
+    static THREAD_LOCAL bool closed;
+};
+
+#endif
+
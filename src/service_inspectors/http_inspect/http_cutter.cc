@@ -23,6 +23,8 @@
 
 #include "http_cutter.h"
 
+#include "http_scan.h"
+
 using namespace HttpEnums;
 
 ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
@@ -98,6 +100,11 @@ ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
         {
             num_crlf = 1;
         }
+        else if (validated)
+        {
+            // Nothing more happens until the next CR or LF so skip ahead to just before it
+            k += HttpScan::find_cr_lf(buffer + k + 1, length - k - 1);
+        }
     }
     octets_seen += length;
     return SCAN_NOTFOUND;
@@ -181,6 +188,9 @@ ScanResult HttpHeaderCutter::cut(const uint8_t* buffer, uint32_t length,
         {
             num_crlf = 0;
             first_lf = 0;
+
+            // Other octets just reset the state so skip ahead to just before the next CR or LF
+            k += HttpScan::find_cr_lf(buffer + k + 1, length - k - 1);
         }
     }
     octets_seen += length;
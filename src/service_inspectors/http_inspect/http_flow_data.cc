@@ -24,7 +24,9 @@
 #include "http_flow_data.h"
 
 #include "decompress/file_decomp.h"
+#include "decompress/inflate_pool.h"
 
+#include "http_module.h"
 #include "http_test_manager.h"
 #include "http_transaction.h"
 
@@ -63,13 +65,9 @@ HttpFlowData::~HttpFlowData()
     for (int k=0; k <= 1; k++)
     {
         delete[] section_buffer[k];
-        HttpTransaction::delete_transaction(transaction[k]);
+        HttpTransaction::delete_transaction(transaction[k], this);
         delete cutter[k];
-        if (compress_stream[k] != nullptr)
-        {
-            inflateEnd(compress_stream[k]);
-            delete compress_stream[k];
-        }
+        InflatePool::put(compress_stream[k]);
         if (mime_state[k] != nullptr)
         {
             delete mime_state[k];
@@ -80,6 +78,43 @@ HttpFlowData::~HttpFlowData()
     if (fd_state != nullptr)
         File_Decomp_StopFree(fd_state);
     delete_pipeline();
+    for (int k=0; k < num_spare_trans; k++)
+        delete spare_trans[k];
+}
+
+bool HttpFlowData::needs_inspection()
+{
+    // The flow is only trusted in the middle of a message body that has used up its depths.
+    // Between messages and while a start line, headers, or trailers are being parsed the next
+    // thing to arrive may need inspection so the flow stays untrusted.
+    bool in_body = false;
+    bool between = false;
+    for (int k=0; k <= 1; k++)
+    {
+        if ((detect_depth_remaining[k] > 0) || (file_depth_remaining[k] > 0))
+            return true;
+
+        switch (type_expected[k])
+        {
+        case SEC_BODY_CL:
+        case SEC_BODY_CHUNK:
+        case SEC_BODY_OLD:
+            in_body = true;
+            break;
+        case SEC_ABORT:
+            break;
+        case SEC_REQUEST:
+        case SEC_STATUS:
+            // A cutter is present once the next start line has begun to arrive
+            if (cutter[k] != nullptr)
+                return true;
+            between = true;
+            break;
+        default:
+            return true;
+        }
+    }
+    return between && !in_body;
 }
 
 void HttpFlowData::half_reset(SourceId source_id)
@@ -94,12 +129,8 @@ void HttpFlowData::half_reset(SourceId source_id)
     file_depth_remaining[source_id] = STAT_NOT_PRESENT;
     detect_depth_remaining[source_id] = STAT_NOT_PRESENT;
     compression[source_id] = CMP_NONE;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    InflatePool::put(compress_stream[source_id]);
+    compress_stream[source_id] = nullptr;
     if (mime_state[source_id] != nullptr)
     {
         delete mime_state[source_id];
@@ -137,12 +168,8 @@ void HttpFlowData::trailer_prep(SourceId source_id)
 {
     type_expected[source_id] = SEC_TRAILER;
     compression[source_id] = CMP_NONE;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    InflatePool::put(compress_stream[source_id]);
+    compress_stream[source_id] = nullptr;
     infractions[source_id].reset();
     events[source_id].reset();
 }
@@ -162,6 +189,8 @@ bool HttpFlowData::add_to_pipeline(HttpTransaction* latest)
     }
     pipeline[pipeline_back] = latest;
     pipeline_back = new_back;
+    HttpModule::update_peg_max(PEG_PIPELINE_MAX,
+        (pipeline_back - pipeline_front + MAX_PIPELINE) % MAX_PIPELINE);
     return true;
 }
 
@@ -181,7 +210,7 @@ void HttpFlowData::delete_pipeline()
 {
     for (int k=pipeline_front; k != pipeline_back; k = (k+1) % MAX_PIPELINE)
     {
-        HttpTransaction::delete_transaction(pipeline[k]);
+        HttpTransaction::delete_transaction(pipeline[k], this);
     }
     delete[] pipeline;
 }
@@ -44,6 +44,10 @@ public:
     static unsigned http_flow_id;
     static void init() { http_flow_id = FlowData::get_flow_id(); }
 
+    // False only within a message body whose detection and file processing depths are used up,
+    // or once both directions have been aborted
+    bool needs_inspection() override;
+
     friend class HttpInspect;
     friend class HttpMsgSection;
     friend class HttpMsgStart;
@@ -139,6 +143,11 @@ private:
     bool pipeline_overflow = false;
     bool pipeline_underflow = false;
 
+    // Completed transactions kept for reuse by the next request
+    static const int MAX_SPARE_TRANS = 2;
+    HttpTransaction* spare_trans[MAX_SPARE_TRANS];
+    int num_spare_trans = 0;
+
     bool add_to_pipeline(HttpTransaction* latest);
     HttpTransaction* take_from_pipeline();
     void delete_pipeline();
@@ -240,7 +240,7 @@ void HttpInspect::clear(HttpFlowData* session_data, SourceId source_id)
     if ((source_id == SRC_SERVER) && (session_data->type_expected[SRC_SERVER] == SEC_STATUS) &&
          session_data->transaction[SRC_SERVER]->final_response())
     {
-        HttpTransaction::delete_transaction(session_data->transaction[SRC_SERVER]);
+        HttpTransaction::delete_transaction(session_data->transaction[SRC_SERVER], session_data);
         session_data->transaction[SRC_SERVER] = nullptr;
     }
     else
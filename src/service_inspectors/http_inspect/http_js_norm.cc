@@ -141,8 +141,8 @@ void HttpJsNorm::normalize(const Field& input, Field& output, HttpInfractions& i
                 continue;
 
             // FIXIT-L need to fix this library so we don't have to cast away const here.
-            JSNormalizeDecode((char*)js_start, (uint16_t)(end-js_start), (char*)buffer+index,
-                (uint16_t)(input.length() - index), (char**)&ptr, &bytes_copied, &js,
+            JSNormalizeDecode((char*)js_start, end-js_start, (char*)buffer+index,
+                input.length() - index, (char**)&ptr, &bytes_copied, &js,
                 uri_param.iis_unicode ? uri_param.unicode_map : nullptr);
             index += bytes_copied;
         }
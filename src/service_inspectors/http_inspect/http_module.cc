@@ -88,6 +88,16 @@ const Parameter HttpModule::http_params[] =
 
 THREAD_LOCAL PegCount HttpModule::peg_counts[PEG_COUNT_MAX] = { 0 };
 
+// high water marks kept with update_peg_max() must not be summed
+const CountType* HttpModule::get_count_types() const
+{
+    static CountType count_types[PEG_COUNT_MAX] = { };
+    count_types[PEG_ARENA_MAX] = CountType::MAX;
+    count_types[PEG_PIPELINE_MAX] = CountType::MAX;
+    count_types[PEG_INFLATE_MAX] = CountType::MAX;
+    return count_types;
+}
+
 bool HttpModule::begin(const char*, int, SnortConfig*)
 {
     delete params;
@@ -103,8 +103,11 @@ public:
 
     const PegInfo* get_pegs() const override { return peg_names; }
     PegCount* get_counts() const override { return peg_counts; }
+    const CountType* get_count_types() const override;
     static void increment_peg_counts(HttpEnums::PEG_COUNT counter)
         { peg_counts[counter]++; return; }
+    static void update_peg_max(HttpEnums::PEG_COUNT counter, PegCount value)
+        { if (value > peg_counts[counter]) peg_counts[counter] = value; }
 
 #ifdef REG_TEST
     static const PegInfo* get_peg_names() { return peg_names; }
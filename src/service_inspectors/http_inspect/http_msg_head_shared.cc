@@ -25,21 +25,6 @@
 
 using namespace HttpEnums;
 
-HttpMsgHeadShared::~HttpMsgHeadShared()
-{
-    delete[] header_line;
-    delete[] header_name;
-    delete[] header_name_id;
-    delete[] header_value;
-    NormalizedHeader* list_ptr = norm_heads;
-    while (list_ptr != nullptr)
-    {
-        NormalizedHeader* temp_ptr = list_ptr;
-        list_ptr = list_ptr->next;
-        delete temp_ptr;
-    }
-}
-
 // All the header processing that is done for every message (i.e. not just-in-time) is done here.
 void HttpMsgHeadShared::analyze()
 {
@@ -69,7 +54,7 @@ void HttpMsgHeadShared::create_norm_head_list()
             {
                 headers_present[header_name_id[j]] = true;
                 NormalizedHeader* tmp_ptr = norm_heads;
-                norm_heads = new NormalizedHeader(header_name_id[j]);
+                norm_heads = arena.make<NormalizedHeader>(header_name_id[j]);
                 norm_heads->next = tmp_ptr;
                 norm_heads->count = 1;
             }
@@ -85,7 +70,7 @@ void HttpMsgHeadShared::parse_header_block()
     int num_seps;
     // session_data->num_head_lines is computed without consideration of wrapping and may overstate
     // actual number of headers. Rely on num_headers which is calculated correctly.
-    header_line = new Field[session_data->num_head_lines[source_id]];
+    header_line = arena.make_array<Field>(session_data->num_head_lines[source_id]);
     while (bytes_used < msg_text.length())
     {
         assert(num_headers < session_data->num_head_lines[source_id]);
@@ -154,9 +139,9 @@ uint32_t HttpMsgHeadShared::find_header_end(const uint8_t* buffer, int32_t lengt
 // Divide header field lines into field name and field value
 void HttpMsgHeadShared::parse_header_lines()
 {
-    header_name = new Field[num_headers];
-    header_value = new Field[num_headers];
-    header_name_id = new HeaderId[num_headers];
+    header_name = arena.make_array<Field>(num_headers);
+    header_value = arena.make_array<Field>(num_headers);
+    header_name_id = arena.make_array<HeaderId>(num_headers);
 
     int colon;
     for (int k=0; k < num_headers; k++)
@@ -195,7 +180,7 @@ void HttpMsgHeadShared::derive_header_name_id(int index)
 
     // Normalize header field name to lower case and remove LWS for matching purposes
     int32_t lower_length = 0;
-    uint8_t* lower_name = new uint8_t[length];
+    uint8_t* lower_name = arena.make_array<uint8_t>(length);
     for (int32_t k=0; k < length; k++)
     {
         if (!is_sp_tab_cr_lf[buffer[k]])
@@ -215,7 +200,6 @@ void HttpMsgHeadShared::derive_header_name_id(int index)
         }
     }
     header_name_id[index] = (HeaderId)str_to_code(lower_name, lower_length, header_list);
-    delete[] lower_name;
 }
 
 HttpMsgHeadShared::NormalizedHeader* HttpMsgHeadShared::get_header_node(HeaderId header_id) const
@@ -57,7 +57,6 @@ protected:
         const HttpParaList* params_)
         : HttpMsgSection(buffer, buf_size, session_data_, source_id_, buf_owner, flow_, params_)
         { }
-    ~HttpMsgHeadShared();
     // Get the next item in a comma-separated header value and convert it to an enum value
     static int32_t get_next_code(const Field& field, int32_t& offset, const StrCode table[]);
     // Do a case insensitive search for "boundary=" in a Field
@@ -82,7 +81,8 @@ private:
     // Master table of known header fields and their normalization strategies.
     static const HeaderNormalizer* const header_norms[];
 
-    // All of these are indexed by the relative position of the header field in the message
+    // All of these are indexed by the relative position of the header field in the message. They
+    // and the list of normalized headers are allocated from the section arena.
     static const int MAX_HEADERS = 200;  // I'm an arbitrary number. FIXIT-L
     static const int MAX_HEADER_LENGTH = 4096; // Based on max cookie size of some browsers
 
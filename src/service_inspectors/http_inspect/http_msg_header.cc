@@ -27,6 +27,7 @@
 #include "file_api/file_service.h"
 #include "pub_sub/http_events.h"
 #include "decompress/file_decomp.h"
+#include "decompress/inflate_pool.h"
 
 #include "http_api.h"
 #include "http_msg_request.h"
@@ -352,18 +353,15 @@ void HttpMsgHeader::setup_encoding_decompression()
     if (compression == CMP_NONE)
         return;
 
-    session_data->compress_stream[source_id] = new z_stream;
-    session_data->compress_stream[source_id]->zalloc = Z_NULL;
-    session_data->compress_stream[source_id]->zfree = Z_NULL;
-    session_data->compress_stream[source_id]->next_in = Z_NULL;
-    session_data->compress_stream[source_id]->avail_in = 0;
     const int window_bits = (compression == CMP_GZIP) ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
-    if (inflateInit2(session_data->compress_stream[source_id], window_bits) != Z_OK)
-    {
+    const InflatePoolStats& pool_stats = InflatePool::get_stats();
+    const PegCount reuses = pool_stats.reuses;
+    session_data->compress_stream[source_id] = InflatePool::get(window_bits);
+    if (session_data->compress_stream[source_id] == nullptr)
         session_data->compression[source_id] = CMP_NONE;
-        delete session_data->compress_stream[source_id];
-        session_data->compress_stream[source_id] = nullptr;
-    }
+    else if (pool_stats.reuses != reuses)
+        HttpModule::increment_peg_counts(PEG_INFLATE_REUSE);
+    HttpModule::update_peg_max(PEG_INFLATE_MAX, pool_stats.memory);
 }
 
 void HttpMsgHeader::setup_utf_decoding()
@@ -55,13 +55,13 @@ public:
         return false;
     }
 
+    static const StrCode method_list[];
+
 #ifdef REG_TEST
     void print_section(FILE* output) override;
 #endif
 
 private:
-    static const StrCode method_list[];
-
     void parse_start_line() override;
     bool handle_zero_nine();
 
@@ -36,7 +36,7 @@ using namespace HttpEnums;
 HttpMsgSection::HttpMsgSection(const uint8_t* buffer, const uint16_t buf_size,
        HttpFlowData* session_data_, SourceId source_id_, bool buf_owner, Flow* flow_,
        const HttpParaList* params_) :
-    msg_text(buf_size, buffer, buf_owner),
+    msg_text(buf_size, buffer, buf_owner && !pooled_buffer(session_data_, source_id_, buf_owner)),
     session_data(session_data_),
     source_id(source_id_),
     flow(flow_),
@@ -48,11 +48,28 @@ HttpMsgSection::HttpMsgSection(const uint8_t* buffer, const uint16_t buf_size,
     events(session_data->events[source_id]),
     version_id(session_data->version_id[source_id]),
     method_id((source_id == SRC_CLIENT) ? session_data->method_id : METH__NOT_PRESENT),
-    status_code_num((source_id == SRC_SERVER) ? session_data->status_code_num : STAT_NOT_PRESENT)
+    status_code_num((source_id == SRC_SERVER) ? session_data->status_code_num : STAT_NOT_PRESENT),
+    body_buffer(pooled_buffer(session_data_, source_id_, buf_owner) ? const_cast<uint8_t*>(buffer) :
+        nullptr)
 {
     assert((source_id == SRC_CLIENT) || (source_id == SRC_SERVER));
 }
 
+HttpMsgSection::~HttpMsgSection()
+{
+    if (body_buffer != nullptr)
+        HttpArena::put_body_buffer(body_buffer);
+}
+
+bool HttpMsgSection::pooled_buffer(const HttpFlowData* session_data, SourceId source_id,
+    bool buf_owner)
+{
+    if (!buf_owner)
+        return false;
+    const SectionType type = session_data->section_type[source_id];
+    return (type == SEC_BODY_CL) || (type == SEC_BODY_CHUNK) || (type == SEC_BODY_OLD);
+}
+
 void HttpMsgSection::update_depth() const
 {
     if ((session_data->file_depth_remaining[source_id] <= 0) &&
@@ -22,6 +22,7 @@
 
 #include "detection/detection_util.h"
 
+#include "http_arena.h"
 #include "http_field.h"
 #include "http_module.h"
 #include "http_flow_data.h"
@@ -35,7 +36,11 @@
 class HttpMsgSection
 {
 public:
-    virtual ~HttpMsgSection() = default;
+    virtual ~HttpMsgSection();
+
+    // Section objects are recycled through per-thread free lists
+    static void* operator new(size_t size) { return HttpArena::get_object(size); }
+    static void operator delete(void* obj, size_t size) { HttpArena::put_object(obj, size); }
     virtual HttpEnums::InspectSection get_inspection_section() const
         { return HttpEnums::IS_NONE; }
     HttpEnums::SourceId get_source_id() { return source_id; }
@@ -68,6 +73,9 @@ protected:
         HttpEnums::SourceId source_id_, bool buf_owner, Flow* flow_, const HttpParaList*
         params_);
 
+    // Declared first so it is destroyed last
+    HttpArena arena;
+
     const Field msg_text;
 
     HttpFlowData* const session_data;
@@ -93,6 +101,13 @@ protected:
     void print_section_wrapup(FILE* output) const;
     void print_peg_counts(FILE* output) const;
 #endif
+
+private:
+    // Reassembled body sections arrive in pooled buffers that are returned rather than deleted
+    static bool pooled_buffer(const HttpFlowData* session_data, HttpEnums::SourceId source_id,
+        bool buf_owner);
+
+    uint8_t* const body_buffer;
 };
 
 #endif
@@ -25,6 +25,8 @@
 
 #include <cstring>
 
+#include "http_scan.h"
+
 using namespace HttpEnums;
 
 // Collection of stock normalization functions. This will probably grow throughout the life of the
@@ -34,12 +36,7 @@ using namespace HttpEnums;
 int32_t norm_to_lower(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf,
     HttpInfractions&, HttpEventGen&)
 {
-    for (int32_t k=0; k < in_length; k++)
-    {
-        // FIXIT-P tolower() might perform better but must be sure <locale> cannot be pulled in
-        out_buf[k] = ((in_buf[k] < 'A') || (in_buf[k] > 'Z')) ? in_buf[k] : in_buf[k] - ('A' -
-            'a');
-    }
+    HttpScan::to_lower(in_buf, in_length, out_buf);
     return in_length;
 }
 
@@ -47,13 +44,7 @@ int32_t norm_to_lower(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf
 int32_t norm_remove_lws(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf,
     HttpInfractions&, HttpEventGen&)
 {
-    int32_t length = 0;
-    for (int32_t k = 0; k < in_length; k++)
-    {
-        if (!is_sp_tab[in_buf[k]])
-            out_buf[length++] = in_buf[k];
-    }
-    return length;
+    return HttpScan::remove_sp_tab(in_buf, in_length, out_buf);
 }
 //FIXIT - norm_remove_lws and norm_remove_quotes_lws could be combined into one function
 int32_t norm_remove_quotes_lws(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf,
@@ -0,0 +1,148 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef HTTP_SCAN_H
+#define HTTP_SCAN_H
+
+// Bulk octet kernels for the header cutters and normalizers. Each has a
+// vector version for 16 (SSE2) or 32 (AVX2) octets at a time chosen at
+// build time and a scalar tail that also serves as the fallback on other
+// targets. Results are identical to the original one octet loops.
+
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace HttpScan
+{
+// Index of the first CR or LF in buffer or length if there is none
+inline uint32_t find_cr_lf(const uint8_t* buffer, uint32_t length)
+{
+    uint32_t k = 0;
+
+#if defined(__AVX2__)
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    for (; k + 32 <= length; k += 32)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(buffer + k));
+        const uint32_t mask = _mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    const __m128i lf16 = _mm_set1_epi8('\n');
+
+    for (; k + 16 <= length; k += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(buffer + k));
+        const uint32_t mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr16), _mm_cmpeq_epi8(v, lf16)));
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+
+    for (; k < length; k++)
+    {
+        if ((buffer[k] == '\r') || (buffer[k] == '\n'))
+            return k;
+    }
+    return length;
+}
+
+// Convert A-Z to a-z. in_buf and out_buf may be the same.
+inline void to_lower(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf)
+{
+    int32_t k = 0;
+
+#if defined(__SSE2__)
+    // Signed compares so bias the octets by 0x80 first
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const __m128i below_a = _mm_set1_epi8((char)('A' - 1 + 0x80));
+    const __m128i above_z = _mm_set1_epi8((char)('Z' + 1 + 0x80));
+    const __m128i shift = _mm_set1_epi8('a' - 'A');
+
+    for (; k + 16 <= in_length; k += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(in_buf + k));
+        const __m128i b = _mm_xor_si128(v, bias);
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(b, below_a), _mm_cmplt_epi8(b,
+            above_z));
+        _mm_storeu_si128((__m128i*)(out_buf + k), _mm_add_epi8(v, _mm_and_si128(upper, shift)));
+    }
+#endif
+
+    for (; k < in_length; k++)
+    {
+        out_buf[k] = ((in_buf[k] < 'A') || (in_buf[k] > 'Z')) ? in_buf[k] : in_buf[k] - ('A' -
+            'a');
+    }
+}
+
+// Copy in_buf to out_buf dropping spaces and tabs. Returns the output length. out_buf may be the
+// same as in_buf. Runs of 16 octets without white space, the common case, are moved as a block.
+inline int32_t remove_sp_tab(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf)
+{
+    int32_t length = 0;
+    int32_t k = 0;
+
+#if defined(__SSE2__)
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    while (k + 16 <= in_length)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(in_buf + k));
+        const uint32_t mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)));
+
+        if (mask == 0)
+        {
+            _mm_storeu_si128((__m128i*)(out_buf + length), v);
+            length += 16;
+            k += 16;
+            continue;
+        }
+
+        // Keep the clean prefix then skip the white space
+        const uint32_t first = __builtin_ctz(mask);
+        for (uint32_t j = 0; j < first; j++)
+            out_buf[length++] = in_buf[k + j];
+        k += first + 1;
+    }
+#endif
+
+    for (; k < in_length; k++)
+    {
+        if ((in_buf[k] != ' ') && (in_buf[k] != '\t'))
+            out_buf[length++] = in_buf[k];
+    }
+    return length;
+}
+}
+
+#endif
+
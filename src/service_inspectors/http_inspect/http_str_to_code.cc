@@ -23,13 +23,60 @@
 
 #include "http_str_to_code.h"
 
+#include <cassert>
 #include <cstring>
 
+#include "utils/str_table.h"
+
 #include "http_enum.h"
 
-// Need to replace this simple algorithm for better performance FIXIT-P
+struct StrCodeIndex
+{
+    const StrCode* table;
+    StrTable* index;
+};
+
+// Few tables are indexed so a pointer search beats another hash
+static const int MAX_INDEXES = 16;
+static StrCodeIndex indexes[MAX_INDEXES];
+static int num_indexes = 0;
+
+void str_to_code_index(const StrCode table[])
+{
+    for (int k=0; k < num_indexes; k++)
+    {
+        if (indexes[k].table == table)
+            return;
+    }
+    assert(num_indexes < MAX_INDEXES);
+    if (num_indexes >= MAX_INDEXES)
+        return;
+
+    StrTable* const index = new StrTable;
+    for (int32_t k=0; table[k].name != nullptr; k++)
+        index->add(table[k].name, table[k].code);
+    index->finalize();
+
+    indexes[num_indexes].table = table;
+    indexes[num_indexes].index = index;
+    num_indexes++;
+}
+
+void str_to_code_clear()
+{
+    for (int k=0; k < num_indexes; k++)
+        delete indexes[k].index;
+    num_indexes = 0;
+}
+
 int32_t str_to_code(const uint8_t* text, const int32_t text_len, const StrCode table[])
 {
+    for (int k=0; k < num_indexes; k++)
+    {
+        if (indexes[k].table == table)
+            return indexes[k].index->find(text, text_len, HttpEnums::STAT_OTHER);
+    }
+
     for (int32_t k=0; table[k].name != nullptr; k++)
     {
         if ((text_len == (int)strlen(table[k].name)) && (memcmp(text, table[k].name, text_len) ==
@@ -31,5 +31,10 @@ struct StrCode
 int32_t str_to_code(const uint8_t* text, const int32_t text_len, const StrCode table[]);
 int32_t substr_to_code(const uint8_t* text, const int32_t text_len, const StrCode table[]);
 
+// Build a hashed index for a table so str_to_code() doesn't search it. Tables without an index
+// are searched linearly. Must be called before packet processing begins.
+void str_to_code_index(const StrCode table[]);
+void str_to_code_clear();
+
 #endif
 
@@ -21,8 +21,10 @@
 #include "config.h"
 #endif
 
+#include "decompress/inflate_pool.h"
 #include "protocols/packet.h"
 
+#include "http_arena.h"
 #include "http_inspect.h"
 #include "http_stream_splitter.h"
 #include "http_test_input.h"
@@ -126,6 +128,9 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
         compress_stream->avail_out = MAX_OCTETS - offset;
         int ret_val = inflate(compress_stream, Z_SYNC_FLUSH);
 
+        // the window is allocated on the first inflate
+        HttpModule::update_peg_max(PEG_INFLATE_MAX, InflatePool::get_stats().memory);
+
         if ((ret_val == Z_OK) || (ret_val == Z_STREAM_END))
         {
             offset = MAX_OCTETS - compress_stream->avail_out;
@@ -151,8 +156,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
                     events.create_event(EVENT_GZIP_OVERRUN);
                 }
                 compression = CMP_NONE;
-                inflateEnd(compress_stream);
-                delete compress_stream;
+                InflatePool::put(compress_stream);
                 compress_stream = nullptr;
             }
             return;
@@ -178,8 +182,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
             infractions += INF_GZIP_FAILURE;
             events.create_event(EVENT_GZIP_FAILURE);
             compression = CMP_NONE;
-            inflateEnd(compress_stream);
-            delete compress_stream;
+            InflatePool::put(compress_stream);
             compress_stream = nullptr;
             // Since we failed to uncompress the data, fall through
         }
@@ -303,7 +306,7 @@ const StreamBuffer* HttpStreamSplitter::reassemble(Flow* flow, unsigned total, u
     {
         // Body sections need extra space to accommodate unzipping
         if (is_body)
-            buffer = new uint8_t[MAX_OCTETS];
+            buffer = HttpArena::get_body_buffer();
         else
             buffer = new uint8_t[total];
         session_data->section_total[source_id] = total;
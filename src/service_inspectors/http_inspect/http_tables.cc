@@ -378,6 +378,14 @@ const PegInfo HttpModule::peg_names[PEG_COUNT_MAX+1] =
     { "uri_normalizations", "URIs needing to be normalization" },
     { "uri_path", "URIs with path problems" },
     { "uri_coding", "URIs with character coding problems" },
+    { "arena_max_bytes", "most memory used by a message section arena" },
+    { "arena_chunks", "arena memory chunks allocated from the heap" },
+    { "buffer_reuses", "message body buffers reused without allocation" },
+    { "pipeline_max", "most requests waiting in a pipeline for their responses" },
+    { "transaction_reuses", "transactions recycled from a spare slot" },
+    { "section_reuses", "message sections recycled without allocation" },
+    { "inflate_reuses", "decompression streams reused from the inflate pool" },
+    { "inflate_max_bytes", "most memory held by pooled decompression streams, idle or not" },
     { nullptr, nullptr }
 };
 
@@ -23,6 +23,7 @@
 
 #include "http_transaction.h"
 
+#include "http_module.h"
 #include "http_msg_body.h"
 #include "http_msg_header.h"
 #include "http_msg_request.h"
@@ -31,15 +32,34 @@
 
 using namespace HttpEnums;
 
-HttpTransaction::~HttpTransaction()
+void HttpTransaction::clear()
 {
     delete request;
+    request = nullptr;
     delete status;
-    delete header[SRC_CLIENT];
-    delete header[SRC_SERVER];
-    delete trailer[SRC_CLIENT];
-    delete trailer[SRC_SERVER];
+    status = nullptr;
+    for (int k=0; k <= 1; k++)
+    {
+        delete header[k];
+        header[k] = nullptr;
+        delete trailer[k];
+        trailer[k] = nullptr;
+    }
     delete latest_body;
+    latest_body = nullptr;
+    response_seen = false;
+    second_response_expected = false;
+    shared_ownership = false;
+}
+
+HttpTransaction* HttpTransaction::new_transaction(HttpFlowData* session_data)
+{
+    if (session_data->num_spare_trans > 0)
+    {
+        HttpModule::increment_peg_counts(PEG_TRANS_REUSE);
+        return session_data->spare_trans[--session_data->num_spare_trans];
+    }
+    return new HttpTransaction;
 }
 
 HttpTransaction* HttpTransaction::attach_my_transaction(HttpFlowData* session_data, SourceId
@@ -71,23 +91,23 @@ HttpTransaction* HttpTransaction::attach_my_transaction(HttpFlowData* session_da
                 // needed it. Instead the two sides have been sharing the transaction. This is a
                 // soft delete that eliminates our interest in this transaction without disturbing
                 // the possibly ongoing response processing.
-                delete_transaction(session_data->transaction[SRC_CLIENT]);
+                delete_transaction(session_data->transaction[SRC_CLIENT], session_data);
             }
             else if ((session_data->pipeline_overflow) || (session_data->pipeline_underflow))
             {
                 // Pipelining previously broke down and both sides are processed separately from
                 // now on. We just throw things away when we are done with them.
-                delete_transaction(session_data->transaction[SRC_CLIENT]);
+                delete_transaction(session_data->transaction[SRC_CLIENT], session_data);
             }
             else if (!session_data->add_to_pipeline(session_data->transaction[SRC_CLIENT]))
             {
                 // The pipeline is full and just overflowed.
                 session_data->infractions[source_id] += INF_PIPELINE_OVERFLOW;
                 session_data->events[source_id].create_event(EVENT_PIPELINE_MAX);
-                delete_transaction(session_data->transaction[SRC_CLIENT]);
+                delete_transaction(session_data->transaction[SRC_CLIENT], session_data);
             }
         }
-        session_data->transaction[SRC_CLIENT] = new HttpTransaction;
+        session_data->transaction[SRC_CLIENT] = new_transaction(session_data);
     }
     // This transaction has more than one response. This is a new response which is replacing the
     // interim response. The two responses cannot coexist so we must clean up the interim response.
@@ -110,11 +130,11 @@ HttpTransaction* HttpTransaction::attach_my_transaction(HttpFlowData* session_da
     // response side.
     else if (session_data->section_type[source_id] == SEC_STATUS)
     {
-        delete_transaction(session_data->transaction[SRC_SERVER]);
+        delete_transaction(session_data->transaction[SRC_SERVER], session_data);
         if (session_data->pipeline_underflow)
         {
             // A previous underflow separated the two sides forever
-            session_data->transaction[SRC_SERVER] = new HttpTransaction;
+            session_data->transaction[SRC_SERVER] = new_transaction(session_data);
         }
         else if ((session_data->transaction[SRC_SERVER] = session_data->take_from_pipeline()) ==
             nullptr)
@@ -125,7 +145,7 @@ HttpTransaction* HttpTransaction::attach_my_transaction(HttpFlowData* session_da
                 // Either there is no request at all or there is a request but a previous response
                 // already took it. Either way we have more responses than requests.
                 session_data->pipeline_underflow = true;
-                session_data->transaction[SRC_SERVER] = new HttpTransaction;
+                session_data->transaction[SRC_SERVER] = new_transaction(session_data);
             }
 
             else if (session_data->type_expected[SRC_CLIENT] == SEC_REQUEST)
@@ -151,14 +171,19 @@ HttpTransaction* HttpTransaction::attach_my_transaction(HttpFlowData* session_da
     return session_data->transaction[source_id];
 }
 
-void HttpTransaction::delete_transaction(HttpTransaction* transaction)
+void HttpTransaction::delete_transaction(HttpTransaction* transaction, HttpFlowData* session_data)
 {
     if (transaction != nullptr)
     {
-        if (!transaction->shared_ownership)
-            delete transaction;
-        else
+        if (transaction->shared_ownership)
             transaction->shared_ownership = false;
+        else if (session_data->num_spare_trans < HttpFlowData::MAX_SPARE_TRANS)
+        {
+            transaction->clear();
+            session_data->spare_trans[session_data->num_spare_trans++] = transaction;
+        }
+        else
+            delete transaction;
     }
 }
 
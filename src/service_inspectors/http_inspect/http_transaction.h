@@ -36,7 +36,7 @@ class HttpTransaction
 public:
     static HttpTransaction* attach_my_transaction(HttpFlowData* session_data,
         HttpEnums::SourceId source_id);
-    static void delete_transaction(HttpTransaction* transaction);
+    static void delete_transaction(HttpTransaction* transaction, HttpFlowData* session_data);
 
     HttpMsgRequest* get_request() const { return request; }
     void set_request(HttpMsgRequest* request_) { request = request_; }
@@ -60,8 +60,14 @@ public:
     bool final_response() const { return !second_response_expected; }
 
 private:
+    friend class HttpFlowData;
+
     HttpTransaction() = default;
-    ~HttpTransaction();
+    ~HttpTransaction() { clear(); }
+
+    // Transactions are recycled through a few spare slots in the flow rather than deleted
+    static HttpTransaction* new_transaction(HttpFlowData* session_data);
+    void clear();
 
     HttpMsgRequest* request = nullptr;
     HttpMsgStatus* status = nullptr;
@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_arena_test.cc
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "service_inspectors/http_inspect/http_arena.h"
+#include "service_inspectors/http_inspect/http_module.h"
+
+#include <cstring>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace HttpEnums;
+
+// Stubs whose sole purpose is to make the test code link
+THREAD_LOCAL PegCount HttpModule::peg_counts[PEG_COUNT_MAX];
+
+static int live = 0;
+
+struct Counted
+{
+    Counted() { live++; }
+    explicit Counted(int v) : value(v) { live++; }
+    ~Counted() { live--; }
+    int value = 0;
+};
+
+TEST_GROUP(http_arena_test)
+{
+    void setup()
+    {
+        live = 0;
+        HttpArena::tinit();
+    }
+
+    void teardown()
+    {
+        HttpArena::tterm();
+    }
+};
+
+TEST(http_arena_test, alignment)
+{
+    HttpArena arena;
+    for (uint32_t size = 1; size < 100; size += 7)
+    {
+        void* p = arena.alloc(size);
+        CHECK(((uintptr_t)p % alignof(std::max_align_t)) == 0);
+        memset(p, 0xA5, size);
+    }
+}
+
+TEST(http_arena_test, destructors)
+{
+    {
+        HttpArena arena;
+        Counted* one = arena.make<Counted>(7);
+        Counted* many = arena.make_array<Counted>(10);
+        CHECK(one->value == 7);
+        CHECK(many[9].value == 0);
+        CHECK(live == 11);
+        arena.reset();
+        CHECK(live == 0);
+        CHECK(arena.get_used() == 0);
+        arena.make_array<Counted>(3);
+        CHECK(live == 3);
+    }
+    CHECK(live == 0);
+}
+
+TEST(http_arena_test, chunks_recycled)
+{
+    uint8_t* first;
+    {
+        HttpArena arena;
+        first = (uint8_t*)arena.alloc(100);
+        for (int k=0; k < 100; k++)
+            arena.alloc(1000);
+        arena.alloc(HttpArena::CHUNK_SIZE * 3);
+        CHECK(arena.get_used() >= 100 + 100 * 1000 + HttpArena::CHUNK_SIZE * 3);
+    }
+
+    // Standard chunks go back to the thread cache and the first one allocated comes out first
+    HttpArena arena;
+    CHECK(arena.alloc(100) == first);
+}
+
+TEST(http_arena_test, body_buffers)
+{
+    uint8_t* first = HttpArena::get_body_buffer();
+    first[MAX_OCTETS-1] = 0;
+    HttpArena::put_body_buffer(first);
+    uint8_t* second = HttpArena::get_body_buffer();
+    CHECK(second == first);
+    delete[] second;
+}
+
+TEST(http_arena_test, objects_recycled)
+{
+    void* small = HttpArena::get_object(64);
+    void* large = HttpArena::get_object(200);
+    HttpArena::put_object(small, 64);
+    HttpArena::put_object(large, 200);
+
+    // Lists are kept by size so a request never gets an object of another size
+    CHECK(HttpArena::get_object(200) == large);
+    CHECK(HttpArena::get_object(64) == small);
+    HttpArena::put_object(small, 64);
+    HttpArena::put_object(large, 200);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
@@ -111,6 +111,17 @@ TEST(http_peg_count_test, zero_out)
     CHECK(counts[PEG_INSPECT] == 1);
 }
 
+TEST(http_peg_count_test, count_types)
+{
+    const CountType* types = mod.get_count_types();
+    CHECK(types[PEG_ARENA_MAX] == CountType::MAX);
+    CHECK(types[PEG_ARENA_CHUNKS] == CountType::SUM);
+    CHECK(types[PEG_PIPELINE_MAX] == CountType::MAX);
+    CHECK(types[PEG_INFLATE_REUSE] == CountType::SUM);
+    CHECK(types[PEG_INFLATE_MAX] == CountType::MAX);
+    CHECK(types[PEG_INSPECT] == CountType::SUM);
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -0,0 +1,187 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_scan_test.cc
+// unit test main
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "service_inspectors/http_inspect/http_scan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// Header blocks recorded from live traffic with the addresses and cookies changed
+static const char* const corpus[] =
+{
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:52.0) Gecko/20100101 Firefox/52.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Cookie: SESSIONID=0123456789ABCDEF; _ga=GA1.2.1234567890.1490000000\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n\r\n",
+
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Tue, 21 Mar 2017 16:05:12 GMT\r\n"
+    "Server: Apache/2.4.18 (Ubuntu)\r\n"
+    "Last-Modified: Mon, 20 Mar 2017 09:14:37 GMT\r\n"
+    "ETag: \"2cf6-54b2f1b1d5a3c-gzip\"\r\n"
+    "Accept-Ranges: bytes\r\n"
+    "Vary: Accept-Encoding\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: 3221\r\n"
+    "Keep-Alive: timeout=5, max=100\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n\r\n",
+
+    "POST /cgi-bin/upload HTTP/1.0\n"
+    "Host:\t10.1.2.3\n"
+    "Content-Type: multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW\n"
+    "Transfer-Encoding:   gzip ,  chunked\n"
+    "X-Forwarded-For: 192.0.2.1, 198.51.100.7\r\r\n\n",
+};
+
+static uint32_t ref_find_cr_lf(const uint8_t* buffer, uint32_t length)
+{
+    for (uint32_t k = 0; k < length; k++)
+        if ((buffer[k] == '\r') || (buffer[k] == '\n'))
+            return k;
+    return length;
+}
+
+static void ref_to_lower(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf)
+{
+    for (int32_t k=0; k < in_length; k++)
+        out_buf[k] = ((in_buf[k] < 'A') || (in_buf[k] > 'Z')) ? in_buf[k] : in_buf[k] - ('A' - 'a');
+}
+
+static int32_t ref_remove_sp_tab(const uint8_t* in_buf, int32_t in_length, uint8_t* out_buf)
+{
+    int32_t length = 0;
+    for (int32_t k = 0; k < in_length; k++)
+        if ((in_buf[k] != ' ') && (in_buf[k] != '\t'))
+            out_buf[length++] = in_buf[k];
+    return length;
+}
+
+// Every starting offset and length so the vector loops and the scalar tails are all exercised
+static void check_all(const uint8_t* buf, int32_t size)
+{
+    std::vector<uint8_t> expect(size), actual(size);
+
+    for (int32_t start = 0; start < size; start++)
+    {
+        for (int32_t len = 0; start + len <= size; len += (len < 80) ? 1 : 7)
+        {
+            const uint8_t* in = buf + start;
+
+            CHECK(HttpScan::find_cr_lf(in, len) == ref_find_cr_lf(in, len));
+
+            ref_to_lower(in, len, expect.data());
+            HttpScan::to_lower(in, len, actual.data());
+            CHECK(memcmp(expect.data(), actual.data(), len) == 0);
+
+            const int32_t n = ref_remove_sp_tab(in, len, expect.data());
+            CHECK(HttpScan::remove_sp_tab(in, len, actual.data()) == n);
+            CHECK(memcmp(expect.data(), actual.data(), n) == 0);
+        }
+    }
+}
+
+TEST_GROUP(http_scan_test) {};
+
+TEST(http_scan_test, corpus)
+{
+    for (auto text : corpus)
+        check_all((const uint8_t*)text, strlen(text));
+}
+
+TEST(http_scan_test, all_octets)
+{
+    uint8_t buf[512];
+    for (unsigned k = 0; k < sizeof(buf); k++)
+        buf[k] = (uint8_t)(k * 7 + 3);
+    check_all(buf, sizeof(buf));
+}
+
+TEST(http_scan_test, in_place)
+{
+    std::string text = "Accept-Encoding:  gzip,\tdeflate , br AND SOME MORE UPPER CASE TEXT   x";
+    std::vector<uint8_t> expect(text.size());
+    std::vector<uint8_t> buf(text.begin(), text.end());
+
+    ref_to_lower(buf.data(), buf.size(), expect.data());
+    HttpScan::to_lower(buf.data(), buf.size(), buf.data());
+    CHECK(memcmp(expect.data(), buf.data(), buf.size()) == 0);
+
+    const int32_t n = ref_remove_sp_tab(buf.data(), buf.size(), expect.data());
+    CHECK(HttpScan::remove_sp_tab(buf.data(), buf.size(), buf.data()) == n);
+    CHECK(memcmp(expect.data(), buf.data(), n) == 0);
+}
+
+// Not run by default. Use -ri to include ignored tests.
+IGNORE_TEST(http_scan_test, benchmark)
+{
+    using namespace std::chrono;
+    const unsigned reps = 200000;
+    std::vector<uint8_t> out(4096);
+    uint64_t sink = 0;
+
+    for (auto text : corpus)
+    {
+        const uint8_t* in = (const uint8_t*)text;
+        const int32_t len = strlen(text);
+
+        auto t0 = steady_clock::now();
+        for (unsigned r = 0; r < reps; r++)
+        {
+            for (int32_t k = 0; k < len; k += ref_find_cr_lf(in + k, len - k) + 1);
+            ref_to_lower(in, len, out.data());
+            sink += ref_remove_sp_tab(in, len, out.data());
+        }
+        auto t1 = steady_clock::now();
+        for (unsigned r = 0; r < reps; r++)
+        {
+            for (int32_t k = 0; k < len; k += HttpScan::find_cr_lf(in + k, len - k) + 1);
+            HttpScan::to_lower(in, len, out.data());
+            sink += HttpScan::remove_sp_tab(in, len, out.data());
+        }
+        auto t2 = steady_clock::now();
+
+        printf("\n%4d octets: scalar %6ld ns vector %6ld ns per header block", len,
+            (long)(duration_cast<nanoseconds>(t1 - t0).count() / reps),
+            (long)(duration_cast<nanoseconds>(t2 - t1).count() / reps));
+    }
+    CHECK(sink > 0);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
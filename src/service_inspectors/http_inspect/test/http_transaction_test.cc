@@ -39,7 +39,7 @@ unsigned FlowData::flow_id = 0;
 FlowData::FlowData(unsigned, Inspector*) {}
 FlowData::~FlowData() {}
 int SnortEventqAdd(unsigned int, unsigned int, RuleType) { return 0; }
-THREAD_LOCAL PegCount HttpModule::peg_counts[1];
+THREAD_LOCAL PegCount HttpModule::peg_counts[PEG_COUNT_MAX];
 fd_status_t File_Decomp_StopFree(fd_session_t*) { return File_Decomp_OK; }
 
 class HttpUnitTestSetup
@@ -49,6 +49,20 @@ public:
         { assert(flow_data!=nullptr); return flow_data->section_type; }
     static SectionType* get_type_expected(HttpFlowData* flow_data)
         { assert(flow_data!=nullptr); return flow_data->type_expected; }
+    static int64_t* get_detect_depth_remaining(HttpFlowData* flow_data)
+        { assert(flow_data!=nullptr); return flow_data->detect_depth_remaining; }
+    static int64_t* get_file_depth_remaining(HttpFlowData* flow_data)
+        { assert(flow_data!=nullptr); return flow_data->file_depth_remaining; }
+    static HttpCutter** get_cutter(HttpFlowData* flow_data)
+        { assert(flow_data!=nullptr); return flow_data->cutter; }
+};
+
+// Stands in for the cutter that is present while a section is being scanned
+class HttpTestCutter : public HttpCutter
+{
+public:
+    ScanResult cut(const uint8_t*, uint32_t, HttpInfractions&, HttpEventGen&, uint32_t, uint32_t)
+        override { return SCAN_NOTFOUND; }
 };
 
 TEST_GROUP(http_transaction_test)
@@ -467,6 +481,90 @@ TEST(http_transaction_test, pipeline_continue_pipeline)
     }
 }
 
+TEST_GROUP(http_needs_inspection_test)
+{
+    HttpFlowData* const flow_data = new HttpFlowData;
+    SectionType* const type_expected = HttpUnitTestSetup::get_type_expected(flow_data);
+    int64_t* const detect_depth = HttpUnitTestSetup::get_detect_depth_remaining(flow_data);
+    int64_t* const file_depth = HttpUnitTestSetup::get_file_depth_remaining(flow_data);
+    HttpCutter** const cutter = HttpUnitTestSetup::get_cutter(flow_data);
+
+    void teardown()
+    {
+        delete flow_data;
+    }
+};
+
+TEST(http_needs_inspection_test, new_flow)
+{
+    // Nothing has been seen yet and the first request is still to come
+    CHECK(flow_data->needs_inspection());
+}
+
+TEST(http_needs_inspection_test, headers)
+{
+    // Request headers are being parsed and the body depths are not yet known
+    type_expected[SRC_CLIENT] = SEC_HEADER;
+    CHECK(flow_data->needs_inspection());
+    type_expected[SRC_CLIENT] = SEC_REQUEST;
+    type_expected[SRC_SERVER] = SEC_HEADER;
+    CHECK(flow_data->needs_inspection());
+    type_expected[SRC_SERVER] = SEC_TRAILER;
+    CHECK(flow_data->needs_inspection());
+}
+
+TEST(http_needs_inspection_test, body_depths)
+{
+    // Response body is inspected until both of its depths are used up
+    type_expected[SRC_SERVER] = SEC_BODY_CL;
+    detect_depth[SRC_SERVER] = 100;
+    file_depth[SRC_SERVER] = 200;
+    CHECK(flow_data->needs_inspection());
+    detect_depth[SRC_SERVER] = 0;
+    CHECK(flow_data->needs_inspection());
+    file_depth[SRC_SERVER] = 0;
+    CHECK(!flow_data->needs_inspection());
+
+    // Request body with depth left keeps the flow untrusted too
+    type_expected[SRC_CLIENT] = SEC_BODY_CHUNK;
+    detect_depth[SRC_CLIENT] = 1;
+    CHECK(flow_data->needs_inspection());
+    detect_depth[SRC_CLIENT] = 0;
+    CHECK(!flow_data->needs_inspection());
+}
+
+TEST(http_needs_inspection_test, keep_alive)
+{
+    // Exhausted response body followed by the next keep-alive request on the same connection
+    type_expected[SRC_SERVER] = SEC_BODY_CHUNK;
+    detect_depth[SRC_SERVER] = 0;
+    file_depth[SRC_SERVER] = 0;
+    CHECK(!flow_data->needs_inspection());
+
+    // Body is over and both sides wait for the next message
+    type_expected[SRC_SERVER] = SEC_STATUS;
+    detect_depth[SRC_SERVER] = STAT_NOT_PRESENT;
+    file_depth[SRC_SERVER] = STAT_NOT_PRESENT;
+    CHECK(flow_data->needs_inspection());
+
+    // Exhausted response body while a pipelined request line has started to arrive
+    type_expected[SRC_SERVER] = SEC_BODY_OLD;
+    detect_depth[SRC_SERVER] = 0;
+    file_depth[SRC_SERVER] = 0;
+    CHECK(!flow_data->needs_inspection());
+    cutter[SRC_CLIENT] = new HttpTestCutter;
+    CHECK(flow_data->needs_inspection());
+}
+
+TEST(http_needs_inspection_test, aborted)
+{
+    // No further message can start in either direction
+    type_expected[SRC_CLIENT] = SEC_ABORT;
+    CHECK(flow_data->needs_inspection());
+    type_expected[SRC_SERVER] = SEC_ABORT;
+    CHECK(!flow_data->needs_inspection());
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -26,6 +26,7 @@
 struct SSL_PROTO_CONF
 {
     bool trustservers;
+    bool header_only;
     int max_heartbeat_len;
 };
 
@@ -49,6 +50,9 @@ struct SslStats
     PegCount bad_handshakes;
     PegCount stopped;
     PegCount disabled;
+    PegCount header_only;
+    PegCount renegotiations;
+    PegCount header_only_aborts;
 };
 
 extern const PegInfo ssl_peg_names[];
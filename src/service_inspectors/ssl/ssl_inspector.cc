@@ -33,6 +33,7 @@
 #include "protocols/packet.h"
 #include "protocols/ssl.h"
 #include "stream/stream.h"
+#include "stream/stream_splitter.h"
 
 #include "ssl_module.h"
 
@@ -66,6 +67,9 @@ const PegInfo ssl_peg_names[] =
     { "bad_handshakes", "total bad handshakes" },
     { "sessions_ignored", "total sessions ignore" },
     { "detection_disabled", "total detection disabled" },
+    { "header_only", "sessions switched to header only tracking of encrypted records" },
+    { "renegotiations", "handshake records seen in header only mode" },
+    { "header_only_aborts", "invalid record headers ending header only tracking" },
 
     { nullptr, nullptr }
 };
@@ -92,6 +96,10 @@ static void PrintSslConf(SSL_PROTO_CONF* config)
     {
         LogMessage("    Server side data is trusted\n");
     }
+    if ( config->header_only )
+    {
+        LogMessage("    Encrypted records are tracked by header only\n");
+    }
 
     LogMessage("\n");
 }
@@ -163,6 +171,180 @@ static inline bool SSLPP_is_encrypted(SSL_PROTO_CONF* config, uint32_t ssl_flags
     return false;
 }
 
+static void SSLPP_alert_heartbleed(uint8_t heartbleed_type, uint8_t dir)
+{
+    if (heartbleed_type & SSL_HEARTBLEED_REQUEST)
+    {
+        SnortEventqAdd(GID_SSL, SSL_ALERT_HB_REQUEST);
+    }
+    else if (heartbleed_type & SSL_HEARTBLEED_RESPONSE)
+    {
+        SnortEventqAdd(GID_SSL, SSL_ALERT_HB_RESPONSE);
+    }
+    else if (heartbleed_type & SSL_HEARTBLEED_UNKNOWN)
+    {
+        if (!dir)
+        {
+            SnortEventqAdd(GID_SSL, SSL_ALERT_HB_REQUEST);
+        }
+        else
+        {
+            SnortEventqAdd(GID_SSL, SSL_ALERT_HB_RESPONSE);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// header only mode
+//
+// Once both sides are encrypted, stream_tcp can stop reassembling the
+// payload.  This splitter then sees the in order data of one direction as
+// it arrives and follows the record headers, checking heartbeats and
+// counting handshakes (renegotiation).  It starts where the last PDU left
+// off, with the remainder of a partial record taken from the flow data.
+//-------------------------------------------------------------------------
+
+#define SSL_MAX_REC_LEN (16384 + 2048)
+#define SSL_HB_HDR_LEN (SSL_REC_PAYLOAD_OFFSET + sizeof(SSL_heartbeat))
+
+class SslHeaderSplitter : public StreamSplitter
+{
+public:
+    SslHeaderSplitter(bool c2s, int max_hb) : StreamSplitter(c2s)
+    { max_heartbeat_len = max_hb; }
+
+    Status scan(Flow*, const uint8_t* data, uint32_t len, uint32_t flags, uint32_t*) override;
+
+private:
+    bool check_record();
+
+    int max_heartbeat_len;
+    uint32_t skip = 0;     // record payload left to pass over
+    uint32_t have = 0;     // bytes in hdr
+    uint32_t need = SSL_REC_PAYLOAD_OFFSET;
+    bool started = false;
+    uint8_t hdr[SSL_HB_HDR_LEN];
+};
+
+// returns false if the header can't be from a record
+bool SslHeaderSplitter::check_record()
+{
+    const SSL_record_t* rec = (const SSL_record_t*)hdr;
+    uint16_t reclen = ntohs(rec->length);
+
+    if ( rec->major != 3 or reclen > SSL_MAX_REC_LEN )
+        return false;
+
+    switch ( rec->type )
+    {
+    case SSL_CHANGE_CIPHER_REC:
+        sslstats.cipher_change++;
+        break;
+
+    case SSL_ALERT_REC:
+        sslstats.alerts++;
+        break;
+
+    case SSL_HANDSHAKE_REC:
+        sslstats.renegotiations++;
+        break;
+
+    case SSL_APPLICATION_REC:
+        break;
+
+    case SSL_HEARTBEAT_REC:
+        // the heartbeat type and length follow the header
+        if ( have < SSL_HB_HDR_LEN and reclen >= sizeof(SSL_heartbeat) )
+        {
+            need = SSL_HB_HDR_LEN;
+            return true;
+        }
+        if ( max_heartbeat_len and have == SSL_HB_HDR_LEN )
+        {
+            const SSL_heartbeat* hb = (const SSL_heartbeat*)(hdr + SSL_REC_PAYLOAD_OFFSET);
+            uint8_t heartbleed_type = 0;
+
+            if ( hb->type == SSL_HEARTBEAT_REQUEST )
+            {
+                if ( ntohs(hb->length) > max_heartbeat_len )
+                    heartbleed_type = SSL_HEARTBLEED_REQUEST;
+            }
+            else if ( reclen > max_heartbeat_len )
+            {
+                heartbleed_type = ( hb->type == SSL_HEARTBEAT_RESPONSE ) ?
+                    SSL_HEARTBLEED_RESPONSE : SSL_HEARTBLEED_UNKNOWN;
+            }
+            SSLPP_alert_heartbleed(heartbleed_type, to_server() ? 0 : 1);
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    skip = reclen - (have - SSL_REC_PAYLOAD_OFFSET);
+    have = 0;
+    need = SSL_REC_PAYLOAD_OFFSET;
+    return true;
+}
+
+StreamSplitter::Status SslHeaderSplitter::scan(
+    Flow* flow, const uint8_t* data, uint32_t len, uint32_t, uint32_t*)
+{
+    if ( !started )
+    {
+        SSLData* sd = get_ssl_session_data(flow);
+
+        if ( !sd )
+            return ABORT;
+
+        // partial_rec_len of the reassembled direction
+        skip = sd->partial_rec_len[(to_server() ? 0 : 1) + 2];
+        started = true;
+    }
+
+    while ( len )
+    {
+        if ( skip )
+        {
+            uint32_t n = ( len < skip ) ? len : skip;
+            skip -= n;
+            data += n;
+            len -= n;
+            continue;
+        }
+
+        uint32_t n = need - have;
+
+        if ( n > len )
+            n = len;
+
+        memcpy(hdr + have, data, n);
+        have += n;
+        data += n;
+        len -= n;
+
+        if ( have == need and !check_record() )
+        {
+            sslstats.header_only_aborts++;
+            return ABORT;
+        }
+    }
+    return SEARCH;
+}
+
+static void SSLPP_start_header_only(SSL_PROTO_CONF* config, SSLData* sd, Packet* p)
+{
+    Stream::set_header_only(p->flow, true,
+        new SslHeaderSplitter(true, config->max_heartbeat_len));
+
+    Stream::set_header_only(p->flow, false,
+        new SslHeaderSplitter(false, config->max_heartbeat_len));
+
+    sd->header_only = true;
+    sslstats.header_only++;
+}
+
 static inline uint32_t SSLPP_process_alert(
     SSL_PROTO_CONF*, uint32_t ssn_flags, uint32_t new_flags, const Packet* packet)
 {
@@ -310,25 +492,8 @@ static void snort_ssl(SSL_PROTO_CONF* config, Packet* p)
     uint32_t new_flags = SSL_decode(p->data, (int)p->dsize, p->packet_flags, sd->ssn_flags,
         &heartbleed_type, &(sd->partial_rec_len[dir+index]), config->max_heartbeat_len);
 
-    if (heartbleed_type & SSL_HEARTBLEED_REQUEST)
-    {
-        SnortEventqAdd(GID_SSL, SSL_ALERT_HB_REQUEST);
-    }
-    else if (heartbleed_type & SSL_HEARTBLEED_RESPONSE)
-    {
-        SnortEventqAdd(GID_SSL, SSL_ALERT_HB_RESPONSE);
-    }
-    else if (heartbleed_type & SSL_HEARTBLEED_UNKNOWN)
-    {
-        if (!dir)
-        {
-            SnortEventqAdd(GID_SSL, SSL_ALERT_HB_REQUEST);
-        }
-        else
-        {
-            SnortEventqAdd(GID_SSL, SSL_ALERT_HB_RESPONSE);
-        }
-    }
+    SSLPP_alert_heartbleed(heartbleed_type, dir);
+
     if (sd->ssn_flags & SSL_ENCRYPTED_FLAG )
     {
         sslstats.decoded++;
@@ -386,6 +551,10 @@ static void snort_ssl(SSL_PROTO_CONF* config, Packet* p)
     else if (SSL_IS_APP(new_flags))
     {
         sd->ssn_flags = SSLPP_process_app(config, sd->ssn_flags, new_flags, p);
+
+        if ((sd->ssn_flags & SSL_ENCRYPTED_FLAG) && config->header_only &&
+            config->max_heartbeat_len && !sd->header_only)
+            SSLPP_start_header_only(config, sd, p);
     }
     else
     {
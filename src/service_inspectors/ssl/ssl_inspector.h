@@ -34,6 +34,7 @@ struct SSLData
 {
     uint32_t ssn_flags;
     uint16_t partial_rec_len[4];
+    bool header_only;  // stream_tcp asked to track record headers only
 };
 
 class SslFlowData : public FlowData
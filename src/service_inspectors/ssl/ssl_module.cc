@@ -41,6 +41,9 @@ static const Parameter s_params[] =
     { "max_heartbeat_length", Parameter::PT_INT, "0:65535", "0",
       "maximum length of heartbeat record allowed" },
 
+    { "header_only", Parameter::PT_BOOL, nullptr, "false",
+      "once both sides are encrypted, follow record headers without reassembling payload" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -89,6 +92,9 @@ bool SslModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("max_heartbeat_length") )
         conf->max_heartbeat_len = v.get_long();
 
+    else if ( v.is("header_only") )
+        conf->header_only = v.get_bool();
+
     else
         return false;
 
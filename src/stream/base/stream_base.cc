@@ -74,6 +74,8 @@ const PegInfo base_pegs[] =
     PROTO_PEGS("udp"),
     PROTO_PEGS("user"),
     PROTO_PEGS("file"),
+    { "elephant_flows", "flows that reached trust_bytes" },
+    { "trusted_elephants", "flows whitelisted after reaching trust_bytes" },
     { nullptr, nullptr }
 };
 
@@ -90,6 +92,9 @@ void base_sum()
     SET_PROTO_COUNTS(user, PDU);
     SET_PROTO_COUNTS(file, FILE);
 
+    stream_base_stats.elephant_flows = flow_con->get_elephants();
+    stream_base_stats.trusted_elephants = flow_con->get_trusted();
+
     sum_stats((PegCount*)&g_stats, (PegCount*)&stream_base_stats,
         array_size(base_pegs)-1);
 }
@@ -192,6 +197,8 @@ void StreamBase::tinit()
 
     if ( max > 0 )
         flow_con->init_exp(max);
+
+    flow_con->init_trust(config.trust_bytes);
 }
 
 void StreamBase::tterm()
@@ -68,6 +68,9 @@ static const Parameter s_params[] =
     CACHE_TABLE("user_cache", "user", user_params),
     CACHE_TABLE("file_cache", "file", file_params),
 
+    { "trust_bytes", Parameter::PT_INT, "0:", "0",
+      "whitelist flows past this many payload bytes once no inspector needs them (0 = never)" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -106,6 +109,11 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig*)
         config.ip_frags_only = v.get_bool();
         return true;
     }
+    else if ( v.is("trust_bytes") )
+    {
+        config.trust_bytes = v.get_long();
+        return true;
+    }
     else if ( strstr(fqn, "ip_cache") )
         fc = &config.ip_cfg;
 
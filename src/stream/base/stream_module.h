@@ -52,6 +52,8 @@ struct BaseStats
     PROTO_FIELDS(udp);
     PROTO_FIELDS(user);
     PROTO_FIELDS(file);
+    PegCount elephant_flows;
+    PegCount trusted_elephants;
 };
 
 extern const PegInfo base_pegs[];
@@ -66,6 +68,7 @@ struct StreamModuleConfig
     FlowConfig udp_cfg;
     FlowConfig user_cfg;
     FlowConfig file_cfg;
+    uint64_t trust_bytes;
     bool ip_frags_only;
 };
 
@@ -94,13 +94,11 @@ const PegInfo* StreamIcmpModule::get_pegs() const
 PegCount* StreamIcmpModule::get_counts() const
 { return (PegCount*)&icmpStats; }
 
-void StreamIcmpModule::sum_stats(bool accumulate_now_stats)
+const CountType* StreamIcmpModule::get_count_types() const
 {
     assert(sizeof(IcmpStats)/sizeof(PegCount) == sizeof(IcmpStatTypes)/sizeof(CountType));
 
     static const IcmpStatTypes icmp_stat_types;
-    static const CountType* const count_types = (const CountType*)&icmp_stat_types;
-
-    sum_stats_helper(accumulate_now_stats, count_types);
+    return (const CountType*)&icmp_stat_types;
 }
 
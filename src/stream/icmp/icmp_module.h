@@ -62,7 +62,7 @@ public:
     ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
-    void sum_stats(bool) override;
+    const CountType* get_count_types() const override;
 
     StreamIcmpConfig* get_data();
 
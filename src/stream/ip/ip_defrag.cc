@@ -70,6 +70,8 @@
 
 #include "ip_defrag.h"
 
+#include <cassert>
+
 #include "detection/detect.h"
 #include "log/messages.h"
 #include "main/snort.h"
@@ -85,6 +87,12 @@
 #include "ip_session.h"
 #include "stream_ip.h"
 
+#ifdef UNIT_TEST
+#include <vector>
+
+#include "catch/catch.hpp"
+#endif
+
 /*  D E F I N E S  **************************************************/
 
 /* flags for the FragTracker->frag_flags field */
@@ -94,6 +102,7 @@
 #define FRAG_BAD            0x00000008
 #define FRAG_NO_BSD_VULN    0x00000010
 #define FRAG_DROP_FRAGMENTS 0x00000020
+#define FRAG_UNORDERED      0x00000040  /* fraglist not in offset order */
 
 /* return values for CheckTimeout() */
 #define FRAG_TIME_OK            0
@@ -135,8 +144,43 @@ struct Fragment
 
     int ord;
     char last;
+    uint8_t size_class;  /* FragPool bucket this node was carved from */
+};
+
+/* fragment nodes and their data are carved from a single block sized to
+ * a power of 2.  released blocks are cached per size class by each packet
+ * thread so that fragment floods don't thrash the heap.  blocks are charged
+ * to mem_in_use at their full size from allocation until they are freed so
+ * idle cached blocks are accounted for too. */
+#define FRAG_POOL_MIN_BITS   6      /* 64 byte data blocks */
+#define FRAG_POOL_MAX_BITS  16      /* IP_MAXPACKET fits the largest class */
+#define FRAG_POOL_CLASSES   (FRAG_POOL_MAX_BITS - FRAG_POOL_MIN_BITS + 1)
+#define FRAG_POOL_CACHE     (1024 * 1024)  /* max data bytes cached per class */
+#define FRAG_POOL_NONE      FRAG_POOL_CLASSES  /* size_class of unpooled nodes */
+
+class FragPool
+{
+public:
+    FragPool();
+    ~FragPool();
+
+    Fragment* get(uint16_t len);
+    void put(Fragment*);
+
+    static void free_block(Fragment*);
+
+private:
+    Fragment* free_list[FRAG_POOL_CLASSES];
+    unsigned free_count[FRAG_POOL_CLASSES];
 };
 
+/* the fragment index mirrors the fraglist so overlap candidates can be
+ * found with a binary search instead of a walk of the list.  that only works
+ * while the list is in offset order; the engine policies can leave a trimmed
+ * node past its successor and reassembly depends on that order, so such a
+ * tracker drops its index and walks the list instead. */
+#define FRAG_INDEX_MIN 16
+
 /*  G L O B A L S  **************************************************/
 
 // FIXIT-M convert to session memcap
@@ -144,6 +188,7 @@ static THREAD_LOCAL unsigned long mem_in_use = 0; /* memory in use, used for sel
 
 static THREAD_LOCAL uint32_t pkt_snaplen = 0;
 static THREAD_LOCAL Packet** defrag_pkts;  // An array of Packet pointers
+static THREAD_LOCAL FragPool* frag_pool = nullptr;
 
 /* enum for policy names */
 static const char* const frag_policy_names[] =
@@ -734,9 +779,6 @@ static void FragRebuild(FragTracker* ft, Packet* p)
 
 // XXX NOT YET IMPLEMENTED - debugging
 
-    if (!defrag_pkts[encap_frag_cnt])
-        defrag_pkts[encap_frag_cnt] = new Packet();
-
     dpkt = defrag_pkts[encap_frag_cnt];
 
     PacketManager::encode_format(ENC_FLAG_DEF|ENC_FLAG_FWD, p, dpkt, PSEUDO_PKT_IP);
@@ -898,6 +940,291 @@ static void FragRebuild(FragTracker* ft, Packet* p)
     ft->frag_flags = ft->frag_flags | FRAG_REBUILT;
 }
 
+//-------------------------------------------------------------------------
+// fragment pool
+//-------------------------------------------------------------------------
+
+FragPool::FragPool()
+{
+    for ( unsigned i = 0; i < FRAG_POOL_CLASSES; ++i )
+    {
+        free_list[i] = nullptr;
+        free_count[i] = 0;
+    }
+}
+
+FragPool::~FragPool()
+{
+    for ( unsigned i = 0; i < FRAG_POOL_CLASSES; ++i )
+    {
+        while ( Fragment* f = free_list[i] )
+        {
+            free_list[i] = f->next;
+            free_block(f);
+        }
+    }
+    ip_stats.mem_in_use = mem_in_use;
+}
+
+void FragPool::free_block(Fragment* f)
+{
+    mem_in_use -= sizeof(Fragment) + (1u << (f->size_class + FRAG_POOL_MIN_BITS));
+    snort_free(f);
+}
+
+Fragment* FragPool::get(uint16_t len)
+{
+    unsigned bits = FRAG_POOL_MIN_BITS;
+
+    while ( (1u << bits) < len )
+        ++bits;
+
+    unsigned c = bits - FRAG_POOL_MIN_BITS;
+    Fragment* f = free_list[c];
+
+    if ( f )
+    {
+        free_list[c] = f->next;
+        free_count[c]--;
+    }
+    else
+    {
+        f = (Fragment*)snort_alloc(sizeof(Fragment) + (1u << bits));
+        mem_in_use += sizeof(Fragment) + (1u << bits);
+    }
+
+    memset(f, 0, sizeof(*f));
+    f->fptr = (uint8_t*)(f + 1);
+    f->size_class = c;
+
+    return f;
+}
+
+void FragPool::put(Fragment* f)
+{
+    unsigned c = f->size_class;
+
+    if ( (free_count[c] << (c + FRAG_POOL_MIN_BITS)) >= FRAG_POOL_CACHE )
+    {
+        free_block(f);
+        return;
+    }
+
+    f->next = free_list[c];
+    free_list[c] = f;
+    free_count[c]++;
+}
+
+/**
+ * Get a Fragment with room for len bytes of data
+ *
+ * @param len size of the data buffer
+ *
+ * @return new fragment with fptr and flen set, all else zero
+ */
+static Fragment* new_frag(uint16_t len)
+{
+    Fragment* frag;
+
+    if ( frag_pool )
+        frag = frag_pool->get(len);
+    else
+    {
+        frag = (Fragment*)snort_calloc(sizeof(Fragment) + len);
+        frag->fptr = (uint8_t*)(frag + 1);
+        frag->size_class = FRAG_POOL_NONE;
+        mem_in_use += sizeof(Fragment) + len;
+    }
+
+    frag->flen = len;
+    ip_stats.mem_in_use = mem_in_use;
+
+    return frag;
+}
+
+//-------------------------------------------------------------------------
+// fragment index
+//-------------------------------------------------------------------------
+
+/**
+ * Find the position of the first indexed Fragment at or beyond an offset
+ *
+ * @param ft FragTracker to search, must not be FRAG_UNORDERED
+ * @param offset fragment offset to look for
+ *
+ * @return index of the first Fragment with offset >= the given offset,
+ *         or fraglist_count if there is no such Fragment
+ */
+static inline unsigned frag_index_find(const FragTracker* ft, uint16_t offset)
+{
+    unsigned lo = 0;
+    unsigned hi = ft->fraglist_count;
+
+    // in order arrival is the common case
+    if ( !hi or ft->fraglist_tail->offset < offset )
+        return hi;
+
+    while ( lo < hi )
+    {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        if ( ft->fragindex[mid]->offset < offset )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void frag_index_clear(FragTracker* ft)
+{
+    if ( !ft->fragindex )
+        return;
+
+    snort_free(ft->fragindex);
+    mem_in_use -= ft->fragindex_size * sizeof(*ft->fragindex);
+    ip_stats.mem_in_use = mem_in_use;
+
+    ft->fragindex = nullptr;
+    ft->fragindex_size = 0;
+}
+
+/**
+ * Stop indexing a FragTracker whose fraglist is no longer in offset order
+ *
+ * @param ft FragTracker to drop the index from
+ *
+ * @return none
+ */
+static void frag_index_drop(FragTracker* ft)
+{
+    frag_index_clear(ft);
+    ft->frag_flags |= FRAG_UNORDERED;
+}
+
+/**
+ * Refill the index from the fraglist, dropping it if the list is out of
+ * offset order
+ *
+ * @param ft FragTracker to reindex
+ *
+ * @return none
+ */
+static void frag_index_rebuild(FragTracker* ft)
+{
+    unsigned pos = 0;
+
+    for ( Fragment* f = ft->fraglist; f; f = f->next )
+    {
+        if ( pos == ft->fragindex_size or (f->prev and f->prev->offset > f->offset) )
+        {
+            frag_index_drop(ft);
+            return;
+        }
+        ft->fragindex[pos++] = f;
+    }
+}
+
+/**
+ * Find the position of an indexed Fragment
+ *
+ * A Fragment missing from the index means the index no longer mirrors the
+ * fraglist.  That must not happen; if it does the index is rebuilt from the
+ * list, or dropped if the list can't be indexed.
+ *
+ * @param ft FragTracker holding the Fragment, must not be FRAG_UNORDERED
+ * @param frag Fragment to locate
+ *
+ * @return index of frag; undefined if the index was dropped
+ */
+static unsigned frag_index_pos(FragTracker* ft, const Fragment* frag)
+{
+    unsigned count = ft->fraglist_count;
+    unsigned pos = frag_index_find(ft, frag->offset);
+
+    // duplicated nodes may share an offset
+    while ( pos < count and ft->fragindex[pos] != frag and
+        ft->fragindex[pos]->offset == frag->offset )
+        ++pos;
+
+    if ( pos < count and ft->fragindex[pos] == frag )
+        return pos;
+
+    assert(false);
+    frag_index_rebuild(ft);
+
+    if ( ft->frag_flags & FRAG_UNORDERED )
+        return count;
+
+    for ( pos = 0; pos < count and ft->fragindex[pos] != frag; ++pos )
+        ;
+
+    if ( pos == count )
+        frag_index_drop(ft);
+
+    return pos;
+}
+
+static void frag_index_insert(FragTracker* ft, unsigned pos, Fragment* frag)
+{
+    if ( ft->frag_flags & FRAG_UNORDERED )
+        return;
+
+    if ( (unsigned)ft->fraglist_count == ft->fragindex_size )
+    {
+        unsigned size = ft->fragindex_size ? 2 * ft->fragindex_size : FRAG_INDEX_MIN;
+        Fragment** index = (Fragment**)snort_alloc(size * sizeof(*index));
+
+        if ( ft->fragindex )
+        {
+            memcpy(index, ft->fragindex, ft->fraglist_count * sizeof(*index));
+            snort_free(ft->fragindex);
+        }
+        mem_in_use += (size - ft->fragindex_size) * sizeof(*index);
+        ip_stats.mem_in_use = mem_in_use;
+
+        ft->fragindex = index;
+        ft->fragindex_size = size;
+    }
+
+    memmove(ft->fragindex + pos + 1, ft->fragindex + pos,
+        (ft->fraglist_count - pos) * sizeof(*ft->fragindex));
+
+    ft->fragindex[pos] = frag;
+}
+
+static void frag_index_remove(FragTracker* ft, Fragment* frag)
+{
+    if ( ft->frag_flags & FRAG_UNORDERED )
+        return;
+
+    unsigned pos = frag_index_pos(ft, frag);
+
+    if ( ft->frag_flags & FRAG_UNORDERED )
+        return;
+
+    memmove(ft->fragindex + pos, ft->fragindex + pos + 1,
+        (ft->fraglist_count - pos - 1) * sizeof(*ft->fragindex));
+}
+
+/**
+ * Drop the index if a Fragment is out of offset order with its neighbors
+ *
+ * @param ft FragTracker holding the frag
+ * @param node node that was added or had its offset changed
+ *
+ * @return none
+ */
+static inline void frag_index_check(FragTracker* ft, const Fragment* node)
+{
+    if ( ft->frag_flags & FRAG_UNORDERED )
+        return;
+
+    if ( (node->prev and node->prev->offset > node->offset) or
+        (node->next and node->next->offset < node->offset) )
+        frag_index_drop(ft);
+}
+
 /**
  * Plug a Fragment into the fraglist of a FragTracker
  *
@@ -911,6 +1238,12 @@ static void FragRebuild(FragTracker* ft, Packet* p)
 static inline void add_node(FragTracker* ft, Fragment* prev,
     Fragment* node)
 {
+    if ( !(ft->frag_flags & FRAG_UNORDERED) )
+    {
+        unsigned pos = prev ? frag_index_pos(ft, prev) + 1 : 0;
+        frag_index_insert(ft, pos, node);
+    }
+
     if (prev)
     {
         node->next = prev->next;
@@ -932,6 +1265,7 @@ static inline void add_node(FragTracker* ft, Fragment* prev,
     }
 
     ft->fraglist_count++;
+    frag_index_check(ft, node);
 }
 
 /**
@@ -943,31 +1277,35 @@ static inline void add_node(FragTracker* ft, Fragment* prev,
  */
 static void delete_frag(Fragment* frag)
 {
-    /*
-     * delete the fragment either in prealloc or dynamic mode
-     */
-    snort_free(frag->fptr);
-    mem_in_use -= frag->flen;
-
-    snort_free(frag);
-    mem_in_use -= sizeof(Fragment);
+    // pooled blocks stay charged until the pool frees them
+    if ( frag->size_class != FRAG_POOL_NONE )
+    {
+        if ( frag_pool )
+            frag_pool->put(frag);
+        else
+            FragPool::free_block(frag);
+    }
+    else
+    {
+        mem_in_use -= sizeof(Fragment) + frag->flen;
+        snort_free(frag);
+    }
 
     ip_stats.mem_in_use = mem_in_use;
     ip_stats.nodes_released++;
 }
 
 /**
- * Delete a Fragment from a fraglist
+ * Take a Fragment out of a fraglist without freeing it
  *
- * @param ft FragTracker to delete the frag from
- * @param node node to be deleted
+ * @param ft FragTracker to take the frag from
+ * @param node node to be unlinked
  *
  * @return none
  */
-static inline void delete_node(FragTracker* ft, Fragment* node)
+static inline void unlink_node(FragTracker* ft, Fragment* node)
 {
-    trace_logf(stream_ip, "Deleting list node %p (p %p n %p)\n",
-        (void*) node, (void*) node->prev, (void*) node->next);
+    frag_index_remove(ft, node);
 
     if (node->prev)
     {
@@ -987,10 +1325,26 @@ static inline void delete_node(FragTracker* ft, Fragment* node)
         ft->fraglist_tail = node->prev;
     }
 
-    delete_frag(node);
     ft->fraglist_count--;
 }
 
+/**
+ * Delete a Fragment from a fraglist
+ *
+ * @param ft FragTracker to delete the frag from
+ * @param node node to be deleted
+ *
+ * @return none
+ */
+static inline void delete_node(FragTracker* ft, Fragment* node)
+{
+    trace_logf(stream_ip, "Deleting list node %p (p %p n %p)\n",
+        (void*) node, (void*) node->prev, (void*) node->next);
+
+    unlink_node(ft, node);
+    delete_frag(node);
+}
+
 /**
  * Delete the contents of a FragTracker, in this instance that just means to
  * dump the fraglist.
@@ -1017,6 +1371,11 @@ static void delete_tracker(FragTracker* ft)
         delete_frag(dump_me);
     }
     ft->fraglist = NULL;
+    ft->fraglist_tail = NULL;
+    ft->fraglist_count = 0;
+    frag_index_clear(ft);
+    ft->frag_flags &= ~FRAG_UNORDERED;
+
     if (ft->ip_options_data)
     {
         snort_free(ft->ip_options_data);
@@ -1049,17 +1408,27 @@ bool Defrag::configure(SnortConfig* sc)
 
 void Defrag::tinit()
 {
+    // rebuild directly into pseudo packets allocated up front so that
+    // nested fragments don't allocate on the packet path
     defrag_pkts = new Packet* [layers];
 
-    for (int i = 1; i < layers; i++)
-        defrag_pkts[i] = nullptr;
+    for (int i = 0; i < layers; i++)
+        defrag_pkts[i] = new Packet();
+
+    if ( !frag_pool )
+        frag_pool = new FragPool;
 
-    defrag_pkts[0] = new Packet();
     pkt_snaplen = SFDAQ::get_snap_len();
 }
 
 void Defrag::tterm()
 {
+    if ( frag_pool )
+    {
+        delete frag_pool;
+        frag_pool = nullptr;
+    }
+
     if (!defrag_pkts)
         return;
 
@@ -1309,7 +1678,6 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
     int16_t slide = 0;      /* slide up the front of the current frag */
     int done = 0;           /* flag for right-side overlap handling loop */
     int addthis = 1;           /* flag for right-side overlap handling loop */
-    int i = 0;              /* counter */
     int firstLastOk;
     int ret = FRAG_INSERT_OK;
     unsigned char lastfrag = 0; /* Set to 1 when this is the 'last' frag */
@@ -1317,7 +1685,6 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
     Fragment* right = NULL; /* frag ptr for right-side overlap loop */
     Fragment* newfrag = NULL;  /* new frag container */
     Fragment* left = NULL;     /* left-side overlap fragment ptr */
-    Fragment* idx = NULL;      /* indexing fragment pointer for loops */
     Fragment* dump_me = NULL;  /* frag ptr for complete overlaps to dump */
     const uint8_t* fragStart;
     int16_t fragLength;
@@ -1463,29 +1830,52 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
      * Need to figure out where in the frag list this frag should go
      * and who its neighbors are
      */
-    for (idx = ft->fraglist; idx; idx = idx->next)
+    if ( ft->frag_flags & FRAG_UNORDERED )
     {
-        i++;
-        right = idx;
+        Fragment* idx;
+        int i = 0;
 
-        trace_logf(stream_ip,
-            "%d right o %d s %d ptr %p prv %p nxt %p\n",
-            i, right->offset, right->size, (void*) right,
-            (void*) right->prev, (void*) right->next);
-
-        if (right->offset >= frag_offset)
+        for (idx = ft->fraglist; idx; idx = idx->next)
         {
-            break;
+            i++;
+            right = idx;
+
+            trace_logf(stream_ip,
+                "%d right o %d s %d ptr %p prv %p nxt %p\n",
+                i, right->offset, right->size, (void*) right,
+                (void*) right->prev, (void*) right->next);
+
+            if (right->offset >= frag_offset)
+            {
+                break;
+            }
+
+            left = right;
         }
 
-        left = right;
+        /*
+         * null things out if we walk to the end of the list
+         */
+        if (idx == NULL)
+            right = NULL;
     }
+    else
+    {
+        unsigned pos = frag_index_find(ft, frag_offset);
 
-    /*
-     * null things out if we walk to the end of the list
-     */
-    if (idx == NULL)
-        right = NULL;
+        if (pos > 0)
+            left = ft->fragindex[pos - 1];
+
+        if (pos < (unsigned)ft->fraglist_count)
+        {
+            right = ft->fragindex[pos];
+
+            trace_logf(stream_ip,
+                "%u right o %d s %d ptr %p prv %p nxt %p\n",
+                pos, right->offset, right->size, (void*) right,
+                (void*) right->prev, (void*) right->next);
+        }
+    }
 
     /*
      * handle forward (left-side) overlaps...
@@ -1613,6 +2003,7 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
                     right->size -= (frag_offset + len - left->offset);
                     right->data += (frag_offset + len - left->offset);
                     ft->frag_bytes -= (frag_offset + len - left->offset);
+                    frag_index_check(ft, right);
                 }
                 else
                 {
@@ -1759,6 +2150,8 @@ left_overlap_last:
 
                     delete_node(ft, dump_me);
                 }
+                else
+                    frag_index_check(ft, right);
                 break;
 
             /*
@@ -2083,15 +2476,7 @@ int Defrag::new_tracker(Packet* p, FragTracker* ft)
     /*
      * get our first fragment storage struct
      */
-    {
-        f = (Fragment*)snort_calloc(sizeof(Fragment));
-        mem_in_use += sizeof(Fragment);
-
-        f->fptr = (uint8_t*)snort_calloc(fragLength);
-        mem_in_use += fragLength;
-
-        ip_stats.mem_in_use = mem_in_use;
-    }
+    f = new_frag(fragLength);
 
     /* initialize the fragment list */
     ft->fraglist = NULL;
@@ -2101,7 +2486,7 @@ int Defrag::new_tracker(Packet* p, FragTracker* ft)
      */
     memcpy(f->fptr, fragStart, fragLength);
 
-    f->size = f->flen = fragLength;
+    f->size = fragLength;
     f->offset = frag_off;
     frag_end = f->offset + fragLength;
     f->ord = ft->ordinal++;
@@ -2136,9 +2521,7 @@ int Defrag::new_tracker(Packet* p, FragTracker* ft)
     }
 
     /* insert the fragment into the frag list */
-    ft->fraglist = f;
-    ft->fraglist_tail = f;
-    ft->fraglist_count = 1;  /* XXX: Are these duplicates? */
+    add_node(ft, NULL, f);
     ft->frag_pkts = 1;
 
     /*
@@ -2221,25 +2604,10 @@ int Defrag::add_frag_node(
     /*
      * grab/generate a new frag node
      */
-    {
-        /*
-         * build a frag struct to track this particular fragment
-         */
-        newfrag = (Fragment*)snort_calloc(sizeof(Fragment));
-        mem_in_use += sizeof(Fragment);
-
-        /*
-         * allocate some space to hold the actual data
-         */
-        newfrag->fptr = (uint8_t*)snort_calloc(fragLength);
-        mem_in_use += fragLength;
-
-        ip_stats.mem_in_use = mem_in_use;
-    }
+    newfrag = new_frag(fragLength);
 
     ip_stats.nodes_created++;
 
-    newfrag->flen = fragLength;
     memcpy(newfrag->fptr, fragStart, fragLength);
     newfrag->ord = ft->ordinal++;
 
@@ -2302,21 +2670,7 @@ int Defrag::dup_frag_node(
     /*
      * grab/generate a new frag node
      */
-    {
-        /*
-         * build a frag struct to track this particular fragment
-         */
-        newfrag = (Fragment*)snort_calloc(sizeof(Fragment));
-        mem_in_use += sizeof(Fragment);
-
-        /*
-         * allocate some space to hold the actual data
-         */
-        newfrag->fptr = (uint8_t*)snort_calloc(left->flen);
-        mem_in_use += left->flen;
-
-        ip_stats.mem_in_use = mem_in_use;
-    }
+    newfrag = new_frag(left->flen);
 
     ip_stats.nodes_created++;
 
@@ -2324,7 +2678,6 @@ int Defrag::dup_frag_node(
     /*
      * twiddle the frag values for overlaps
      */
-    newfrag->flen = left->flen;
     memcpy(newfrag->fptr, left->fptr, newfrag->flen);
     newfrag->data = newfrag->fptr + (left->data - left->fptr);
     newfrag->size = left->size;
@@ -2394,3 +2747,180 @@ inline int Defrag::expire(Packet*, FragTracker* ft, FragEngine* fe)
     return FRAG_OK;
 }
 
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+// place a node the way insert() does, before the first node at or beyond
+// its offset in list order
+static Fragment* test_add(FragTracker* ft, uint16_t offset)
+{
+    Fragment* left = nullptr;
+
+    for ( Fragment* f = ft->fraglist; f and f->offset < offset; f = f->next )
+        left = f;
+
+    if ( !(ft->frag_flags & FRAG_UNORDERED) )
+    {
+        unsigned pos = frag_index_find(ft, offset);
+        CHECK((pos ? ft->fragindex[pos - 1] : nullptr) == left);
+    }
+
+    Fragment* frag = new_frag(8);
+    frag->offset = offset;
+    frag->size = 8;
+    add_node(ft, left, frag);
+    return frag;
+}
+
+// the index must hold the fraglist in list order
+static bool test_index_ok(const FragTracker* ft)
+{
+    unsigned pos = 0;
+
+    for ( const Fragment* f = ft->fraglist; f; f = f->next, ++pos )
+    {
+        if ( pos >= ft->fragindex_size or ft->fragindex[pos] != f )
+            return false;
+
+        if ( f->prev and f->prev->offset > f->offset )
+            return false;
+    }
+    return pos == (unsigned)ft->fraglist_count;
+}
+
+static bool test_list_is(const FragTracker* ft, const std::vector<uint16_t>& offsets)
+{
+    std::vector<uint16_t> list;
+
+    for ( const Fragment* f = ft->fraglist; f; f = f->next )
+        list.push_back(f->offset);
+
+    return list == offsets;
+}
+
+TEST_CASE("frag index out of order", "[stream_ip]")
+{
+    FragTracker ft;
+    memset(&ft, 0, sizeof(ft));
+
+    test_add(&ft, 32);
+    test_add(&ft, 0);
+    test_add(&ft, 48);
+    Fragment* mid = test_add(&ft, 16);
+
+    CHECK(test_index_ok(&ft));
+    CHECK(test_list_is(&ft, { 0, 16, 32, 48 }));
+    CHECK(frag_index_find(&ft, 17) == 2);
+    CHECK(frag_index_find(&ft, 64) == 4);
+
+    delete_node(&ft, mid);
+    CHECK(test_index_ok(&ft));
+    CHECK(test_list_is(&ft, { 0, 32, 48 }));
+
+    delete_node(&ft, ft.fraglist_tail);
+    delete_node(&ft, ft.fraglist);
+    CHECK(test_index_ok(&ft));
+    CHECK(test_list_is(&ft, { 32 }));
+
+    delete_tracker(&ft);
+    CHECK(!ft.fragindex);
+}
+
+TEST_CASE("frag index duplicate offsets", "[stream_ip]")
+{
+    FragTracker ft;
+    memset(&ft, 0, sizeof(ft));
+
+    test_add(&ft, 0);
+    Fragment* a = test_add(&ft, 16);
+    Fragment* b = test_add(&ft, 16);
+    Fragment* c = test_add(&ft, 16);
+    test_add(&ft, 32);
+
+    // a duplicate goes in front of the nodes already at its offset
+    CHECK(ft.fragindex[1] == c);
+    CHECK(ft.fragindex[2] == b);
+    CHECK(ft.fragindex[3] == a);
+    CHECK(test_index_ok(&ft));
+
+    delete_node(&ft, b);
+    CHECK(test_index_ok(&ft));
+
+    delete_node(&ft, c);
+    delete_node(&ft, a);
+    CHECK(test_index_ok(&ft));
+    CHECK(test_list_is(&ft, { 0, 32 }));
+
+    delete_tracker(&ft);
+}
+
+TEST_CASE("frag index overlap trims", "[stream_ip]")
+{
+    FragTracker ft;
+    memset(&ft, 0, sizeof(ft));
+
+    test_add(&ft, 0);
+    Fragment* f8 = test_add(&ft, 8);
+    Fragment* f16 = test_add(&ft, 16);
+    test_add(&ft, 24);
+
+    SECTION("trim in order")
+    {
+        f8->offset = 12;
+        frag_index_check(&ft, f8);
+        CHECK(!(ft.frag_flags & FRAG_UNORDERED));
+        CHECK(test_index_ok(&ft));
+    }
+    SECTION("trim past successor")
+    {
+        // the list order is kept for reassembly and the index is dropped
+        f8->offset = 20;
+        frag_index_check(&ft, f8);
+        CHECK((ft.frag_flags & FRAG_UNORDERED));
+        CHECK(!ft.fragindex);
+        CHECK(test_list_is(&ft, { 0, 20, 16, 24 }));
+
+        test_add(&ft, 18);
+        CHECK(test_list_is(&ft, { 0, 18, 20, 16, 24 }));
+
+        delete_node(&ft, f16);
+        CHECK(test_list_is(&ft, { 0, 18, 20, 24 }));
+    }
+    SECTION("insert past successor")
+    {
+        Fragment* frag = new_frag(8);
+        frag->offset = 20;
+        add_node(&ft, f8, frag);
+        CHECK((ft.frag_flags & FRAG_UNORDERED));
+        CHECK(test_list_is(&ft, { 0, 8, 20, 16, 24 }));
+    }
+    delete_tracker(&ft);
+    CHECK(!(ft.frag_flags & FRAG_UNORDERED));
+}
+
+TEST_CASE("frag pool memory", "[stream_ip]")
+{
+    FragPool* save = frag_pool;
+    unsigned long base = mem_in_use;
+    frag_pool = new FragPool;
+
+    Fragment* frag = new_frag(100);
+    CHECK(mem_in_use == base + sizeof(Fragment) + 128);
+
+    // cached blocks stay charged until the pool frees them
+    delete_frag(frag);
+    CHECK(mem_in_use == base + sizeof(Fragment) + 128);
+
+    frag = new_frag(90);
+    CHECK(mem_in_use == base + sizeof(Fragment) + 128);
+    delete_frag(frag);
+
+    delete frag_pool;
+    frag_pool = save;
+    CHECK(mem_in_use == base);
+}
+
+#endif
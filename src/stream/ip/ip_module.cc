@@ -217,13 +217,11 @@ const PegInfo* StreamIpModule::get_pegs() const
 PegCount* StreamIpModule::get_counts() const
 { return (PegCount*)&ip_stats; }
 
-void StreamIpModule::sum_stats(bool accumulate_now_stats)
+const CountType* StreamIpModule::get_count_types() const
 {
     assert(sizeof(IpStats)/sizeof(PegCount) == sizeof(IpStatTypes)/sizeof(CountType));
 
     static const IpStatTypes ip_stat_types;
-    static const CountType* const count_types = (const CountType*)&ip_stat_types;
-
-    sum_stats_helper(accumulate_now_stats, count_types);
+    return (const CountType*)&ip_stat_types;
 }
 
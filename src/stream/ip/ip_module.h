@@ -138,7 +138,7 @@ public:
     ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
-    void sum_stats(bool) override;
+    const CountType* get_count_types() const override;
     StreamIpConfig* get_data();
 
     unsigned get_gid() const override
@@ -53,6 +53,9 @@ struct FragTracker
     Fragment* fraglist_tail; /* tail ptr for easy appending */
     int fraglist_count;       /* handy dandy counter */
 
+    Fragment** fragindex;     /* mirrors fraglist while it is in offset order */
+    unsigned fragindex_size;  /* allocated fragindex slots */
+
     uint32_t alert_gid[MAX_FRAG_ALERTS]; /* flag alerts seen in a frag list  */
     uint32_t alert_sid[MAX_FRAG_ALERTS]; /* flag alerts seen in a frag list  */
     uint8_t alert_count;                 /* count alerts seen in a frag list */
@@ -458,6 +458,21 @@ StreamSplitter* TcpStreamSession::get_splitter(bool to_server)
         return client->splitter;
 }
 
+// the switch is made by the session with the next segment for the tracker
+// since this may be called while the tracker is flushing
+void TcpStreamSession::set_header_only(bool to_server, StreamSplitter* ss)
+{
+    TcpStreamTracker* trk = ( to_server ) ? server : client;
+
+    if ( trk->header_only or trk->header_only_pending )
+    {
+        delete ss;
+        return;
+    }
+    trk->header_splitter = ss;
+    trk->header_only_pending = true;
+}
+
 void TcpStreamSession::start_proxy()
 {
     config->policy = StreamPolicy::OS_PROXY;
@@ -400,6 +400,12 @@ public:
     // manipulate within this module.
     PAF_State paf_state;    // for tracking protocol aware flushing
 
+    // header only mode, see Stream::set_header_only()
+    StreamSplitter* header_splitter = nullptr;
+    uint32_t header_seq = 0;  // next in order byte for header_splitter
+    bool header_only_pending = false;
+    bool header_only = false;
+
 protected:
     // FIXIT-H reorganize per-flow structs to minimize padding
     uint32_t ts_last_packet = 0;
@@ -231,6 +231,9 @@ void Stream::stop_inspection(
 
     /* FIXIT-M handle bytes/response parameters */
 
+    if ( flow->trust_reason == Flow::TrustReason::NONE )
+        flow->trust_reason = Flow::TrustReason::INSPECTOR;
+
     DisableInspection();
     flow->set_state(Flow::FlowState::ALLOW);
 }
@@ -489,6 +492,16 @@ void Stream::set_splitter(Flow* flow, bool to_server, StreamSplitter* ss)
     return flow->session->set_splitter(to_server, ss);
 }
 
+void Stream::set_header_only(Flow* flow, bool to_server, StreamSplitter* ss)
+{
+    assert(flow && flow->session);
+
+    if ( flow->pkt_type == PktType::TCP )
+        flow->session->set_header_only(to_server, ss);
+    else
+        delete ss;
+}
+
 StreamSplitter* Stream::get_splitter(Flow* flow, bool to_server)
 {
     assert(flow && flow->session);
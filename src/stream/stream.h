@@ -175,6 +175,12 @@ public:
     static StreamSplitter* get_splitter(Flow*, bool toServer);
     static bool is_paf_active(Flow*, bool toServer);
 
+    // Stop reassembly in one direction of a TCP flow once its queued data has been flushed.
+    // Payload is no longer queued; if given, the splitter's scan() sees in order data as it
+    // arrives so that record headers can be followed.  It is dropped when it returns ABORT or
+    // data is missing.  The splitter is owned by stream from here on.
+    static void set_header_only(Flow*, bool toServer, class StreamSplitter* = nullptr);
+
     // Turn off inspection for potential session. Adds session identifiers to a hash table.
     // TCP only.
     static int set_application_protocol_id_expected(
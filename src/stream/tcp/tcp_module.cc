@@ -64,6 +64,9 @@ const PegInfo tcp_pegs[] =
     { "gaps", "missing data between PDUs" },
     { "exceeded_max_segs", "number of times the maximum queued segment limit was reached" },
     { "exceeded_max_bytes", "number of times the maximum queued byte limit was reached" },
+    { "header_only", "directions switched to header only tracking" },
+    { "header_only_bytes", "payload bytes not queued in header only mode" },
+    { "header_only_gaps", "missing data ending header tracking in header only mode" },
     { "internal_events", "135:X events generated" },
     { "client_cleanups", "number of times data from server was flushed when session released" },
     { "server_cleanups", "number of times data from client was flushed when session released" },
@@ -365,13 +368,11 @@ const PegInfo* StreamTcpModule::get_pegs() const
 PegCount* StreamTcpModule::get_counts() const
 { return (PegCount*)&tcpStats; }
 
-void StreamTcpModule::sum_stats(bool accumulate_now_stats)
+const CountType* StreamTcpModule::get_count_types() const
 {
     assert(sizeof(TcpStats)/sizeof(PegCount) == sizeof(TcpStatTypes)/sizeof(CountType));
 
     static const TcpStatTypes tcp_stat_types;
-    static const CountType* const count_types = (const CountType*)&tcp_stat_types;
-
-    sum_stats_helper(accumulate_now_stats, count_types);
+    return (const CountType*)&tcp_stat_types;
 }
 
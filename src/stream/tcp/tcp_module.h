@@ -84,6 +84,9 @@ struct TcpStats
     PegCount gaps;
     PegCount exceeded_max_segs;
     PegCount exceeded_max_bytes;
+    PegCount header_only;
+    PegCount header_only_bytes;
+    PegCount header_only_gaps;
     PegCount internalEvents;
     PegCount s5tcp1;
     PegCount s5tcp2;
@@ -116,6 +119,9 @@ struct TcpStatTypes
     CountType gaps = CountType::SUM;
     CountType exceeded_max_segs = CountType::SUM;
     CountType exceeded_max_bytes = CountType::SUM;
+    CountType header_only = CountType::SUM;
+    CountType header_only_bytes = CountType::SUM;
+    CountType header_only_gaps = CountType::SUM;
     CountType internalEvents = CountType::SUM;
     CountType s5tcp1 = CountType::SUM;
     CountType s5tcp2 = CountType::SUM;
@@ -164,7 +170,7 @@ public:
     ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
-    void sum_stats(bool) override;
+    const CountType* get_count_types() const override;
 
 private:
     TcpStreamConfig* config;
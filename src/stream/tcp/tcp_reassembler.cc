@@ -825,6 +825,19 @@ void TcpReassembler::flush_queued_segments(Flow* flow, bool clear, Packet* p)
     }
 }
 
+// flush all in sequence data whether acked or not and return the sequence
+// number of the first byte that was not flushed
+uint32_t TcpReassembler::flush_sequenced(Packet* p)
+{
+    if ( tracker->splitter and seglist.head )
+    {
+        tracker->set_tf_flags(TF_FORCE_FLUSH);
+        flush_to_seq(get_q_sequenced(), p, packet_dir);
+        tracker->clear_tf_flags(TF_FORCE_FLUSH);
+    }
+    return seglist_base_seq;
+}
+
 // this is for post-ack flushing
 uint32_t TcpReassembler::get_reverse_packet_dir(const Packet* p)
 {
@@ -38,6 +38,7 @@ public:
     virtual int flush_stream(Packet* p, uint32_t dir);
     virtual int purge_flushed_ackd();
     virtual void flush_queued_segments(Flow* flow, bool clear, Packet* p = nullptr);
+    virtual uint32_t flush_sequenced(Packet*);
     virtual bool is_segment_pending_flush();
     virtual int flush_on_data_policy(Packet*);
     virtual int flush_on_ack_policy(Packet*);
@@ -325,6 +325,12 @@ void TcpSession::process_tcp_stream(TcpSegmentDescriptor& tsd)
 
     SetPacketHeaderFoo(tsd.get_pkt() );
 
+    if ( listener->header_only or listener->header_only_pending )
+    {
+        process_header_only(tsd);
+        return;
+    }
+
     if ( flow_exceeds_config_thresholds(tsd) )
         return;
 
@@ -339,6 +345,49 @@ void TcpSession::process_tcp_stream(TcpSegmentDescriptor& tsd)
         listener->reassembler->set_overlap_count(0);
     }
 }
+// in header only mode nothing more is queued.  the header splitter is given
+// in order payload directly and dropped when it can no longer follow.
+void TcpSession::process_header_only(TcpSegmentDescriptor& tsd)
+{
+    if ( listener->header_only_pending )
+    {
+        // queued data must go to the service inspector before the switch
+        listener->header_seq = listener->reassembler->flush_sequenced(tsd.get_pkt());
+        listener->header_only_pending = false;
+        listener->header_only = true;
+        tcpStats.header_only++;
+    }
+
+    uint32_t seq = tsd.get_seg_seq();
+    uint32_t len = tsd.get_seg_len();
+    StreamSplitter* ss = listener->header_splitter;
+
+    tcpStats.header_only_bytes += len;
+
+    if ( !ss or SEQ_LEQ(seq + len, listener->header_seq) )
+        return;
+
+    if ( SEQ_GT(seq, listener->header_seq) )
+    {
+        tcpStats.header_only_gaps++;
+        delete ss;
+        listener->header_splitter = nullptr;
+        return;
+    }
+
+    Packet* p = tsd.get_pkt();
+    uint32_t skip = listener->header_seq - seq;
+    uint32_t fp = 0;
+
+    if ( ss->scan(flow, p->data + skip, len - skip, p->packet_flags, &fp) ==
+        StreamSplitter::ABORT )
+    {
+        delete ss;
+        listener->header_splitter = nullptr;
+    }
+    listener->header_seq = seq + len;
+}
+
 void TcpSession::check_fin_transition_status(TcpSegmentDescriptor& tsd)
 {
     if((tsd.get_seg_len() != 0) &&
@@ -70,6 +70,7 @@ private:
     bool flow_exceeds_config_thresholds(TcpSegmentDescriptor&);
     void check_fin_transition_status(TcpSegmentDescriptor&);
     void process_tcp_stream(TcpSegmentDescriptor&);
+    void process_header_only(TcpSegmentDescriptor&);
     int process_tcp_data(TcpSegmentDescriptor&);
     void process_tcp_packet(TcpSegmentDescriptor&);
     void swap_trackers();
@@ -41,6 +41,7 @@ TcpTracker::TcpTracker(bool client, TcpSession* ssn) :
 TcpTracker::~TcpTracker()
 {
     delete splitter;
+    delete header_splitter;
     delete normalizer;
     delete reassembler;
 }
@@ -63,12 +64,16 @@ void TcpTracker::init_tcp_state(void )
     fin_seq_status = TcpStreamTracker::FIN_NOT_SEEN;
     fin_seq_set = false;
     rst_pkt_sent = false;
+    header_seq = 0;
+    header_only_pending = header_only = false;
 }
 
 void TcpTracker::init_toolbox()
 {
     delete splitter;
     splitter = nullptr;
+    delete header_splitter;
+    header_splitter = nullptr;
     delete normalizer;
     normalizer =  nullptr;
     delete reassembler;
@@ -197,6 +197,7 @@ const PegInfo pc_names[] =
     { "header_searches", "fast pattern searches in header buffer" },
     { "body_searches", "fast pattern searches in body buffer" },
     { "file_searches", "fast pattern searches in file buffer" },
+    { "offloads", "fast pattern searches split across offload threads" },
     { "alerts", "alerts not including IP reputation" },
     { "total_alerts", "alerts including IP reputation" },
     { "logged", "logged packets" },
@@ -0,0 +1,223 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// str_table.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "str_table.h"
+
+#include <cassert>
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+using namespace std;
+
+// seeds tried per table size and the largest table relative to the
+// number of names
+#define MAX_SEEDS 64
+#define MAX_SCALE 8
+
+StrTable::StrTable(bool nc)
+{
+    nocase = nc;
+    start.assign(2, 0);
+}
+
+void StrTable::add(const char* name, int32_t code)
+{
+    assert(name);
+
+    Entry e;
+    e.name = name;
+    e.len = strlen(name);
+    e.code = code;
+
+    for ( const auto& x : entries )
+    {
+        if ( x.len == e.len and equal(x.name, (const uint8_t*)name, e.len) )
+            return;
+    }
+    entries.push_back(e);
+
+    if ( entries.size() == 1 or e.len < min_len )
+        min_len = e.len;
+
+    if ( e.len > max_len )
+        max_len = e.len;
+}
+
+// returns the deepest slot with this seed and the current mask
+unsigned StrTable::build(uint32_t k, vector<unsigned>& slot) const
+{
+    vector<unsigned> count(mask + 1, 0);
+    unsigned most = 0;
+
+    for ( unsigned i = 0; i < entries.size(); ++i )
+    {
+        const Entry& e = entries[i];
+        slot[i] = hash((const uint8_t*)e.name, e.len, k);
+
+        if ( ++count[slot[i]] > most )
+            most = count[slot[i]];
+    }
+    return most;
+}
+
+void StrTable::finalize()
+{
+    unsigned n = entries.size();
+    unsigned size = 1;
+
+    while ( size < 2 * n )
+        size <<= 1;
+
+    vector<unsigned> slot(n);
+    unsigned best_depth = ~0u;
+    uint32_t best_mask = 0, best_seed = 0;
+
+    for ( ; size <= MAX_SCALE * n or size == 1; size <<= 1 )
+    {
+        mask = size - 1;
+
+        for ( uint32_t k = 1; k <= MAX_SEEDS; ++k )
+        {
+            unsigned d = build(k, slot);
+
+            if ( d < best_depth )
+            {
+                best_depth = d;
+                best_mask = mask;
+                best_seed = k;
+            }
+            if ( d <= 1 )
+                break;
+        }
+        if ( best_depth <= 1 )
+            break;
+    }
+
+    mask = best_mask;
+    seed = best_seed;
+    depth = n ? best_depth : 0;
+    build(seed, slot);
+
+    // counting sort by slot, keeping the order names were added
+    start.assign(mask + 2, 0);
+
+    for ( unsigned i = 0; i < n; ++i )
+        ++start[slot[i] + 1];
+
+    for ( unsigned h = 0; h <= mask; ++h )
+        start[h + 1] += start[h];
+
+    vector<Entry> sorted(n);
+    vector<uint16_t> next(start.begin(), start.end() - 1);
+
+    for ( unsigned i = 0; i < n; ++i )
+        sorted[next[slot[i]]++] = entries[i];
+
+    entries.swap(sorted);
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static const char* const methods[] =
+{
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE",
+    "PROPFIND", "PROPPATCH", "MKCOL", "COPY", "MOVE", "LOCK", "UNLOCK",
+    "VERSION-CONTROL", "REPORT", "CHECKOUT", "CHECKIN", "UNCHECKOUT",
+    "MKWORKSPACE", "UPDATE", "LABEL", "MERGE", "BASELINE-CONTROL",
+    "MKACTIVITY", "ORDERPATCH", "ACL", "PATCH", "SEARCH", "BCOPY",
+    "BDELETE", "BMOVE", "BPROPFIND", "BPROPPATCH", "NOTIFY", "POLL",
+    "SUBSCRIBE", "UNSUBSCRIBE", "X_MS_ENUMATTS", "BIND", "LINK",
+    "MKCALENDAR", "MKREDIRECTREF", "REBIND", "UNBIND", "UNLINK",
+    "UPDATEREDIRECTREF", nullptr
+};
+
+static int32_t find(const StrTable& t, const char* s)
+{ return t.find((const uint8_t*)s, strlen(s), -1); }
+
+TEST_CASE("str table empty", "[StrTable]")
+{
+    StrTable t;
+    t.finalize();
+    CHECK(find(t, "") == -1);
+    CHECK(find(t, "GET") == -1);
+}
+
+TEST_CASE("str table methods", "[StrTable]")
+{
+    StrTable t;
+
+    for ( int i = 0; methods[i]; ++i )
+        t.add(methods[i], i + 1);
+
+    t.finalize();
+    CHECK(t.get_max_depth() == 1);
+
+    for ( int i = 0; methods[i]; ++i )
+        CHECK(find(t, methods[i]) == i + 1);
+
+    CHECK(find(t, "get") == -1);
+    CHECK(find(t, "GETX") == -1);
+    CHECK(find(t, "GE") == -1);
+    CHECK(find(t, "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX") == -1);
+}
+
+TEST_CASE("str table nocase", "[StrTable]")
+{
+    StrTable t(true);
+    t.add("helo", 1);
+    t.add("ehlo", 2);
+    t.add("mail", 3);
+    t.add("MAIL", 4);  // duplicate, first wins
+    t.finalize();
+
+    CHECK(find(t, "HELO") == 1);
+    CHECK(find(t, "eHlO") == 2);
+    CHECK(find(t, "Mail") == 3);
+    CHECK(find(t, "rcpt") == -1);
+}
+
+TEST_CASE("str table collisions", "[StrTable]")
+{
+    // same length, first, middle and last octets so no seed separates them
+    StrTable t;
+    t.add("aXbYc", 1);
+    t.add("aZbWc", 2);
+    t.add("aQbRc", 3);
+    t.finalize();
+
+    CHECK(t.get_max_depth() == 3);
+    CHECK(find(t, "aXbYc") == 1);
+    CHECK(find(t, "aZbWc") == 2);
+    CHECK(find(t, "aQbRc") == 3);
+    CHECK(find(t, "aSbTc") == -1);
+}
+
+#endif
+
@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2017-2017 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// str_table.h
+
+#ifndef STR_TABLE_H
+#define STR_TABLE_H
+
+// StrTable maps a small, fixed set of names (methods, header names,
+// commands) to integer codes without searching the set.
+//
+// Names are added at startup and finalize() builds the index. The hash
+// looks only at the length and the first, middle and last octets, so it
+// is cheap compared to the memcmp that confirms a hit. finalize() tries
+// seeds and table sizes until every name has its own slot. If that fails
+// the best try is kept and the few names sharing a slot are compared in
+// turn, so a build never fails. If a name is added twice the first code
+// wins, the same as a linear search.
+//
+// The index is read only once built and may be shared by packet threads.
+
+#include <cstdint>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+#include "main/snort_types.h"
+
+class SO_PUBLIC StrTable
+{
+public:
+    StrTable(bool nocase = false);
+
+    void add(const char* name, int32_t code);
+    void finalize();
+
+    // returns the code of the name matching s or miss if none
+    int32_t find(const uint8_t* s, unsigned len, int32_t miss) const
+    {
+        if ( len < min_len or len > max_len )
+            return miss;
+
+        unsigned h = hash(s, len, seed);
+
+        for ( unsigned i = start[h]; i < start[h+1]; ++i )
+        {
+            const Entry& e = entries[i];
+
+            if ( e.len == len and equal(e.name, s, len) )
+                return e.code;
+        }
+        return miss;
+    }
+
+    unsigned get_slots() const
+    { return mask + 1; }
+
+    // most names sharing a slot; 1 is a perfect hash
+    unsigned get_max_depth() const
+    { return depth; }
+
+private:
+    struct Entry
+    {
+        const char* name;
+        unsigned len;
+        int32_t code;
+    };
+
+    uint8_t fold(uint8_t c) const
+    { return (nocase and c >= 'A' and c <= 'Z') ? c + ('a' - 'A') : c; }
+
+    bool equal(const char* name, const uint8_t* s, unsigned len) const
+    {
+        return nocase ? !strncasecmp(name, (const char*)s, len) :
+            !memcmp(name, s, len);
+    }
+
+    unsigned hash(const uint8_t* s, unsigned len, uint32_t k) const
+    {
+        uint32_t h = k ^ (len * 0x9E3779B1);
+
+        if ( len )
+        {
+            h = (h ^ fold(s[0])) * 0x01000193;
+            h = (h ^ fold(s[len/2])) * 0x01000193;
+            h = (h ^ fold(s[len-1])) * 0x01000193;
+        }
+        return (h ^ (h >> 15)) & mask;
+    }
+
+    unsigned build(uint32_t k, std::vector<unsigned>& slot) const;
+
+private:
+    std::vector<Entry> entries;     // grouped by slot once finalized
+    std::vector<uint16_t> start;    // first entry of each slot plus an end marker
+
+    uint32_t seed = 0;
+    uint32_t mask = 0;
+    unsigned depth = 0;
+    unsigned min_len = 1;
+    unsigned max_len = 0;
+    bool nocase;
+};
+
+#endif
+
@@ -29,6 +29,17 @@
 
 #include "main/thread.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <emmintrin.h>
+#define JSNORM_SIMD
+#endif
+
+#ifdef UNIT_TEST
+#include <string>
+
+#include "catch/catch.hpp"
+#endif
+
 #define INVALID_HEX_VAL -1
 #define MAX_BUF 8
 #define NON_ASCII_CHAR 0xff
@@ -183,8 +194,8 @@ typedef struct
 typedef struct
 {
     char* data;
-    uint16_t size;
-    uint16_t len;
+    uint32_t size;
+    uint32_t len;
 }Dbuf;
 
 typedef struct
@@ -194,7 +205,7 @@ typedef struct
     uint8_t prev_event;
     uint8_t d_quotes;
     uint8_t s_quotes;
-    uint16_t num_spaces;
+    uint32_t num_spaces;
     char* overwrite;
     Dbuf output;
 }PNormState;
@@ -213,7 +224,7 @@ typedef struct
 {
     uint8_t fsm;
     uint8_t prev_event;
-    uint16_t num_spaces;
+    uint32_t num_spaces;
     uint8_t* unicode_map;
     char* overwrite;
     Dbuf dest;
@@ -225,7 +236,7 @@ typedef struct
     uint8_t multiple_levels;
     uint8_t prev_event;
     uint16_t alert_flags;
-    uint16_t num_spaces;
+    uint32_t num_spaces;
     int iNorm;
     int paren_count;
     uint8_t* unicode_map;
@@ -442,9 +453,101 @@ static const JSNorm javascript_norm[] =
     { Z6+ 0, ANY, Z0+ 0, Z0+ 0, ACT_NOP }
 };
 
-static void UnescapeDecode(char*, uint16_t, char**, char**, uint16_t*, JSState*, uint8_t*);
+static void UnescapeDecode(char*, uint32_t, char**, char**, uint32_t*, JSState*, uint8_t*);
+
+// Each machine above is a list of entries chained through other on a
+// mismatch.  The chains are walked once at startup for every state and
+// (upper case) input byte so scanning takes one lookup per byte.  The tables
+// hold the index of the entry that matches; its fields are used as before.
+#define NUM_ENTRIES(norm) (sizeof(norm) / sizeof(norm[0]))
+
+static uint8_t sfcc_dfa[NUM_ENTRIES(sfcc_norm)][256];
+static uint8_t unescape_dfa[NUM_ENTRIES(unescape_norm)][256];
+static uint8_t plus_dfa[NUM_ENTRIES(plus_norm)][256];
+static uint8_t javascript_dfa[NUM_ENTRIES(javascript_norm)][256];
+
+// bytes copied as is by the javascript machine in its start state
+static bool javascript_plain[256];
+
+static void BuildDFA(const JSNorm* norm, unsigned num, uint8_t (* dfa)[256], bool indexed)
+{
+    for (unsigned state = 0; state < num; state++)
+    {
+        for (unsigned uc = 0; uc < 256; uc++)
+        {
+            // non-ascii bytes only match ANY
+            int value = (indexed && (uc < 0x80)) ? valid_chars[uc] : 0;
+            const JSNorm* m = norm + state;
+
+            while (m->event && ((uc >= 0x80) ||
+                ((m->event != uc) && !(value && ((m->event & value) == m->event)))))
+            {
+                m = norm + m->other;
+            }
+
+            dfa[state][uc] = m - norm;
+        }
+    }
+}
+
+void InitJSNormLookupTable()
+{
+    BuildDFA(sfcc_norm, NUM_ENTRIES(sfcc_norm), sfcc_dfa, true);
+    BuildDFA(unescape_norm, NUM_ENTRIES(unescape_norm), unescape_dfa, true);
+    BuildDFA(plus_norm, NUM_ENTRIES(plus_norm), plus_dfa, false);
+    BuildDFA(javascript_norm, NUM_ENTRIES(javascript_norm), javascript_dfa, false);
+
+    for (unsigned c = 0; c < 256; c++)
+    {
+        const JSNorm* m = javascript_norm + javascript_dfa[Z0][(uint8_t)toupper((char)c)];
+
+        javascript_plain[c] = !isspace((char)c) && (m->match == Z0) && (m->action == ACT_NOP);
+    }
+}
+
+// Returns the length of the leading run of bytes that the javascript machine
+// copies unchanged from its start state: anything but whitespace and the
+// first letters of the functions and tag it looks for.
+static uint32_t JSNormPlainRun(const char* src, uint32_t len)
+{
+    uint32_t n = 0;
+
+#ifdef JSNORM_SIMD
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i u = _mm_set1_epi8('U');
+    const __m128i s = _mm_set1_epi8('S');
+    const __m128i d = _mm_set1_epi8('D');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i ws = _mm_set1_epi8('\r' - '\t');
+
+    while (len - n >= 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(src + n));
+        const __m128i uv = _mm_andnot_si128(fold, v);
+        const __m128i t = _mm_sub_epi8(v, tab);
+
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(uv, u), _mm_cmpeq_epi8(uv, s));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(uv, d));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, lt));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, sp));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(t, ws), t));  // \t through \r
 
-void InitJSNormLookupTable() {}
+        const unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+
+        if (mask)
+            return n + __builtin_ctz(mask);
+
+        n += 16;
+    }
+#endif
+
+    while ((n < len) && javascript_plain[(uint8_t)src[n]])
+        n++;
+
+    return n;
+}
 
 static inline int outBounds(const char* start, const char* end, char* ptr)
 {
@@ -454,9 +557,9 @@ static inline int outBounds(const char* start, const char* end, char* ptr)
         return -1;
 }
 
-static inline void CheckWSExceeded(JSState* js, uint16_t* num_spaces)
+static inline void CheckWSExceeded(JSState* js, uint32_t* num_spaces)
 {
-    if (js->allowed_spaces && (*num_spaces > js->allowed_spaces))
+    if (js->allowed_spaces && (*num_spaces > (uint32_t)js->allowed_spaces))
     {
         js->alerts |= ALERT_SPACES_EXCEEDED;
     }
@@ -586,7 +689,6 @@ static int PNorm_exec(PNormState* s, ActionPNorm a, int c, JSState* js)
 static int PNorm_scan_fsm(PNormState* s, int c, JSState* js)
 {
     char uc;
-    const JSNorm* m = plus_norm + s->fsm;
 
     uc = toupper(c);
 
@@ -595,24 +697,14 @@ static int PNorm_scan_fsm(PNormState* s, int c, JSState* js)
         c = uc =' ';
     }
 
-    do
-    {
-        if ( !m->event ||  ( m->event == uc))
-        {
-            s->fsm = m->match;
-            s->fsm_other = m->other;
-            break;
-        }
-
-        s->fsm = m->other;
-        m = plus_norm + s->fsm;
-    }
-    while ( 1 );
+    const JSNorm* m = plus_norm + plus_dfa[s->fsm][(uint8_t)uc];
+    s->fsm = m->match;
+    s->fsm_other = m->other;
 
     return(PNorm_exec(s, (ActionPNorm)m->action, c, js));
 }
 
-static int PNormDecode(char* src, uint16_t srclen, char* dst, uint16_t dstlen, uint16_t* bytes_copied,
+static int PNormDecode(char* src, uint32_t srclen, char* dst, uint32_t dstlen, uint32_t* bytes_copied,
     JSState* js)
 {
     int iRet = RET_OK;
@@ -672,7 +764,7 @@ static void WriteDecodedSFCC(SFCCState* s)
 {
     char* start = s->output.data;
     char* end = s->output.data + s->output.size;
-    uint16_t len = s->output.len;
+    uint32_t len = s->output.len;
     char* ptr = s->output.data + len;
     int copy_len = 0;
 
@@ -768,38 +860,21 @@ static int SFCC_exec(SFCCState* s, ActionSFCC a, int c)
 
 static int SFCC_scan_fsm(SFCCState* s, int c)
 {
-    int indexed = 0;
-    int value = 0;
     int uc;
-    const JSNorm* m = sfcc_norm + s->fsm;
 
     uc = toupper(c);
 
     if (isspace(c))
         return (SFCC_exec(s, SFCC_ACT_SPACE, c));
 
-    value = valid_chars[uc];
-
-    if (value)
-        indexed = 1;
-
-    do
-    {
-        if ( !m->event || ((indexed && ((m->event & value) == m->event)) || ( m->event == uc)))
-        {
-            s->fsm = m->match;
-            break;
-        }
-        s->fsm = m->other;
-        m = sfcc_norm + s->fsm;
-    }
-    while ( 1 );
+    const JSNorm* m = sfcc_norm + sfcc_dfa[s->fsm][(uint8_t)uc];
+    s->fsm = m->match;
 
     return(SFCC_exec(s, (ActionSFCC)m->action, c));
 }
 
-static void StringFromCharCodeDecode(char* src, uint16_t srclen, char** ptr, char** dst,
-    uint16_t* bytes_copied, JSState* js, uint8_t* iis_unicode_map)
+static void StringFromCharCodeDecode(char* src, uint32_t srclen, char** ptr, char** dst,
+    uint32_t* bytes_copied, JSState* js, uint8_t* iis_unicode_map)
 {
     int iRet;
     const char* start, * end;
@@ -1027,10 +1102,7 @@ static int Unescape_exec(UnescapeState* s, ActionUnsc a, int c, JSState* js)
 
 static int Unescape_scan_fsm(UnescapeState* s, int c, JSState* js)
 {
-    int indexed = 0;
-    int value = 0;
     int uc;
-    const JSNorm* m = unescape_norm + s->fsm;
 
     uc = toupper(c);
 
@@ -1040,27 +1112,13 @@ static int Unescape_scan_fsm(UnescapeState* s, int c, JSState* js)
         return(Unescape_exec(s, UNESC_ACT_SPACE, c, js));
     }
 
-    value = valid_chars[uc];
-
-    if (value)
-        indexed = 1;
-
-    do
-    {
-        if ( !m->event || ( ( m->event == uc) || (indexed && ((m->event & value) == m->event))))
-        {
-            s->fsm = m->match;
-            break;
-        }
-        s->fsm = m->other;
-        m = unescape_norm + s->fsm;
-    }
-    while ( 1 );
+    const JSNorm* m = unescape_norm + unescape_dfa[s->fsm][(uint8_t)uc];
+    s->fsm = m->match;
 
     return(Unescape_exec(s, (ActionUnsc)m->action, c, js));
 }
 
-static void UnescapeDecode(char* src, uint16_t srclen, char** ptr, char** dst, uint16_t* bytes_copied,
+static void UnescapeDecode(char* src, uint32_t srclen, char** ptr, char** dst, uint32_t* bytes_copied,
     JSState* js, uint8_t* iis_unicode_map)
 {
     int iRet;
@@ -1135,7 +1193,7 @@ static inline void WriteJSNormChar(JSNormState* s, int c, JSState* js)
     s->dest.len = dptr - dstart;
 }
 
-static void WriteJSNorm(JSNormState* s, char* copy_buf, uint16_t copy_len, JSState* js)
+static void WriteJSNorm(JSNormState* s, char* copy_buf, uint32_t copy_len, JSState* js)
 {
     const char* end, * dstart, * dend;
     char* ptr, * dptr;
@@ -1162,12 +1220,12 @@ static void WriteJSNorm(JSNormState* s, char* copy_buf, uint16_t copy_len, JSSta
     s->dest.len = dptr - dstart;
 }
 
-static int JSNorm_exec(JSNormState* s, ActionJSNorm a, int c, char* src, uint16_t srclen,
+static int JSNorm_exec(JSNormState* s, ActionJSNorm a, int c, char* src, uint32_t srclen,
     char** ptr, JSState* js)
 {
     char* cur_ptr;
     int iRet = RET_OK;
-    uint16_t bcopied = 0;
+    uint32_t bcopied = 0;
     char* dest;
     cur_ptr = s->dest.data+ s->dest.len;
     switch (a)
@@ -1215,11 +1273,10 @@ static int JSNorm_exec(JSNormState* s, ActionJSNorm a, int c, char* src, uint16_
     return iRet;
 }
 
-static int JSNorm_scan_fsm(JSNormState* s, int c, char* src, uint16_t srclen, char** ptr,
+static int JSNorm_scan_fsm(JSNormState* s, int c, char* src, uint32_t srclen, char** ptr,
     JSState* js)
 {
     char uc;
-    const JSNorm* m = javascript_norm + s->fsm;
 
     uc = toupper(c);
 
@@ -1229,22 +1286,13 @@ static int JSNorm_scan_fsm(JSNormState* s, int c, char* src, uint16_t srclen, ch
         return(JSNorm_exec(s, ACT_SPACE, c, src, srclen, ptr, js));
     }
 
-    do
-    {
-        if (!m->event || (m->event == uc))
-        {
-            s->fsm = m->match;
-            break;
-        }
-        s->fsm = m->other;
-        m = javascript_norm + s->fsm;
-    }
-    while ( 1 );
+    const JSNorm* m = javascript_norm + javascript_dfa[s->fsm][(uint8_t)uc];
+    s->fsm = m->match;
 
     return(JSNorm_exec(s, (ActionJSNorm)m->action, c, src, srclen, ptr, js));
 }
 
-int JSNormalizeDecode(char* src, uint16_t srclen, char* dst, uint16_t destlen, char** ptr,
+int JSNormalizeDecode(char* src, uint32_t srclen, char* dst, uint32_t destlen, char** ptr,
     int* bytes_copied, JSState* js, uint8_t* iis_unicode_map)
 {
     int iRet = RET_OK;
@@ -1270,6 +1318,20 @@ int JSNormalizeDecode(char* src, uint16_t srclen, char* dst, uint16_t destlen, c
 
     while (!outBounds(start, end, *ptr))
     {
+        if (s.fsm == Z0)
+        {
+            // most of a script is copied as is
+            uint32_t run = JSNormPlainRun(*ptr, end - *ptr);
+
+            if (run)
+            {
+                WriteJSNorm(&s, *ptr, run, js);
+                s.prev_event = (*ptr)[run - 1];
+                *ptr += run;
+                continue;
+            }
+        }
+
         iRet = JSNorm_scan_fsm(&s, **ptr, src, srclen, ptr, js);
         if (iRet != RET_OK)
         {
@@ -1339,3 +1401,234 @@ int main(int argc, char *argv[])
 
 }*/
 
+
+#ifdef UNIT_TEST
+
+static std::string normalize(const std::string& in, JSState& js, uint32_t* used = nullptr)
+{
+    std::string src = in;
+    std::string out(in.size(), '\0');
+    char* ptr = &src[0];
+    int copied = 0;
+
+    InitJSNormLookupTable();
+    JSNormalizeDecode(&src[0], src.size(), &out[0], out.size(), &ptr, &copied, &js, nullptr);
+
+    if ( used )
+        *used = ptr - &src[0];
+
+    return out.substr(0, copied);
+}
+
+TEST_CASE("jsnorm decode", "[jsnorm]")
+{
+    JSState js = { 3, MAX_ALLOWED_OBFUSCATION, 0 };
+    uint32_t used = 0;
+
+    CHECK(normalize("x = unescape('%48%65%6c%6c%6f'); </script> rest", js, &used) ==
+        "x = 'Hello'; </script>");
+    CHECK(used == 42);
+    CHECK(js.alerts == 0);
+
+    CHECK(normalize("String.fromCharCode(72, 0x69, 041)", js) == "Hi!");
+    CHECK(js.alerts == ALERT_MIXED_ENCODINGS);
+
+    js.alerts = 0;
+    CHECK(normalize("unescape(unescape('%2541'))", js) == "unescape('%41')");
+    CHECK(js.alerts == ALERT_LEVELS_EXCEEDED);
+
+    js.alerts = 0;
+    CHECK(normalize("a    b", js) == "a b");
+    CHECK(js.alerts == ALERT_SPACES_EXCEEDED);
+}
+
+// scripts longer than 64K are normalized to the end
+TEST_CASE("jsnorm long script", "[jsnorm]")
+{
+    JSState js = { 200, MAX_ALLOWED_OBFUSCATION, 0 };
+    std::string in, expected;
+
+    while ( in.size() < 100000 )
+    {
+        in += "var x  =  document.getElementById('id');\n";
+        expected += "var x = document.getElementById('id'); ";
+    }
+    in += "y = unescape('%41');";
+    expected += "y = 'A';";
+
+    uint32_t used = 0;
+    CHECK(normalize(in, js, &used) == expected);
+    CHECK(used == in.size());
+    CHECK(js.alerts == 0);
+}
+
+// golden results from the chain walking normalizer this replaced, with
+// 3 allowed spaces and 1 allowed level; a destlen of 0 is the input size
+struct JSGolden
+{
+    const char* in;
+    uint32_t destlen;
+    const char* out;
+    uint32_t used;
+    uint16_t alerts;
+};
+
+static const JSGolden golden[] =
+{
+    { "document.write(unescape('%3Cscript%3E'));", 0,
+      "document.write('<script>');", 41, 0 },
+    { "unescape(\"%u0048%u0069\")", 0,
+      "\"Hi\"", 24, 0 },
+    { "UNESCAPE ( '%41%42' + '%43' )", 0,
+      " 'ABC' ", 29, 0 },
+    { "decodeURIComponent('%41')", 0,
+      "'A'", 25, 0 },
+    { "decodeURI('\\x41\\X42')", 0,
+      "'AB'", 21, 0 },
+    { "String.fromCharCode(0x41,66,0103)", 0,
+      "ABC", 33, 4 },
+    { "string.FROMcharcode( 72 , 105 )", 0,
+      "Hi", 31, 0 },
+    { "String.fromCharCode(65, 0x42, 9999)", 0,
+      "AB\017", 35, 4 },
+    { "unescape(String.fromCharCode(37, 52, 49))", 0,
+      "String.fromCharCode(37, 52, 49)", 41, 2 },
+    { "unescape(unescape(unescape('%25%32%35')))", 0,
+      "unescape(unescape('%25'))", 41, 2 },
+    { "'a' + 'b' + \"c\"", 0,
+      "'a' + 'b' + \"c\"", 15, 0 },
+    { "x = 'abc' + \n 'def';", 0,
+      "x = 'abc' + 'def';", 20, 0 },
+    { "a\t\t\tb\n\n\nc", 0,
+      "a b c", 9, 0 },
+    { "unescape('%zz%4')", 0,
+      "'%zz%4'", 17, 0 },
+    { "unescape('%u12')", 0,
+      "'%u12'", 16, 0 },
+    { "unescape('\\u0041\\x42%43')", 0,
+      "'ABC'", 25, 4 },
+    { "x = 1; </SCRIPT > y = 2;", 0,
+      "x = 1; </SCRIPT >", 17, 0 },
+    { "x = 1; </scrip y = 2; </script>", 0,
+      "x = 1; </scrip y = 2; </script>", 31, 0 },
+    { "                                        ", 0,
+      " ", 40, 0 },
+    { "", 0,
+      "", 0, 0 },
+    { "unescape('%41%42%43%44%45%46')", 5,
+      "'ABCD", 30, 0 },
+    { "var longer_than_the_output = 1;", 10,
+      "var longer", 31, 0 },
+    { "k\tqqqqqqqqqffk  aString.fromCharCode(9<", 0,
+      "k qqqqqqqqqffk a <", 39, 0 },
+    { "string.FROMcharcode(%4", 0,
+      "%4", 22, 0 },
+    { "</SCRIPT >65u%4%u1234\\X4ff(#\\ff", 0,
+      "</SCRIPT >", 10, 0 },
+    { "String.fromCharCode(  %41%", 0,
+      "%41%", 26, 0 },
+    { "%U12)</script>\t", 0,
+      "%U12)</script>", 14, 0 },
+    { "%4/</script>x0x\\u12ffz99%U12\\X4</unescape(String.fromCharCode(", 12,
+      "%4/</script>", 12, 0 },
+    { "%0xea\\x41a\\u12ff", 0,
+      "%0xea\\x41a\\u12ff", 16, 0 },
+    { "\nu\tqqqqqe+\\u12ffz\\X4>\tx,</script>c012", 0,
+      " u qqqqqe+\\u12ffz\\X4> x,</script>", 33, 0 },
+    { "012<<0xB</SCRIPT ></script>ff", 0,
+      "012<<0xB</SCRIPT >", 18, 0 },
+    { "\t</SCRIPT >~String.fromCharCode(qqqqqqqqqqqqqqqqqqqqeD%41qqqqqq", 0,
+      " </SCRIPT >", 11, 0 },
+    { "e", 0,
+      "e", 1, 0 },
+    { "qqqqqqqqqqqqqqqqqq)", 12,
+      "qqqqqqqqqqqq", 19, 0 },
+    { "</script>9ff", 0,
+      "</script>", 9, 0 },
+    { "(\\x41qqqqqqqqqqqqqqqqqqqqqqqq@012", 0,
+      "(\\x41qqqqqqqqqqqqqqqqqqqqqqqq@012", 33, 0 },
+    { "9qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqI'ff", 0,
+      "9qqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqqI'ff", 43, 0 },
+    { "%41%4string.FROMcharcode(b\\u0041%d", 0,
+      "%41%4b\\u0041%d", 34, 0 },
+    { "012.\n</script>%a65", 0,
+      "012. </script>", 14, 0 },
+    { "s012,'qqqqqqqqqqqqqq`0x65\\X4eString.fromCharCode(a077077a", 12,
+      "s012,'qqqqqq", 57, 0 },
+    { "uz077\\X4077/!o", 0,
+      "uz077\\X4077/!o", 14, 0 },
+    { "", 0,
+      "", 0, 0 },
+    { "</SCRIPT >String.fromCharCode(x0X1f077string.FROMcharcode(d'B%41", 0,
+      "</SCRIPT >", 10, 0 },
+    { "/qqqqqqqqqqqqqqqqqqqqqqdd", 0,
+      "/qqqqqqqqqqqqqqqqqqqqqqdd", 25, 0 },
+    { "9d\\u12ff.'zb9(a9\\x41\n", 0,
+      "9d\\u12ff.'zb9(a9\\x41 ", 21, 0 },
+    { "(</SCRIPT >qqqqqqqqqK9", 12,
+      "(</SCRIPT >", 11, 0 },
+};
+
+TEST_CASE("jsnorm golden", "[jsnorm]")
+{
+    InitJSNormLookupTable();
+
+    for ( const auto& g : golden )
+    {
+        std::string src = g.in;
+        std::string out(g.destlen ? g.destlen : src.size(), '\0');
+        JSState js = { 3, MAX_ALLOWED_OBFUSCATION, 0 };
+        char* ptr = &src[0];
+        int copied = 0;
+
+        INFO(g.in);
+        JSNormalizeDecode(&src[0], src.size(), &out[0], out.size(), &ptr, &copied, &js, nullptr);
+
+        CHECK(out.substr(0, copied) == g.out);
+        CHECK((uint32_t)(ptr - &src[0]) == g.used);
+        CHECK(js.alerts == g.alerts);
+    }
+}
+
+// the tables must give what walking the chains does
+static unsigned walk(const JSNorm* norm, unsigned state, int c, bool indexed)
+{
+    int uc = toupper(c);
+    int value = (indexed && (uc >= 0) && (uc < 0x80)) ? valid_chars[uc] : 0;
+    const JSNorm* m = norm + state;
+
+    while ( m->event && (m->event != uc) && !(value && ((m->event & value) == m->event)) )
+        m = norm + m->other;
+
+    return m - norm;
+}
+
+TEST_CASE("jsnorm tables", "[jsnorm]")
+{
+    InitJSNormLookupTable();
+
+    for ( int c = -128; c < 128; c++ )
+    {
+        uint8_t uc = (uint8_t)toupper(c);
+
+        for ( unsigned state = 0; state < NUM_ENTRIES(sfcc_norm); state++ )
+            CHECK(sfcc_dfa[state][uc] == walk(sfcc_norm, state, c, true));
+
+        for ( unsigned state = 0; state < NUM_ENTRIES(unescape_norm); state++ )
+            CHECK(unescape_dfa[state][uc] == walk(unescape_norm, state, c, true));
+
+        for ( unsigned state = 0; state < NUM_ENTRIES(plus_norm); state++ )
+            CHECK(plus_dfa[state][uc] == walk(plus_norm, state, c, false));
+
+        for ( unsigned state = 0; state < NUM_ENTRIES(javascript_norm); state++ )
+            CHECK(javascript_dfa[state][uc] == walk(javascript_norm, state, c, false));
+
+        // vector and byte runs agree
+        std::string run(40, (char)c);
+        CHECK(JSNormPlainRun(run.c_str(), run.size()) ==
+            (javascript_plain[(uint8_t)c] ? run.size() : 0));
+    }
+}
+
+#endif
+
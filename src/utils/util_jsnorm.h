@@ -40,10 +40,11 @@ typedef struct
 
 void keep_jsnorm_lib();  // FIXIT-L eliminate; required to keep symbols for dyn plugins
 
+// builds the state tables; call once at startup
 SO_PUBLIC void InitJSNormLookupTable();
 
 SO_PUBLIC int JSNormalizeDecode(
-    char*, uint16_t, char*, uint16_t destlen, char**, int*, JSState*, uint8_t*);
+    char*, uint32_t, char*, uint32_t destlen, char**, int*, JSState*, uint8_t*);
 
 #endif
 
@@ -24,6 +24,13 @@
 
 #include "util_unfold.h"
 
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <emmintrin.h>
+#define UNFOLD_SIMD
+#endif
+
 /* Given a string, removes header folding (\r\n followed by linear whitespace)
  * and exits when the end of a header is found, defined as \n followed by a
  * non-whitespace.  This is especially helpful for HTML.
@@ -103,6 +110,34 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
 
 /* Strips the CRLF from the input buffer */
 
+// length of the leading run without CR or LF
+static uint32_t line_run(const uint8_t* buf, uint32_t len)
+{
+    uint32_t n = 0;
+
+#ifdef UNFOLD_SIMD
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    while ( len - n >= 16 )
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(buf + n));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+
+        if ( mask )
+            return n + __builtin_ctz(mask);
+
+        n += 16;
+    }
+#endif
+
+    while ( (n < len) && (buf[n] != '\n') && (buf[n] != '\r') )
+        n++;
+
+    return n;
+}
+
 int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     uint32_t outbuf_size, uint32_t* output_bytes)
 {
@@ -118,12 +153,19 @@ int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
-        if ((*cursor != '\n') && (*cursor != '\r'))
-        {
-            *outbuf_ptr++ = *cursor;
-            n++;
-        }
-        cursor++;
+        uint32_t run = line_run(cursor, endofinbuf - cursor);
+
+        if (run > outbuf_size - n)
+            run = outbuf_size - n;
+
+        memcpy(outbuf_ptr, cursor, run);
+        outbuf_ptr += run;
+        cursor += run;
+        n += run;
+
+        /* skip the CR or LF */
+        if ((cursor < endofinbuf) && (n < outbuf_size))
+            cursor++;
     }
 
     if (output_bytes)